@@ -39,6 +39,9 @@ public:
     // len determines length of output buffer (default: length of input)
     uint32_t* uncompress(uint32_t len=0) const;
 
+    // decodes into a caller owned buffer that can hold at least `getLength()` elements
+    void uncompress_into(uint32_t* out) const;
+
     uint32_t getSizeInBytes();
 
     uint32_t getLength() const;
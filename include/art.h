@@ -10,6 +10,10 @@
 
 #define IGNORE_PRINTF 1
 
+class art_allocator_t;
+struct art_topk_cache_t;
+class ThreadPool;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -21,6 +25,24 @@ extern "C" {
 
 #define MAX_PREFIX_LEN 8
 
+#define ART_SEARCH_BATCH_WIDTH 8
+
+// By default, prefixes up to this length keep their top completions cached (0 disables the cache)
+#define ART_TOPK_CACHE_MAX_PREFIX_LEN 2
+#define ART_TOPK_CACHE_MIN_SIZE 32
+#define ART_TOPK_CACHE_MAX_SIZE 512
+
+// Each bit of a node summary stands for blocks of 2^ART_ID_SUMMARY_BLOCK_BITS consecutive IDs (wrapping around
+// every 64 blocks), so that filters over clustered IDs set few bits
+#define ART_ID_SUMMARY_BLOCK_BITS 10
+
+// Filters whose IDs set more bits of a node summary than this are not selective enough to prune subtrees with
+#define ART_ID_SUMMARY_MAX_FILTER_BITS 48
+
+// Batch inserts with fewer keys than this are not worth spreading across threads
+#define ART_PARALLEL_INSERT_MIN_KEYS 1024
+#define ART_PARALLEL_INSERT_CONCURRENCY 4
+
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 
 #if defined(__GNUC__) && !defined(__clang__)
@@ -46,6 +68,8 @@ typedef struct {
     uint8_t partial_len;
     unsigned char partial[MAX_PREFIX_LEN];
     int64_t max_score;
+    // one bit per block of IDs of the documents beneath the node (bits of removed documents linger until compaction)
+    uint64_t id_summary;
 } art_node;
 
 /**
@@ -101,6 +125,7 @@ typedef struct {
     uint32_t key_len;
     int64_t max_score;
     void* values;
+    uint64_t id_summary;
     unsigned char key[];
 } art_leaf;
 
@@ -110,6 +135,9 @@ typedef struct {
 typedef struct {
     art_node *root;
     uint64_t size;
+    art_allocator_t* allocator;
+    size_t compacted_bytes_reserved;    // bytes reserved right after the last compaction
+    art_topk_cache_t* topk_cache;
 } art_tree;
 
 /*
@@ -127,6 +155,15 @@ struct art_document {
     }
 };
 
+/*
+ * A key of a batch insert, along with the documents to add to it.
+ */
+struct art_key_documents {
+    const unsigned char *key;
+    int key_len;
+    std::vector<art_document>* documents;
+};
+
 enum token_ordering {
     NOT_SET,
 
@@ -171,6 +208,38 @@ int art_tree_destroy(art_tree *t);
  */
 #define destroy_art_tree(...) art_tree_destroy(__VA_ARGS__)
 
+/**
+ * Sets the longest prefix for which top completions are cached (0 disables the cache).
+ */
+void art_set_topk_cache_prefix_len(art_tree *t, size_t max_prefix_len);
+
+/**
+ * Re-ranks a leaf in the cached completions after its posting list was modified outside of the tree.
+ */
+void art_topk_update(art_tree *t, art_leaf *l);
+
+/**
+ * Returns the number of bytes held by the nodes and leaves of the tree (posting lists are not included).
+ */
+size_t art_bytes_in_use(const art_tree *t);
+
+/**
+ * Returns the number of bytes reserved by the allocator of the tree.
+ */
+size_t art_bytes_reserved(const art_tree *t);
+
+/**
+ * Relocates all nodes and leaves of the tree into freshly packed slabs and releases the old ones.
+ * Pointers to nodes and leaves obtained before compaction are invalidated.
+ */
+void art_compact(art_tree *t);
+
+/**
+ * Returns true when the allocator of the tree reserves much more memory than what is in use, and has grown well
+ * past what it reserved after the last compaction.
+ */
+bool art_is_fragmented(const art_tree *t);
+
 /**
  * Returns the size of the ART tree.
  */
@@ -197,6 +266,14 @@ void* art_insert(art_tree *t, const unsigned char *key, int key_len, art_documen
 void* art_inserts(art_tree *t, const unsigned char *key, int key_len, const int64_t docs_max_score,
                   std::vector<art_document>& documents);
 
+/**
+ * Inserts the documents of many keys. Keys with different first bytes go under different children of the
+ * root, so once the root has a child for every first byte of the batch, the groups of keys are inserted
+ * concurrently on `thread_pool` (which may be null to insert serially).
+ */
+void art_inserts_batch(art_tree *t, std::vector<art_key_documents>& keys, const int64_t docs_max_score,
+                       ThreadPool* thread_pool);
+
 /**
  * Deletes a value from the ART tree
  * @arg t The tree
@@ -217,6 +294,13 @@ void* art_delete(art_tree *t, const unsigned char *key, int key_len);
  */
 void* art_search(const art_tree *t, const unsigned char *key, int key_len);
 
+/**
+ * Searches for many keys at once, interleaving the traversals of up to `ART_SEARCH_BATCH_WIDTH` keys.
+ * `leaves[i]` is set to the leaf of `keys[i]`, or NULL if the key was not found.
+ */
+void art_search_batch(const art_tree *t, const unsigned char* const* keys, const int* key_lens, size_t num_keys,
+                      art_leaf** leaves);
+
 /**
  * Returns the minimum valued leaf
  * @return The minimum leaf or NULL
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/**
+ * Slab allocator for the nodes and leaves of a single ART tree.
+ *
+ * Every node type and every leaf size (rounded up to `LEAF_SIZE_STEP`) is a size class that carves objects out of
+ * slabs and recycles freed objects through an intrusive free list. The first slab of a class holds only
+ * `MIN_SLAB_SLOTS` objects and every further slab doubles in size up to `MAX_SLAB_SIZE`, so that small trees stay
+ * small. Leaves with very long keys are allocated individually. Allocations are serialized by a lock, so that
+ * disjoint subtrees of the owning tree can be written concurrently.
+ */
+class art_allocator_t {
+public:
+    static constexpr size_t MIN_SLAB_SLOTS = 8;
+    static constexpr size_t MAX_SLAB_SIZE = 64 * 1024;
+    static constexpr size_t LEAF_SIZE_STEP = 8;
+    static constexpr size_t MAX_SLAB_LEAF_SIZE = 256;
+
+private:
+    struct free_slot_t {
+        free_slot_t* next;
+    };
+
+    struct size_class_t {
+        size_t slot_size = 0;
+        free_slot_t* free_list = nullptr;
+        char* bump = nullptr;
+        char* bump_end = nullptr;
+        size_t next_slab_size = 0;
+    };
+
+    // node4, node16, node48, node256 followed by leaf classes
+    static constexpr size_t NUM_NODE_CLASSES = 4;
+    static constexpr size_t NUM_LEAF_CLASSES = MAX_SLAB_LEAF_SIZE / LEAF_SIZE_STEP;
+
+    size_class_t classes[NUM_NODE_CLASSES + NUM_LEAF_CLASSES];
+    std::vector<char*> slabs;
+
+    size_t num_bytes_in_use = 0;
+    size_t num_slab_bytes = 0;
+    size_t num_large_bytes = 0;
+
+    mutable std::mutex mutex;
+
+    void* alloc_slot(size_class_t& size_class);
+
+    void free_slot(size_class_t& size_class, void* ptr);
+
+    size_class_t& node_class(uint8_t type);
+
+public:
+
+    art_allocator_t();
+
+    ~art_allocator_t();
+
+    art_allocator_t(const art_allocator_t&) = delete;
+
+    art_allocator_t& operator=(const art_allocator_t&) = delete;
+
+    // returns a zeroed node of the given type (NODE4 .. NODE256)
+    void* alloc_node(uint8_t type);
+
+    void free_node(void* node, uint8_t type);
+
+    // returns uninitialized memory for a leaf whose key is `key_len` bytes long
+    void* alloc_leaf(uint32_t key_len);
+
+    void free_leaf(void* leaf, uint32_t key_len);
+
+    // bytes held by live nodes and leaves
+    size_t bytes_in_use() const;
+
+    // bytes obtained from the system, including free slots and unused slab space
+    size_t bytes_reserved() const;
+};
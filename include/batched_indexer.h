@@ -8,6 +8,17 @@
 #include "http_server.h"
 
 class BatchedIndexer {
+public:
+    // Per collection view of the write backlog, used to throttle writes to collections that the indexer lags on
+    struct write_stats_t {
+        int64_t queued_writes = 0;      // complete requests that are yet to be indexed
+        int64_t pending_bytes = 0;      // size of the request chunks held in the store
+        int64_t indexed_writes = 0;     // requests indexed since the throughput was last updated
+        int64_t indexed_bytes = 0;      // size of the chunks indexed since the throughput was last updated
+        double writes_per_second = 0;
+        double bytes_per_second = 0;
+    };
+
 private:
     struct req_res_t {
         uint64_t start_ts;
@@ -20,6 +31,8 @@ private:
         uint32_t next_chunk_index;   // index where next read must begin
         bool is_complete;           //  whether the req has been written to store fully
 
+        int64_t pending_bytes = 0;  // size of the chunks in the store that are yet to be indexed
+
         req_res_t(uint64_t start_ts, const std::string& prev_req_body,
                   const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res,
                   uint64_t last_updated, uint32_t num_chunks, uint32_t next_chunk_index, bool is_complete):
@@ -58,6 +71,12 @@ private:
 
     std::chrono::high_resolution_clock::time_point last_gc_run;
 
+    std::mutex write_stats_mutex;
+    std::unordered_map<std::string, write_stats_t> write_stats;
+    std::chrono::high_resolution_clock::time_point last_write_stats_run;
+
+    static const size_t MAX_RETRY_AFTER_SECONDS = 60;
+
     std::atomic<bool> quit;
     std::shared_mutex pause_mutex;
 
@@ -67,11 +86,32 @@ private:
     rocksdb::Iterator* skip_index_iter = nullptr;
     static constexpr const char* SKIP_INDICES_PREFIX = "$XP";
 
+    // A crash while coalesced writes are applied cannot be pinned on one of them, so their log index range is
+    // saved instead: writes up to the end of that range are then applied one by one, and only the write that
+    // crashes again gets skipped
+    std::atomic<int64_t> uncoalesced_log_index = 0;
+    static constexpr const char* COALESCED_INDICES_PREFIX = "$XC";
+
     static const size_t GC_INTERVAL_SECONDS = 60;
     static const size_t GC_PRUNE_MAX_SECONDS = 3600;
 
+    // Single document writes that queue up behind one another are coalesced and indexed as one batch: while
+    // more writes are queued, the worker waits up to the window for further writes to join the batch.
+    static const size_t MAX_COALESCED_WRITES = 64;
+    static const size_t COALESCE_WINDOW_MICROS = 2000;
+
     static std::string get_req_prefix_key(uint64_t req_id);
 
+    // whether `req_id` is a complete single document write that can be indexed along with `batch_req_id`
+    bool is_coalescable_write(uint64_t req_id, uint64_t batch_req_id);
+
+    void index_coalesced_writes(const std::vector<uint64_t>& req_ids);
+
+    void update_write_stats(const std::shared_ptr<http_req>& req, int64_t queued_writes, int64_t pending_bytes,
+                            int64_t indexed_writes, int64_t indexed_bytes);
+
+    void update_write_throughput();
+
 public:
 
     static const constexpr char* RAFT_REQ_LOG_PREFIX = "$RL_";
@@ -84,12 +124,23 @@ public:
 
     int64_t get_queued_writes();
 
+    // when writes to the collection must be held back, sets the number of seconds after which they can be retried
+    bool is_write_admitted(const std::string& coll_name, uint32_t& retry_after_seconds);
+
+    // time taken at the current pace to work the exceeded backlogs down to half of their thresholds
+    static uint32_t get_retry_after_seconds(const write_stats_t& stats, int64_t max_queued_writes,
+                                            int64_t max_pending_bytes);
+
+    void get_write_stats(nlohmann::json& stats);
+
     void run();
 
     void stop();
 
     void populate_skip_index();
 
+    void populate_uncoalesced_index();
+
     void persist_applying_index();
 
     void clear_skip_indices();
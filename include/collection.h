@@ -8,6 +8,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <shared_mutex>
+#include <regex>
 #include <art.h>
 #include <index.h>
 #include <number.h>
@@ -127,6 +128,9 @@ private:
 
     const uint8_t CURATED_RECORD_IDENTIFIER = 100;
 
+    // number of documents of an import that are parsed by a single task of the thread pool
+    static constexpr size_t PARSE_BATCH_SIZE = 100;
+
     struct highlight_t {
         std::string field;
         std::vector<std::string> snippets;
@@ -178,6 +182,18 @@ private:
 
     std::vector<field> dynamic_fields;
 
+    // compiled lazily, in the order of `dynamic_fields`
+    std::vector<std::regex> dynamic_field_regexes;
+
+    // document keys that are known to not be indexed: they need not be matched against dynamic fields again.
+    // Cleared whenever the schema or the dynamic fields change, since a key could then be indexed.
+    spp::sparse_hash_set<std::string> non_indexed_keys;
+
+    static const size_t MAX_NON_INDEXED_KEYS = 1000;
+
+    // compiled from `search_schema` whenever it changes
+    validation_plan_t validation_plan;
+
     std::vector<char> symbols_to_index;
 
     std::vector<char> token_separators;
@@ -316,6 +332,16 @@ public:
                                 const DIRTY_VALUES dirty_values,
                                 const std::string& id="");
 
+    // parses a JSON document: safe to call concurrently since it does not touch the collection
+    static Option<bool> parse_doc(const std::string& json_str, nlohmann::json& document);
+
+    // parses a stored document for rebuilding the in-memory index: only the values of indexed fields are kept
+    Option<bool> parse_doc_for_indexing(const char* json, size_t size, nlohmann::json& document) const;
+
+    // resolves (or assigns) the sequence ID of a parsed document: must be called in the order of the documents
+    Option<doc_seq_id_t> get_doc_seq_id(nlohmann::json& document, const index_operation_t& operation,
+                                        const std::string& id="");
+
     static uint32_t get_seq_id_from_key(const std::string & key);
 
     Option<bool> get_document_from_store(const std::string & seq_id_key, nlohmann::json & document) const;
@@ -355,7 +381,13 @@ public:
 
     nlohmann::json add_many(std::vector<std::string>& json_lines, nlohmann::json& document,
                             const index_operation_t& operation=CREATE, const std::string& id="",
-                            const DIRTY_VALUES& dirty_values=DIRTY_VALUES::COERCE_OR_REJECT);
+                            const DIRTY_VALUES& dirty_values=DIRTY_VALUES::COERCE_OR_REJECT,
+                            std::vector<nlohmann::json>* documents=nullptr);
+
+    // adds independent documents in a single batch, with an outcome for every document in the order given
+    void add_batch(std::vector<std::string>& json_strs, std::vector<Option<nlohmann::json>>& results,
+                   const index_operation_t& operation=CREATE,
+                   const DIRTY_VALUES& dirty_values=DIRTY_VALUES::COERCE_OR_REJECT);
 
     Option<nlohmann::json> search(const std::string & query, const std::vector<std::string> & search_fields,
                                   const std::string & simple_filter_query, const std::vector<std::string> & facet_fields,
@@ -391,6 +423,10 @@ public:
     Option<bool> get_filter_ids(const std::string & simple_filter_query,
                                 std::vector<std::pair<size_t, uint32_t*>>& index_ids);
 
+    // completions of `query` from the values of a field that is indexed with `suggest` enabled
+    Option<nlohmann::json> suggest(const std::string& field_name, const std::string& query,
+                                   size_t num_typos = 0, size_t limit = 10) const;
+
     Option<nlohmann::json> get(const std::string & id) const;
 
     Option<std::string> remove(const std::string & id, bool remove_from_store = true);
@@ -37,6 +37,9 @@ private:
     std::atomic<size_t> healthy_read_lag;
     std::atomic<size_t> healthy_write_lag;
 
+    std::atomic<size_t> collection_write_lag;
+    std::atomic<size_t> collection_pending_write_bytes;
+
     std::string config_file;
     int config_file_validity;
 
@@ -47,6 +50,11 @@ private:
 
     uint32_t thread_pool_size;
 
+    bool enable_forward_index;
+
+    // longest prefix whose top completions are cached by the token trees: 0 disables the cache
+    uint32_t topk_cache_prefix_len;
+
 protected:
 
     Config() {
@@ -58,10 +66,14 @@ protected:
         this->snapshot_interval_seconds = 3600;
         this->healthy_read_lag = 1000;
         this->healthy_write_lag = 500;
+        this->collection_write_lag = 250;
+        this->collection_pending_write_bytes = 512 * 1024 * 1024;
         this->log_slow_requests_time_ms = -1;
         this->num_collections_parallel_load = 0;  // will be set dynamically if not overridden
         this->num_documents_parallel_load = 1000;
         this->thread_pool_size = 0; // will be set dynamically if not overridden
+        this->enable_forward_index = false;
+        this->topk_cache_prefix_len = 2;
         this->ssl_refresh_interval_seconds = 8 * 60 * 60;
     }
 
@@ -121,6 +133,14 @@ public:
         this->enable_cors = enable_cors;
     }
 
+    void set_enable_forward_index(bool enable_forward_index) {
+        this->enable_forward_index = enable_forward_index;
+    }
+
+    void set_topk_cache_prefix_len(uint32_t topk_cache_prefix_len) {
+        this->topk_cache_prefix_len = topk_cache_prefix_len;
+    }
+
     void set_log_slow_requests_time_ms(int log_slow_requests_time_ms) {
         this->log_slow_requests_time_ms = log_slow_requests_time_ms;
     }
@@ -133,6 +153,14 @@ public:
         this->healthy_write_lag = healthy_write_lag;
     }
 
+    void set_collection_write_lag(size_t collection_write_lag) {
+        this->collection_write_lag = collection_write_lag;
+    }
+
+    void set_collection_pending_write_bytes(size_t collection_pending_write_bytes) {
+        this->collection_pending_write_bytes = collection_pending_write_bytes;
+    }
+
     // getters
 
     std::string get_data_dir() const {
@@ -208,6 +236,14 @@ public:
         return this->healthy_write_lag;
     }
 
+    size_t get_collection_write_lag() const {
+        return this->collection_write_lag;
+    }
+
+    size_t get_collection_pending_write_bytes() const {
+        return this->collection_pending_write_bytes;
+    }
+
     int get_log_slow_requests_time_ms() const {
         return this->log_slow_requests_time_ms;
     }
@@ -228,6 +264,14 @@ public:
         return this->ssl_refresh_interval_seconds;
     }
 
+    bool get_enable_forward_index() const {
+        return this->enable_forward_index;
+    }
+
+    size_t get_topk_cache_prefix_len() const {
+        return this->topk_cache_prefix_len;
+    }
+
     // loaders
 
     std::string get_env(const char *name) {
@@ -280,6 +324,16 @@ public:
         StringUtils::toupper(enable_cors_str);
         this->enable_cors = ("TRUE" == enable_cors_str) ? true : false;
 
+        if(!get_env("TYPESENSE_ENABLE_FORWARD_INDEX").empty()) {
+            std::string enable_forward_index_str = get_env("TYPESENSE_ENABLE_FORWARD_INDEX");
+            StringUtils::toupper(enable_forward_index_str);
+            this->enable_forward_index = ("TRUE" == enable_forward_index_str);
+        }
+
+        if(!get_env("TYPESENSE_TOPK_CACHE_PREFIX_LEN").empty()) {
+            this->topk_cache_prefix_len = std::stoi(get_env("TYPESENSE_TOPK_CACHE_PREFIX_LEN"));
+        }
+
         if(!get_env("TYPESENSE_MAX_MEMORY_RATIO").empty()) {
             this->max_memory_ratio = std::stof(get_env("TYPESENSE_MAX_MEMORY_RATIO"));
         }
@@ -296,6 +350,14 @@ public:
             this->healthy_write_lag = std::stoi(get_env("TYPESENSE_HEALTHY_WRITE_LAG"));
         }
 
+        if(!get_env("TYPESENSE_COLLECTION_WRITE_LAG").empty()) {
+            this->collection_write_lag = std::stoi(get_env("TYPESENSE_COLLECTION_WRITE_LAG"));
+        }
+
+        if(!get_env("TYPESENSE_COLLECTION_PENDING_WRITE_BYTES").empty()) {
+            this->collection_pending_write_bytes = std::stoull(get_env("TYPESENSE_COLLECTION_PENDING_WRITE_BYTES"));
+        }
+
         if(!get_env("TYPESENSE_LOG_SLOW_REQUESTS_TIME_MS").empty()) {
             this->log_slow_requests_time_ms = std::stoi(get_env("TYPESENSE_LOG_SLOW_REQUESTS_TIME_MS"));
         }
@@ -385,6 +447,14 @@ public:
             this->enable_cors = reader.GetBoolean("server", "enable-cors", false);
         }
 
+        if(reader.Exists("server", "enable-forward-index")) {
+            this->enable_forward_index = reader.GetBoolean("server", "enable-forward-index", false);
+        }
+
+        if(reader.Exists("server", "topk-cache-prefix-len")) {
+            this->topk_cache_prefix_len = (int) reader.GetInteger("server", "topk-cache-prefix-len", 2);
+        }
+
         if(reader.Exists("server", "peering-address")) {
             this->peering_address = reader.Get("server", "peering-address", "");
         }
@@ -413,6 +483,15 @@ public:
             this->healthy_write_lag = (size_t) reader.GetInteger("server", "healthy-write-lag", 100);
         }
 
+        if(reader.Exists("server", "collection-write-lag")) {
+            this->collection_write_lag = (size_t) reader.GetInteger("server", "collection-write-lag", 250);
+        }
+
+        if(reader.Exists("server", "collection-pending-write-bytes")) {
+            this->collection_pending_write_bytes = (size_t) reader.GetInteger("server", "collection-pending-write-bytes",
+                                                                              512 * 1024 * 1024);
+        }
+
         if(reader.Exists("server", "log-slow-requests-time-ms")) {
             this->log_slow_requests_time_ms = (int) reader.GetInteger("server", "log-slow-requests-time-ms", -1);
         }
@@ -484,6 +563,14 @@ public:
             this->enable_cors = options.exist("enable-cors");
         }
 
+        if(options.exist("enable-forward-index")) {
+            this->enable_forward_index = options.exist("enable-forward-index");
+        }
+
+        if(options.exist("topk-cache-prefix-len")) {
+            this->topk_cache_prefix_len = options.get<uint32_t>("topk-cache-prefix-len");
+        }
+
         if(options.exist("peering-address")) {
             this->peering_address = options.get<std::string>("peering-address");
         }
@@ -512,6 +599,14 @@ public:
             this->healthy_write_lag = options.get<size_t>("healthy-write-lag");
         }
 
+        if(options.exist("collection-write-lag")) {
+            this->collection_write_lag = options.get<size_t>("collection-write-lag");
+        }
+
+        if(options.exist("collection-pending-write-bytes")) {
+            this->collection_pending_write_bytes = options.get<size_t>("collection-pending-write-bytes");
+        }
+
         if(options.exist("log-slow-requests-time-ms")) {
             this->log_slow_requests_time_ms = options.get<int>("log-slow-requests-time-ms");
         }
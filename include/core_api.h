@@ -21,10 +21,16 @@ bool get_search(const std::shared_ptr<http_req>& req, const std::shared_ptr<http
 
 bool post_multi_search(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
+bool get_suggest(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
+
 bool get_export_documents(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
 bool post_add_document(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
+// Single document writes to the same collection with the same parameters, indexed as one batch
+bool post_add_documents(const std::vector<std::shared_ptr<http_req>>& reqs,
+                        const std::vector<std::shared_ptr<http_res>>& ress);
+
 bool patch_update_document(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
 
 bool post_import_documents(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res);
@@ -38,6 +38,9 @@ namespace fields {
     static const std::string optional = "optional";
     static const std::string index = "index";
     static const std::string locale = "locale";
+    static const std::string positions = "positions";
+    static const std::string suggest = "suggest";
+    static const std::string infix = "infix";
 }
 
 struct field {
@@ -49,9 +52,21 @@ struct field {
 
     std::string locale;
 
+    // when false, only the documents of a token are indexed (without token positions): such fields are ranked
+    // without phrase proximity and cannot be filtered on with exact match (`:=` or `:!=`) filters
+    bool positions;
+
+    // when true, the values of the field are also kept as weighted phrases for query suggestions
+    bool suggest;
+
+    // when true, tokens of the field are also found by any infix of atleast 3 characters (e.g. SKUs or part numbers)
+    bool infix;
+
     field(const std::string &name, const std::string &type, const bool facet, const bool optional = false,
-          bool index = true, std::string locale = "") :
-            name(name), type(type), facet(facet), optional(optional), index(index), locale(locale) {
+          bool index = true, std::string locale = "", bool positions = true, bool suggest = false,
+          bool infix = false) :
+            name(name), type(type), facet(facet), optional(optional), index(index), locale(locale),
+            positions(positions), suggest(suggest), infix(infix) {
 
     }
 
@@ -211,6 +226,9 @@ struct field {
             field_val[fields::optional] = field.optional;
 
             field_val[fields::locale] = field.locale;
+            field_val[fields::positions] = field.positions;
+            field_val[fields::suggest] = field.suggest;
+            field_val[fields::infix] = field.infix;
 
             fields_json.push_back(field_val);
 
@@ -299,6 +317,44 @@ struct field {
                                          field_json[fields::name].get<std::string>() + std::string("` should be a boolean."));
             }
 
+            if(field_json.count(fields::positions) != 0 && !field_json.at(fields::positions).is_boolean()) {
+                return Option<bool>(400, std::string("The `positions` property of the field `") +
+                                         field_json[fields::name].get<std::string>() + std::string("` should be a boolean."));
+            }
+
+            if(field_json.count(fields::suggest) != 0 && !field_json.at(fields::suggest).is_boolean()) {
+                return Option<bool>(400, std::string("The `suggest` property of the field `") +
+                                         field_json[fields::name].get<std::string>() + std::string("` should be a boolean."));
+            }
+
+            if(field_json.count(fields::infix) != 0 && !field_json.at(fields::infix).is_boolean()) {
+                return Option<bool>(400, std::string("The `infix` property of the field `") +
+                                         field_json[fields::name].get<std::string>() + std::string("` should be a boolean."));
+            }
+
+            // auto detected fields are allowed too, since their values could turn out to be strings
+            const std::string& field_type = field_json[fields::type].get<std::string>();
+            const bool holds_strings = (field_type == field_types::STRING || field_type == field_types::STRING_ARRAY ||
+                                        field_type == field_types::AUTO || field_types::is_string_or_array(field_type));
+
+            if(!holds_strings && field_json.count(fields::positions) != 0 && !field_json[fields::positions].get<bool>()) {
+                return Option<bool>(400, std::string("The `positions` property of the field `") +
+                                         field_json[fields::name].get<std::string>() +
+                                         std::string("` can only be disabled on a string field."));
+            }
+
+            if(!holds_strings && field_json.count(fields::suggest) != 0 && field_json[fields::suggest].get<bool>()) {
+                return Option<bool>(400, std::string("The `suggest` property of the field `") +
+                                         field_json[fields::name].get<std::string>() +
+                                         std::string("` can only be enabled on a string field."));
+            }
+
+            if(!holds_strings && field_json.count(fields::infix) != 0 && field_json[fields::infix].get<bool>()) {
+                return Option<bool>(400, std::string("The `infix` property of the field `") +
+                                         field_json[fields::name].get<std::string>() +
+                                         std::string("` can only be enabled on a string field."));
+            }
+
             if(field_json.count(fields::locale) != 0){
                 if(!field_json.at(fields::locale).is_string()) {
                     return Option<bool>(400, std::string("The `locale` property of the field `") +
@@ -330,6 +386,18 @@ struct field {
                     field_json[fields::locale] = "";
                 }
 
+                if(field_json.count(fields::positions) == 0) {
+                    field_json[fields::positions] = true;
+                }
+
+                if(field_json.count(fields::suggest) == 0) {
+                    field_json[fields::suggest] = false;
+                }
+
+                if(field_json.count(fields::infix) == 0) {
+                    field_json[fields::infix] = false;
+                }
+
                 if(field_json[fields::optional] == false) {
                     return Option<bool>(400, "Field `.*` must be an optional field.");
                 }
@@ -343,7 +411,9 @@ struct field {
                 }
 
                 field fallback_field(field_json["name"], field_json["type"], field_json["facet"],
-                                     field_json["optional"], field_json[fields::index], field_json[fields::locale]);
+                                     field_json["optional"], field_json[fields::index], field_json[fields::locale],
+                                     field_json[fields::positions], field_json[fields::suggest],
+                                     field_json[fields::infix]);
 
                 if(fallback_field.has_valid_type()) {
                     fallback_field_type = fallback_field.type;
@@ -368,6 +438,18 @@ struct field {
                 field_json[fields::locale] = "";
             }
 
+            if(field_json.count(fields::positions) == 0) {
+                field_json[fields::positions] = true;
+            }
+
+            if(field_json.count(fields::suggest) == 0) {
+                field_json[fields::suggest] = false;
+            }
+
+            if(field_json.count(fields::infix) == 0) {
+                field_json[fields::infix] = false;
+            }
+
             if(field_json.count(fields::optional) == 0) {
                 // dynamic fields are always optional
                 bool is_dynamic = field::is_dynamic(field_json[fields::name], field_json[fields::type]);
@@ -376,7 +458,8 @@ struct field {
 
             fields.emplace_back(
                 field(field_json[fields::name], field_json[fields::type], field_json[fields::facet],
-                      field_json[fields::optional], field_json[fields::index], field_json[fields::locale])
+                      field_json[fields::optional], field_json[fields::index], field_json[fields::locale],
+                      field_json[fields::positions], field_json[fields::suggest], field_json[fields::infix])
             );
         }
 
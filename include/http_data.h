@@ -419,6 +419,11 @@ struct route_path {
             }
         }
 
+        // suggestions are a read-only search over the collection's documents
+        if(resource == "documents" && operation == "suggest") {
+            return "documents:search";
+        }
+
         return resource + ":" + operation;
     }
 };
@@ -311,4 +311,6 @@ public:
     void persist_applying_index();
 
     int64_t get_num_queued_writes();
+
+    void get_write_stats(nlohmann::json& stats);
 };
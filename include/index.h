@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -21,6 +22,9 @@
 #include "match_score.h"
 #include "posting_list.h"
 #include "threadpool.h"
+#include "suggestion_index.h"
+#include "infix_index.h"
+#include "tokenizer.h"
 
 static constexpr size_t ARRAY_FACET_DIM = 4;
 using facet_map_t = spp::sparse_hash_map<uint32_t, facet_hash_values_t>;
@@ -334,6 +338,20 @@ enum index_operation_t {
     DELETE
 };
 
+// Source of the score of a sort slot, resolved once per query so that the scoring kernel can be specialized on it
+enum class sort_slot_t : uint8_t {
+    NONE,
+    TEXT_MATCH,
+    SEQ_ID,
+    GEO,
+    VALUE,
+    DYNAMIC     // slot kind is read from the per-query slot kinds (generic kernel)
+};
+
+// Tag type used to select a `score_results` specialization
+template<sort_slot_t S0, sort_slot_t S1, sort_slot_t S2, bool grouping>
+struct score_kernel_t {};
+
 enum class DIRTY_VALUES {
     REJECT = 1,
     DROP = 2,
@@ -346,6 +364,15 @@ struct offsets_facet_hashes_t {
     std::vector<uint64_t> facet_hashes;
 };
 
+// non-empty tokens of a string value, with their token index, and the facet hash of the value
+struct tokenized_value_t {
+    std::vector<std::pair<std::string, uint32_t>> tokens;
+    uint64_t facet_hash = 0;
+};
+
+// field name => string value => its tokens: values that repeat within a batch are tokenized only once
+typedef std::unordered_map<std::string, std::unordered_map<std::string, tokenized_value_t>> tokenization_cache_t;
+
 struct index_record {
     size_t position;                    // position of record in the original request
     uint32_t seq_id;
@@ -366,9 +393,9 @@ struct index_record {
 
     DIRTY_VALUES dirty_values;
 
-    index_record(size_t record_pos, uint32_t seq_id, const nlohmann::json& doc, index_operation_t operation,
+    index_record(size_t record_pos, uint32_t seq_id, nlohmann::json doc, index_operation_t operation,
                  const DIRTY_VALUES& dirty_values):
-            position(record_pos), seq_id(seq_id), doc(doc), operation(operation), is_update(false),
+            position(record_pos), seq_id(seq_id), doc(std::move(doc)), operation(operation), is_update(false),
             indexed(false), dirty_values(dirty_values) {
 
     }
@@ -386,6 +413,33 @@ struct index_record {
     }
 };
 
+// The schema compiled into the checks that a document goes through before it is indexed. The plan is rebuilt
+// whenever the schema changes, so that validating a document does not look up fields or compare type names.
+struct validation_plan_t {
+    // whether a value (an element, for array fields) is of the type of the field
+    typedef bool (*type_check_t)(const nlohmann::json& value);
+
+    // coerces a value that is not of the type of the field, or drops or rejects it
+    typedef Option<uint32_t> (*coercer_t)(const DIRTY_VALUES& dirty_values, const std::string& fallback_field_type,
+                                          const field& a_field, nlohmann::json& document,
+                                          const std::string& field_name, nlohmann::json::iterator& array_iter,
+                                          bool is_array, bool& array_ele_erased);
+
+    struct field_check_t {
+        field a_field;
+        bool is_array;
+        type_check_t is_valid;          // null when the values of the field are not checked
+        coercer_t coerce;
+
+        explicit field_check_t(const field& a_field): a_field(a_field), is_array(a_field.is_array()),
+                                                      is_valid(nullptr), coerce(nullptr) {
+
+        }
+    };
+
+    std::vector<field_check_t> field_checks;
+};
+
 class Index {
 private:
     mutable std::shared_mutex mutex;
@@ -424,18 +478,29 @@ private:
     // this is used for wildcard queries
     sorted_array seq_ids;
 
+    // field => bytes of token offsets that were not stored because the field is indexed without positions
+    spp::sparse_hash_map<std::string, size_t> skipped_position_bytes;
+
+    // field => seq_id => share of a document in `skipped_position_bytes`, taken out when the document goes away
+    spp::sparse_hash_map<std::string, spp::sparse_hash_map<uint32_t, uint32_t>> doc_skipped_position_bytes;
+    mutable std::mutex skipped_position_bytes_mutex;
+
+    // field => phrases of the field's values weighted by the number of documents they occur in
+    spp::sparse_hash_map<std::string, suggestion_index_t*> suggestion_index;
+
+    // field => n-grams of the field's tokens for infix search
+    spp::sparse_hash_map<std::string, infix_index_t*> infix_index;
+
+    // string field => (seq_id => the document's tokens, each terminated by a \0): only kept when the forward index
+    // is enabled, so that documents can be removed without tokenizing their values again
+    spp::sparse_hash_map<std::string, spp::sparse_hash_map<uint32_t, std::string>*> forward_index;
+
     std::vector<char> symbols_to_index;
 
     std::vector<char> token_separators;
 
     StringUtils string_utils;
 
-    // used as sentinels
-
-    static spp::sparse_hash_map<uint32_t, int64_t> text_match_sentinel_value;
-    static spp::sparse_hash_map<uint32_t, int64_t> seq_id_sentinel_value;
-    static spp::sparse_hash_map<uint32_t, int64_t> geo_sentinel_value;
-
     // Internal utility functions
 
     static inline uint32_t next_suggestion(const std::vector<token_candidates> &token_candidates_vec,
@@ -447,6 +512,12 @@ private:
 
     void log_leaves(int cost, const std::string &token, const std::vector<art_leaf *> &leaves) const;
 
+    // moves the tokens of a document's field out of the forward index: false when they are not available
+    bool get_forward_index_tokens(const std::string& field_name, uint32_t seq_id, std::vector<std::string>& tokens);
+
+    // takes the share of a removed document out of the skipped position bytes of a field
+    void remove_skipped_position_bytes(const std::string& field_name, uint32_t seq_id);
+
     void do_facets(std::vector<facet> & facets, facet_query_t & facet_query,
                    const std::vector<facet_info_t>& facet_infos,
                    size_t group_limit, const std::vector<std::string>& group_by_fields,
@@ -472,6 +543,11 @@ private:
 
     static void aggregate_topster(Topster* agg_topster, Topster* index_topster);
 
+    // adds the leaves of tokens that contain `token` (but are not already part of `leaves`), most frequent first
+    void search_infix(const std::string& field_name, const std::string& token,
+                      const uint32_t* filter_ids, size_t filter_ids_length, size_t max_candidates,
+                      const std::set<art_leaf*>& exclude_leaves, std::vector<art_leaf*>& leaves) const;
+
     void search_field(const uint8_t & field_id,
                       std::vector<token_t>& query_tokens,
                       std::vector<token_t>& search_tokens,
@@ -500,6 +576,7 @@ private:
 
     void search_candidates(const uint8_t & field_id,
                            bool field_is_array,
+                           bool field_has_positions,
                            const uint32_t* filter_ids, size_t filter_ids_length,
                            const uint32_t* exclude_token_ids, size_t exclude_token_ids_size,
                            const std::vector<uint32_t>& curated_ids,
@@ -524,11 +601,23 @@ private:
     void insert_doc(const int64_t score, art_tree *t, uint32_t seq_id,
                     const std::unordered_map<std::string, std::vector<uint32_t>> &token_to_offsets) const;
 
+    // only short values, which are the ones likely to repeat, are cached
+    static const size_t MAX_CACHED_VALUE_LEN = 64;
+    static const size_t MAX_CACHED_VALUES_PER_FIELD = 4096;
+
+    static const tokenized_value_t& tokenize_value(const std::string& text, bool is_facet, const field& a_field,
+                                                   const std::vector<char>& symbols_to_index,
+                                                   const std::vector<char>& token_separators,
+                                                   std::unordered_map<std::string, tokenized_value_t>* value_cache,
+                                                   std::unique_ptr<Tokenizer>& tokenizer,
+                                                   tokenized_value_t& value);
+
     static void tokenize_string_with_facets(const std::string& text, bool is_facet, const field& a_field,
                                             const std::vector<char>& symbols_to_index,
                                             const std::vector<char>& token_separators,
                                             std::unordered_map<std::string, std::vector<uint32_t>>& token_to_offsets,
-                                            std::vector<uint64_t>& facet_hashes);
+                                            std::vector<uint64_t>& facet_hashes,
+                                            std::unordered_map<std::string, tokenized_value_t>* value_cache = nullptr);
 
     void index_strings_field(const int64_t score, art_tree *t,
                             uint32_t seq_id, bool is_facet, const field & a_field,
@@ -540,7 +629,8 @@ private:
                                            const std::vector<char>& symbols_to_index,
                                            const std::vector<char>& token_separators,
                                            std::unordered_map<std::string, std::vector<uint32_t>>& token_to_offsets,
-                                           std::vector<uint64_t>& facet_hashes);
+                                           std::vector<uint64_t>& facet_hashes,
+                                           std::unordered_map<std::string, tokenized_value_t>* value_cache = nullptr);
 
     void collate_included_ids(const std::vector<std::string>& q_included_tokens,
                               const std::string & field, const uint8_t field_id,
@@ -581,6 +671,8 @@ private:
                                             const std::string &field_name,
                                             nlohmann::json::iterator& array_iter, bool is_array, bool& array_ele_erased);
 
+    static void init_field_check(validation_plan_t::field_check_t& field_check);
+
 public:
     // for limiting number of results on multiple candidates / query rewrites
     enum {TYPO_TOKENS_THRESHOLD = 1};
@@ -591,6 +683,9 @@ public:
     enum {COMBINATION_MAX_LIMIT = 10000};
     enum {COMBINATION_MIN_LIMIT = 10};
 
+    // number of documents that are scored together before being compared against the topster threshold
+    enum {SCORE_BATCH_SIZE = 256};
+
     // If the number of results found is less than this threshold, Typesense will attempt to drop the tokens
     // in the query that have the least individual hits one by one until enough results are found.
     static const int DROP_TOKENS_THRESHOLD = 1;
@@ -616,12 +711,15 @@ public:
 
     static void concat_topster_ids(Topster* topster, spp::sparse_hash_map<uint64_t, std::vector<KV*>>& topster_ids);
 
-    void score_results(const std::vector<sort_by> &sort_fields, const uint16_t &query_index, const uint8_t &field_id,
-                       bool field_is_array, const uint32_t total_cost,
+    template<sort_slot_t S0, sort_slot_t S1, sort_slot_t S2, bool grouping>
+    void score_results(score_kernel_t<S0, S1, S2, grouping> kernel,
+                       const std::vector<sort_by> &sort_fields, const uint16_t &query_index, const uint8_t &field_id,
+                       bool field_is_array, bool field_has_positions, const uint32_t total_cost,
                        Topster *topster, const std::vector<art_leaf *> &query_suggestion,
                        spp::sparse_hash_set<uint64_t> &groups_processed,
                        const uint32_t seq_id, const int sort_order[3],
-                       std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3> field_values,
+                       const std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3>& field_values,
+                       const std::array<sort_slot_t, 3>& sort_slots,
                        const std::vector<size_t>& geopoint_indices,
                        const size_t group_limit,
                        const std::vector<std::string> &group_by_fields, uint32_t token_bits,
@@ -629,6 +727,20 @@ public:
                        bool single_exact_query_token,
                        const std::vector<posting_list_t::iterator_t>& posting_lists) const;
 
+    // scores a batch of documents and only adds the ones that can beat the heap minimum of `topster` or the
+    // `shared_threshold` of the topsters it is aggregated with
+    template<sort_slot_t S0, sort_slot_t S1, sort_slot_t S2, bool grouping>
+    void score_results_batch(score_kernel_t<S0, S1, S2, grouping> kernel,
+                             const std::vector<sort_by> &sort_fields, const uint16_t &query_index,
+                             const uint8_t &field_id, Topster *topster, topster_threshold_t* shared_threshold,
+                             spp::sparse_hash_set<uint64_t> &groups_processed,
+                             const uint32_t* seq_ids, const size_t num_seq_ids, const int sort_order[3],
+                             const std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3>& field_values,
+                             const std::array<sort_slot_t, 3>& sort_slots,
+                             const std::vector<size_t>& geopoint_indices,
+                             const std::vector<std::string> &group_by_fields, uint32_t token_bits,
+                             const std::vector<posting_list_t::iterator_t>& posting_lists) const;
+
     static int64_t get_points_from_doc(const nlohmann::json &document, const std::string & default_sorting_field);
 
     const spp::sparse_hash_map<std::string, art_tree *>& _get_search_index() const;
@@ -646,7 +758,8 @@ public:
                                              const std::unordered_map<std::string, field>& search_schema,
                                              const std::map<std::string, field>& facet_schema,
                                              const std::vector<char>& local_token_separators,
-                                             const std::vector<char>& local_symbols_to_index);
+                                             const std::vector<char>& local_symbols_to_index,
+                                             tokenization_cache_t* tokenization_cache = nullptr);
 
     static void scrub_reindex_doc(const std::unordered_map<std::string, field>& search_schema,
                                   nlohmann::json& update_doc, nlohmann::json& del_doc, const nlohmann::json& old_doc);
@@ -688,10 +801,14 @@ public:
 
     Option<uint32_t> remove(const uint32_t seq_id, const nlohmann::json & document, const bool is_update);
 
+    static void compile_validation_plan(const std::unordered_map<std::string, field>& search_schema,
+                                        validation_plan_t& validation_plan);
+
     static void validate_and_preprocess(Index *index, std::vector<index_record>& iter_batch,
                                           const size_t batch_start_index, const size_t batch_size,
                                           const std::string & default_sorting_field,
                                           const std::unordered_map<std::string, field> & search_schema,
+                                          const validation_plan_t& validation_plan,
                                           const std::map<std::string, field> & facet_schema,
                                           const std::string& fallback_field_type,
                                           const std::vector<char>& token_separators,
@@ -701,6 +818,7 @@ public:
                                      std::vector<index_record> & iter_batch,
                                      const std::string & default_sorting_field,
                                      const std::unordered_map<std::string, field> & search_schema,
+                                     const validation_plan_t& validation_plan,
                                      const std::map<std::string, field> & facet_schema,
                                      const std::string& fallback_field_type,
                                      const std::vector<char>& token_separators,
@@ -708,6 +826,10 @@ public:
 
     void index_field_in_memory(const field& afield, std::vector<index_record>& iter_batch);
 
+    // reduces token offsets to what is needed to identify the document (and array elements) containing the token
+    static void strip_token_positions(bool is_array, const std::vector<uint32_t>& offsets,
+                                      std::vector<uint32_t>& stripped_offsets);
+
     template<class T>
     void iterate_and_index_numerical_field(std::vector<index_record>& iter_batch, const field& afield, T func);
 
@@ -719,16 +841,23 @@ public:
 
     art_leaf* get_token_leaf(const std::string & field_name, const unsigned char* token, uint32_t token_len);
 
+    // looks up many tokens of a field at once: `leaves[i]` is null when `tokens[i]` is not found
+    void get_token_leaves(const std::string & field_name, const std::vector<const unsigned char*>& tokens,
+                          const std::vector<int>& token_lens, std::vector<art_leaf*>& leaves);
+
     void do_filtering_with_lock(uint32_t*& filter_ids, uint32_t& filter_ids_length,
                                 const std::vector<filter>& filters) const;
 
     void refresh_schemas(const std::vector<field>& new_fields);
 
+    void suggest(const std::string& field_name, const std::string& query, size_t num_typos, size_t limit,
+                 std::vector<suggestion_t>& suggestions) const;
+
     // the following methods are not synchronized because their parent calls are synchronized or they are const/static
 
     static Option<uint32_t> validate_index_in_memory(nlohmann::json &document, uint32_t seq_id,
                                                      const std::string & default_sorting_field,
-                                                     const std::unordered_map<std::string, field> & search_schema,
+                                                     const validation_plan_t& validation_plan,
                                                      const std::map<std::string, field> & facet_schema,
                                                      const index_operation_t op,
                                                      const std::string& fallback_field_type,
@@ -751,16 +880,56 @@ public:
 
     void populate_sort_mapping(int* sort_order, std::vector<size_t>& geopoint_indices,
                                const std::vector<sort_by>& sort_fields_std,
-                               std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3>& field_values) const;
+                               std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3>& field_values,
+                               std::array<sort_slot_t, 3>& sort_slots) const;
+
+    // fields indexed without token positions are scored as a bag of words: on the number of tokens found and
+    // their typo cost, without proximity or verbatim match signals
+    static uint64_t compute_match_score(const uint32_t seq_id, const bool field_is_array,
+                                        const bool field_has_positions, const uint32_t total_cost,
+                                        const bool prioritize_exact_match, const bool single_exact_query_token,
+                                        const std::vector<posting_list_t::iterator_t>& posting_lists);
+
+    void compute_geo_distances(const std::vector<sort_by>& sort_fields, const uint32_t seq_id,
+                               const std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3>& field_values,
+                               const std::vector<size_t>& geopoint_indices, int64_t* geopoint_distances) const;
+
+    template<sort_slot_t S0, sort_slot_t S1, sort_slot_t S2, bool grouping>
+    void compute_sort_scores(score_kernel_t<S0, S1, S2, grouping> kernel,
+                             const std::vector<sort_by>& sort_fields, const bool field_is_array,
+                             const bool field_has_positions,
+                             const uint32_t total_cost, const uint32_t seq_id, const int sort_order[3],
+                             const std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3>& field_values,
+                             const std::array<sort_slot_t, 3>& sort_slots,
+                             const std::vector<size_t>& geopoint_indices,
+                             const bool prioritize_exact_match, const bool single_exact_query_token,
+                             const std::vector<posting_list_t::iterator_t>& posting_lists,
+                             int64_t* scores, size_t& match_score_index) const;
+
+    template<sort_slot_t slot>
+    static void compute_sort_score(const size_t i, const uint32_t seq_id, const uint64_t match_score,
+                                   const int64_t* geopoint_distances, const int sort_order[3],
+                                   const std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3>& field_values,
+                                   const std::array<sort_slot_t, 3>& sort_slots,
+                                   int64_t* scores, size_t& match_score_index);
 
     static void remove_matched_tokens(std::vector<std::string>& tokens, const std::set<std::string>& rule_token_set) ;
 
+    // every value of a string field normalized into a phrase: its lower cased tokens separated by a space
+    static void get_suggestion_phrases(const nlohmann::json& document, const field& search_field,
+                                       std::vector<std::string>& phrases);
+
     void compute_facet_infos(const std::vector<facet>& facets, facet_query_t& facet_query,
                              const uint32_t* all_result_ids, const size_t& all_result_ids_len,
                              const std::vector<std::string>& group_by_fields,
                              std::vector<facet_info_t>& facet_infos) const;
 
     size_t num_seq_ids() const;
+
+    size_t get_skipped_position_bytes(const std::string& field_name) const;
+
+    // bytes held by the nodes and leaves of the token tree of a field
+    size_t get_search_index_bytes(const std::string& field_name) const;
 };
 
 template<class T>
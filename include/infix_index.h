@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "sparsepp.h"
+
+/**
+ * N-gram index over the distinct tokens of a field, used to find the tokens that contain a given infix.
+ *
+ * Every token is given an ID and each of its n-grams maps to a posting list of the IDs of the tokens it occurs in
+ * (the offsets being the positions of the n-gram within the token). An infix is looked up by intersecting the
+ * posting lists of its n-grams and verifying the surviving tokens. Only tokens of up to `max_token_len` bytes are
+ * indexed, which keeps the index small for the short, identifier-like values it is meant for.
+ */
+class infix_index_t {
+private:
+    const size_t ngram_len;
+    const size_t max_token_len;
+
+    // token ID => token (empty when the ID is free)
+    std::vector<std::string> tokens;
+    std::vector<uint32_t> free_token_ids;
+    spp::sparse_hash_map<std::string, uint32_t> token_ids;
+
+    // n-gram => posting list of token IDs
+    spp::sparse_hash_map<std::string, void*> ngram_index;
+
+    // n-gram => positions within the token
+    void get_ngrams(const std::string& token, std::map<std::string, std::vector<uint32_t>>& ngrams) const;
+
+public:
+
+    static constexpr size_t DEFAULT_NGRAM_LEN = 3;
+    static constexpr size_t DEFAULT_MAX_TOKEN_LEN = 32;
+
+    explicit infix_index_t(size_t ngram_len = DEFAULT_NGRAM_LEN, size_t max_token_len = DEFAULT_MAX_TOKEN_LEN);
+
+    ~infix_index_t();
+
+    infix_index_t(const infix_index_t&) = delete;
+
+    infix_index_t& operator=(const infix_index_t&) = delete;
+
+    // no-op for tokens that are already indexed or too long to be indexed
+    void add(const std::string& token);
+
+    void remove(const std::string& token);
+
+    // tokens that contain `infix`: infixes shorter than the n-gram length never match
+    void search(const std::string& infix, std::vector<std::string>& matched_tokens) const;
+
+    size_t num_tokens() const;
+
+    size_t num_ngrams() const;
+};
@@ -16,6 +16,66 @@ struct token_positions_t {
     std::vector<uint16_t> positions;
 };
 
+/*
+    Positions of query tokens within a single plain (non-array) document. All positions live in one buffer that is
+    reused across documents, so once the buffers have grown, filling and scoring a document does not allocate.
+*/
+struct doc_token_positions_t {
+    struct positions_t {
+        const uint16_t* data = nullptr;
+        size_t length = 0;
+
+        uint16_t operator[](size_t i) const {
+            return data[i];
+        }
+
+        size_t size() const {
+            return length;
+        }
+
+        bool empty() const {
+            return length == 0;
+        }
+
+        uint16_t back() const {
+            return data[length - 1];
+        }
+    };
+
+    struct token_t {
+        bool last_token = false;
+        size_t start = 0;
+        positions_t positions;
+    };
+
+    std::vector<token_t> tokens;
+    std::vector<uint16_t> buffer;
+
+    void clear() {
+        tokens.clear();
+        buffer.clear();
+    }
+
+    void add_position(uint16_t position) {
+        buffer.push_back(position);
+    }
+
+    // closes the positions added since the previous token (tokens without positions are skipped)
+    void end_token(bool last_token) {
+        size_t start = tokens.empty() ? 0 : (tokens.back().start + tokens.back().positions.length);
+        if(buffer.size() != start) {
+            tokens.push_back(token_t{last_token, start, positions_t{nullptr, buffer.size() - start}});
+        }
+    }
+
+    // must be called once all tokens are added, since the buffer could have been reallocated while adding
+    void finalize() {
+        for(auto& token: tokens) {
+            token.positions.data = &buffer[token.start];
+        }
+    }
+};
+
 struct TokenOffset {
     uint8_t token_id;                            // token identifier
     uint16_t offset = MAX_DISPLACEMENT;          // token's offset in the text
@@ -83,7 +143,7 @@ struct Match {
     }
 
     template<typename T>
-    void sort3(std::vector<T>& a) {
+    void sort3(T* a) {
         if (a[0] > a[1]) {
             if (a[1] > a[2]) {
                 return;
@@ -127,43 +187,67 @@ struct Match {
 
     Match(uint32_t doc_id, const std::vector<token_positions_t>& token_offsets,
           bool populate_window=true, bool check_exact_match=false) {
+        match_window(token_offsets, populate_window, check_exact_match);
+    }
+
+    Match(uint32_t doc_id, const doc_token_positions_t& doc_token_positions,
+          bool populate_window=true, bool check_exact_match=false) {
+        match_window(doc_token_positions.tokens, populate_window, check_exact_match);
+    }
+
+private:
+
+    // Windows are held in fixed size arrays since the number of tokens considered is bounded by `WINDOW_SIZE`
+    template<typename T>
+    void match_window(const T& token_offsets, bool populate_window, bool check_exact_match) {
         // in case if number of tokens in query is greater than max window
         const size_t tokens_size = std::min(token_offsets.size(), WINDOW_SIZE);
 
-        std::vector<TokenOffset> window(tokens_size);
+        TokenOffset window[WINDOW_SIZE];
+        size_t window_size = tokens_size;
+
         for (size_t token_id = 0; token_id < tokens_size; token_id++) {
             window[token_id] = TokenOffset{static_cast<uint8_t>(token_id), token_offsets[token_id].positions[0], 0};
         }
 
-        std::vector<TokenOffset> best_window;
+        TokenOffset best_window[WINDOW_SIZE];
+        TokenOffset this_window[WINDOW_SIZE];
+
         if(populate_window) {
-            best_window = window;
+            std::copy(window, window + tokens_size, best_window);
         }
 
         size_t best_num_match = 1;
         size_t best_displacement = MAX_DISPLACEMENT;
 
-        while (window.size() > 1) {
-            if(window.size() == 3) {
+        while (window_size > 1) {
+            if(window_size == 2) {
+                if(window[0] < window[1]) {
+                    std::swap(window[0], window[1]);
+                }
+            } else if(window_size == 3) {
                 sort3<TokenOffset>(window);
             } else {
-                std::sort(window.begin(), window.end(), std::greater<TokenOffset>());  // descending comparator
+                std::sort(window, window + window_size, std::greater<TokenOffset>());  // descending comparator
             }
 
-            size_t min_offset = window.back().offset;
+            size_t min_offset = window[window_size - 1].offset;
 
             size_t this_displacement = 0;
             size_t this_num_match = 0;
-            std::vector<TokenOffset> this_window(tokens_size);
 
-            for (size_t i = 0; i < window.size(); i++) {
+            if(populate_window) {
+                std::fill(this_window, this_window + tokens_size, TokenOffset{});
+            }
+
+            for (size_t i = 0; i < window_size; i++) {
                 if(populate_window) {
                     this_window[window[i].token_id] = window[i];
                     this_window[window[i].token_id].offset = MAX_DISPLACEMENT;
                 }
 
                 if ((window[i].offset - min_offset) <= WINDOW_SIZE) {
-                    uint16_t next_offset = (i == window.size() - 1) ? window[i].offset : window[i + 1].offset;
+                    uint16_t next_offset = (i == window_size - 1) ? window[i].offset : window[i + 1].offset;
                     this_displacement += window[i].offset - next_offset;
                     this_num_match++;
 
@@ -178,21 +262,21 @@ struct Match {
                 best_displacement = this_displacement;
                 best_num_match = this_num_match;
                 if(populate_window) {
-                    best_window = this_window;
+                    std::copy(this_window, this_window + tokens_size, best_window);
                 }
             }
 
-            if (best_num_match == tokens_size && best_displacement == (window.size() - 1)) {
+            if (best_num_match == tokens_size && best_displacement == (window_size - 1)) {
                 // this is the best we can get, so quit early!
                 break;
             }
 
             // fill window with next possible smallest offset across available token this_token_offsets
-            const TokenOffset &smallest_offset = window.back();
-            window.pop_back();
+            const TokenOffset smallest_offset = window[window_size - 1];
+            window_size--;
 
             const uint8_t token_id = smallest_offset.token_id;
-            const std::vector<uint16_t>& this_token_offsets = token_offsets[token_id].positions;
+            const auto& this_token_offsets = token_offsets[token_id].positions;
 
             if (smallest_offset.offset == this_token_offsets.back()) {
                 // no more offsets for this token
@@ -201,8 +285,7 @@ struct Match {
 
             // Push next offset of same token popped
             uint16_t next_offset_index = (smallest_offset.offset_index + 1);
-            TokenOffset token_offset{token_id, this_token_offsets[next_offset_index], next_offset_index};
-            window.emplace_back(token_offset);
+            window[window_size++] = TokenOffset{token_id, this_token_offsets[next_offset_index], next_offset_index};
         }
 
         if (best_displacement == MAX_DISPLACEMENT) {
@@ -212,7 +295,7 @@ struct Match {
         words_present = best_num_match;
         distance = uint8_t(best_displacement);
         if(populate_window) {
-            offsets = best_window;
+            offsets.assign(best_window, best_window + tokens_size);
         }
 
         exact_match = 0;
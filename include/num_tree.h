@@ -8,16 +8,79 @@
 
 class num_tree_t {
 private:
-    std::map<int64_t, sorted_array*> int64map;
+    // Distinct values are stored in a two-level B+-tree: a flat, sorted array of the last value of every leaf
+    // is binary searched to locate a fat leaf which holds up to `LEAF_MAX_VALUES` values contiguously.
+    // Values that occur in a single document store that ID inline (tagged with the lowest bit) instead of
+    // allocating a `sorted_array`.
 
-public:
+    static constexpr size_t LEAF_MAX_VALUES = 128;
+
+    struct leaf_t {
+        std::vector<int64_t> values;
+        // parallel to `values`: either a `sorted_array*` or a tagged single ID
+        std::vector<void*> ids;
+    };
+
+    std::vector<int64_t> leaf_last_values;
+    std::vector<leaf_t*> leaves;
+    size_t num_values = 0;
+
+    // Zone map over fixed blocks of seq_ids: the min/max value and the IDs present in each block let range
+    // searches accept or reject whole blocks, so that only values of boundary blocks have to be examined.
+
+    static constexpr size_t ZONE_BLOCK_BITS = 12;
+    static constexpr size_t ZONE_BLOCK_SIZE = (1 << ZONE_BLOCK_BITS);
+
+    struct zone_t {
+        int64_t min = std::numeric_limits<int64_t>::max();
+        int64_t max = std::numeric_limits<int64_t>::min();
+        // min/max are not shrunk on removal, so a zone with removals is only used for rejection
+        bool has_removals = false;
+        uint64_t id_bits[ZONE_BLOCK_SIZE / 64] = {};
+    };
+
+    std::vector<zone_t*> zones;
+
+    void update_zone(int64_t value, uint32_t id);
+
+    static inline bool is_single_id(const void* ids) {
+        return ((uintptr_t)(ids) & 1);
+    }
+
+    static inline void* to_single_id(uint32_t id) {
+        return (void*)((uintptr_t(id) << 1) | 1);
+    }
 
-    ~num_tree_t() {
-        for(auto& kv: int64map) {
-            delete kv.second;
-        }
+    static inline uint32_t get_single_id(const void* ids) {
+        return uint32_t((uintptr_t)(ids) >> 1);
     }
 
+    static uint32_t num_ids(const void* ids);
+
+    static void copy_ids(const void* ids, uint32_t* out);
+
+    static void destroy_ids(void* ids);
+
+    // returns position of the first value that is >= `value` (leaf index is `leaves.size()` when there is none)
+    std::pair<size_t, size_t> lower_bound(int64_t value) const;
+
+    // collects ID lists of values starting from the given position while value <= `end`
+    void collect(std::pair<size_t, size_t> pos, int64_t end, std::vector<const void*>& id_lists) const;
+
+    // merges ID lists into a sorted, de-duplicated array and OR-s it into `ids`
+    static void merge_ids(const std::vector<const void*>& id_lists, uint32_t** ids, size_t& ids_len);
+
+    // range search that consults the zone map before walking values
+    void zone_range_search(int64_t start, int64_t end, uint32_t** ids, size_t& ids_len) const;
+
+    void split_leaf(size_t leaf_index);
+
+    void erase_value(size_t leaf_index, size_t value_index);
+
+public:
+
+    ~num_tree_t();
+
     void insert(int64_t value, uint32_t id);
 
     void range_inclusive_search(int64_t start, int64_t end, uint32_t** ids, size_t& ids_len);
@@ -29,4 +92,4 @@ public:
     void remove(uint64_t value, uint32_t id);
 
     size_t size();
-};
\ No newline at end of file
+};
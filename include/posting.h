@@ -49,6 +49,11 @@ public:
     static constexpr size_t COMPACT_LIST_THRESHOLD_LENGTH = 64;
     static constexpr size_t MAX_BLOCK_ELEMENTS = 256;
 
+    // full lists with at least these many IDs, covering at least one in every `DENSE_LIST_MAX_SPREAD` IDs of
+    // their range, also maintain an IDs bitmap (dropped again once the list shrinks below half the length)
+    static constexpr size_t DENSE_LIST_THRESHOLD_LENGTH = 65536;
+    static constexpr size_t DENSE_LIST_MAX_SPREAD = 32;
+
     struct block_intersector_t {
         std::vector<posting_list_t*> plists;
         std::vector<posting_list_t*> expanded_plists;
@@ -86,6 +91,10 @@ public:
 
     static void upsert(void*& obj, uint32_t id, const std::vector<uint32_t>& offsets);
 
+    // bulk version of `upsert` for IDs that are sorted and larger than the last ID of the list
+    static void append_sorted(void*& obj, const uint32_t* ids, const uint32_t* offset_index, size_t num_ids,
+                              const uint32_t* offsets, size_t num_offsets);
+
     static void erase(void*& obj, uint32_t id);
 
     static void destroy_list(void*& obj);
@@ -94,6 +103,8 @@ public:
 
     static uint32_t first_id(const void* obj);
 
+    static uint32_t last_id(const void* obj);
+
     static bool contains(const void* obj, uint32_t id);
 
     static bool contains_atleast_one(const void* obj, const uint32_t* target_ids, size_t target_ids_size);
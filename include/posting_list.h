@@ -49,21 +49,40 @@ public:
 
         block_t* end_block;
 
-    public:
-        // uncompressed data structures for performance
-        uint32_t* ids = nullptr;
-        uint32_t* offset_index = nullptr;
-        uint32_t* offsets = nullptr;
+        // positions of current and end blocks in the skip index of `list`, used to jump directly to a block
+        const posting_list_t* list;
+        size_t curr_block_index;
+        size_t end_block_index;
+
+        // decode buffers are reused across blocks: IDs are decoded when a block is entered, while offsets
+        // are only decoded on first access, so that intersections never touch position data
+        std::vector<uint32_t> ids;
+        mutable std::vector<uint32_t> offset_index;
+        mutable std::vector<uint32_t> offsets;
+        mutable bool offsets_decoded = false;
+
+        void decode_block();
+
+        void decode_offsets() const;
 
-        explicit iterator_t(block_t* start, block_t* end);
+    public:
+        explicit iterator_t(const posting_list_t* list, size_t start_block_index, size_t end_block_index);
         iterator_t(iterator_t&& rhs) noexcept;
-        ~iterator_t();
+        ~iterator_t() = default;
         [[nodiscard]] bool valid() const;
         void next();
         void skip_to(uint32_t id);
         [[nodiscard]] uint32_t id() const;
         [[nodiscard]] inline uint32_t index() const;
         [[nodiscard]] inline block_t* block() const;
+
+        [[nodiscard]] const posting_list_t* posting_list() const {
+            return list;
+        }
+
+        // uncompressed offset index and offsets of the current block
+        [[nodiscard]] const uint32_t* get_offset_index() const;
+        [[nodiscard]] const uint32_t* get_offsets() const;
     };
 
     struct result_iter_state_t {
@@ -95,8 +114,20 @@ private:
 
     // keeps track of the *last* ID in each block and is used for partial random access
     // e.g. 0..[9], 10..[19], 20..[29]
-    // MUST be ordered
-    std::map<last_id_t, block_t*> id_block_map;
+    // MUST be ordered: `blocks` is parallel to `block_last_ids` and follows the chain of blocks
+    std::vector<last_id_t> block_last_ids;
+    std::vector<block_t*> blocks;
+
+    // position of the first block in [begin, end) whose last ID is >= `id` (`end` if there is none)
+    size_t lower_bound_block(uint32_t id, size_t begin, size_t end) const;
+
+    size_t lower_bound_block(uint32_t id) const {
+        return lower_bound_block(id, 0, block_last_ids.size());
+    }
+
+    // Dense lists additionally keep a bitmap of their IDs, so that membership can be checked with a bit test.
+    // Positions continue to live in the blocks.
+    std::vector<uint64_t> ids_bitmap;
 
     static bool at_end(const std::vector<posting_list_t::iterator_t>& its);
     static bool at_end2(const std::vector<posting_list_t::iterator_t>& its);
@@ -113,6 +144,14 @@ private:
     static uint32_t advance_smallest(std::vector<posting_list_t::iterator_t>& its);
     static uint32_t advance_smallest2(std::vector<posting_list_t::iterator_t>& its);
 
+    static bool has_dense_and_sparse(const std::vector<posting_list_t::iterator_t>& its);
+
+    // intersection that iterates on sparse lists and looks up IDs in the bitmaps of dense lists: dense iterators
+    // are only moved (to make offsets available) when `position_dense_its` is true
+    template<class T>
+    static void dense_block_intersect(std::vector<posting_list_t::iterator_t>& its, result_iter_state_t& istate,
+                                      bool position_dense_its, T func);
+
 public:
 
     posting_list_t() = delete;
@@ -127,6 +166,11 @@ public:
 
     void upsert(uint32_t id, const std::vector<uint32_t>& offsets);
 
+    // appends IDs that are sorted and larger than the last ID of the list: the offsets of `ids[i]` start at
+    // `offset_index[i]`, and full blocks are encoded in one go instead of one ID at a time
+    void append_sorted(const uint32_t* ids, const uint32_t* offset_index, size_t num_ids,
+                       const uint32_t* offsets, size_t num_offsets);
+
     void erase(uint32_t id);
 
     block_t* get_root();
@@ -137,6 +181,21 @@ public:
 
     uint32_t first_id();
 
+    uint32_t last_id() const;
+
+    void build_ids_bitmap();
+
+    void clear_ids_bitmap();
+
+    [[nodiscard]] bool is_dense() const {
+        return !ids_bitmap.empty();
+    }
+
+    [[nodiscard]] bool bitmap_contains(uint32_t id) const {
+        const size_t word = (id >> 6);
+        return word < ids_bitmap.size() && ((ids_bitmap[word] >> (id & 63)) & 1);
+    }
+
     block_t* block_of(uint32_t id);
 
     bool contains(uint32_t id);
@@ -145,6 +204,12 @@ public:
 
     iterator_t new_iterator(block_t* start_block = nullptr, block_t* end_block = nullptr);
 
+    // iterates over the blocks at positions [start_block_index, end_block_index) of the list
+    iterator_t new_iterator(size_t start_block_index, size_t end_block_index);
+
+    // position of the block where `id` resides or would reside (`num_blocks()` if it is past the last ID)
+    size_t block_index_of(uint32_t id) const;
+
     static void merge(const std::vector<posting_list_t*>& posting_lists, std::vector<uint32_t>& result_ids);
 
     static void intersect(const std::vector<posting_list_t*>& posting_lists, std::vector<uint32_t>& result_ids);
@@ -163,6 +228,9 @@ public:
         std::unordered_map<size_t, std::vector<token_positions_t>>& array_token_pos
     );
 
+    // offsets of a plain (non-array) field, filled into reusable storage without allocating
+    static void get_offsets(const std::vector<iterator_t>& its, doc_token_positions_t& doc_token_positions);
+
     static bool is_single_token_verbatim_match(const posting_list_t::iterator_t& it, bool field_is_array);
 
     static void get_exact_matches(std::vector<iterator_t>& its, bool field_is_array,
@@ -173,10 +241,75 @@ public:
                                            std::vector<size_t>& indices);
 };
 
+template<class T>
+void posting_list_t::dense_block_intersect(std::vector<posting_list_t::iterator_t>& its, result_iter_state_t& istate,
+                                           const bool position_dense_its, T func) {
+    std::vector<size_t> sparse_indices;
+    std::vector<size_t> dense_indices;
+
+    for(size_t i = 0; i < its.size(); i++) {
+        if(its[i].posting_list()->is_dense()) {
+            dense_indices.push_back(i);
+        } else {
+            sparse_indices.push_back(i);
+        }
+    }
+
+    iterator_t& lead_it = its[sparse_indices[0]];
+
+    while(lead_it.valid()) {
+        uint32_t id = lead_it.id();
+        bool found = true;
+
+        for(size_t k = 1; k < sparse_indices.size(); k++) {
+            iterator_t& it = its[sparse_indices[k]];
+            it.skip_to(id);
+
+            if(!it.valid()) {
+                return ;
+            }
+
+            if(it.id() != id) {
+                // other sparse list is ahead: catch up with it
+                lead_it.skip_to(it.id());
+                found = false;
+                break;
+            }
+        }
+
+        if(!found) {
+            continue;
+        }
+
+        for(size_t k = 0; found && k < dense_indices.size(); k++) {
+            found = its[dense_indices[k]].posting_list()->bitmap_contains(id);
+        }
+
+        if(found && position_dense_its) {
+            for(size_t k = 0; found && k < dense_indices.size(); k++) {
+                iterator_t& it = its[dense_indices[k]];
+                it.skip_to(id);
+                found = it.valid() && it.id() == id;
+            }
+        }
+
+        if(found && posting_list_t::take_id(istate, id)) {
+            func(id, its, istate.index);
+        }
+
+        lead_it.next();
+    }
+}
+
 template<class T>
 bool posting_list_t::block_intersect(std::vector<posting_list_t::iterator_t>& its, result_iter_state_t& istate,
                                      T func) {
 
+    if(has_dense_and_sparse(its)) {
+        dense_block_intersect(its, istate, true, func);
+        return false;
+    }
+
     switch (its.size()) {
         case 0:
             break;
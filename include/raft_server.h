@@ -205,6 +205,10 @@ public:
 
     int64_t get_num_queued_writes();
 
+    bool is_write_admitted(const std::string& coll_name, uint32_t& retry_after_seconds);
+
+    void get_write_stats(nlohmann::json& stats);
+
     bool is_leader();
 
 private:
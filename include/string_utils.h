@@ -319,4 +319,8 @@ struct StringUtils {
     static std::string trim_curly_spaces(const std::string& str);
 
     static bool ends_with(std::string const &str, std::string const &ending);
+
+    // checks whether `str` holds a whole JSON object by matching its brackets outside of strings: the values
+    // are not validated, which is left to the actual parse
+    static bool is_complete_json_object(const std::string& str);
 };
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+struct suggestion_t {
+    std::string text;
+    int64_t weight;
+    uint32_t num_typos;
+};
+
+/**
+ * Weighted completion trie for query suggestions.
+ *
+ * Phrases are stored in a compact, array based trie whose nodes are laid out breadth first (the children of a
+ * node are contiguous) and carry the maximum weight found below them, so that the top completions of a prefix are
+ * found with a best-first walk. Changes are buffered in a sorted delta that is merged into queries, and the trie
+ * is rebuilt from the merged phrases once the delta grows past a fraction of the trie.
+ */
+class suggestion_index_t {
+private:
+    struct node_t {
+        uint32_t first_child = 0;
+        uint16_t num_children = 0;
+        unsigned char c = 0;
+        int32_t entry = -1;         // phrase that ends on this node
+        int64_t max_weight = 0;     // of all phrases below (and on) this node
+    };
+
+    struct entry_t {
+        std::string phrase;
+        int64_t weight;
+    };
+
+    static constexpr size_t MIN_REBUILD_DELTA_SIZE = 1024;
+    static constexpr size_t MAX_TYPOS = 2;
+
+    mutable std::shared_mutex mutex;
+
+    std::vector<node_t> nodes;
+    std::vector<entry_t> entries;
+
+    // phrase => weight change since the trie was built
+    std::map<std::string, int64_t> delta;
+
+    void build();
+
+    int64_t trie_weight(const std::string& phrase) const;
+
+    void trie_matches(const std::string& prefix, size_t max_typos,
+                      std::vector<std::pair<uint32_t, uint32_t>>& roots) const;
+
+    void trie_top(const std::vector<uint32_t>& roots, size_t num_results, std::vector<uint32_t>& entry_ids) const;
+
+public:
+
+    suggestion_index_t();
+
+    // adjusts the weight of a phrase: phrases without a positive weight are not suggested
+    void add(const std::string& phrase, int64_t weight);
+
+    // returns the heaviest phrases that start with `prefix`, allowing up to `num_typos` edits within the prefix:
+    // suggestions with fewer typos are ranked first
+    void suggest(const std::string& prefix, size_t num_typos, size_t limit,
+                 std::vector<suggestion_t>& suggestions) const;
+
+    // number of phrases in the trie (excluding pending changes)
+    size_t size() const;
+
+    static size_t prefix_edit_distance(const std::string& prefix, const std::string& phrase, size_t max_distance);
+};
@@ -2,6 +2,9 @@
 
 extern thread_local int64_t write_log_index;
 
+// last log index of the writes coalesced with `write_log_index`, or 0 when a single write is being applied
+extern thread_local int64_t write_log_index_end;
+
 // These are used for circuit breaking search requests
 // NOTE: if you fork off main search thread, care must be taken to initialize these from parent thread values
 extern thread_local std::chrono::high_resolution_clock::time_point search_begin;
@@ -17,14 +17,19 @@ private:
     const bool no_op;
 
     size_t token_counter = 0;
-    iconv_t cd;
 
-    static const size_t INDEX = 0;
-    static const size_t SEPARATE = 1;
-    static const size_t SKIP = 2;
+    // opened on the first multi-byte character that has to be normalized
+    iconv_t cd = (iconv_t) -1;
 
-    uint8_t index_symbols[256] = {};
-    uint8_t separator_symbols[256] = {};
+    static const uint8_t INDEX = 0;
+    static const uint8_t SEPARATE = 1;
+    static const uint8_t SKIP = 2;
+
+    // stream mode of every ascii byte, with the symbols to index and the separators folded in
+    uint8_t stream_modes[256] = {};
+
+    // text without any multi-byte character is tokenized byte by byte, without iconv
+    bool ascii_text = false;
 
     std::string out;
 
@@ -41,16 +46,18 @@ private:
 
     icu::Transliterator* transliterator = nullptr;
 
-    inline size_t get_stream_mode(char c) {
-        return (std::isalnum(c) || index_symbols[uint8_t(c)] == 1) ? INDEX : (
-            (c == ' ' || c == '\n' || separator_symbols[uint8_t(c)] == 1) ? SEPARATE : SKIP
-        );
+    inline uint8_t get_stream_mode(char c) const {
+        return stream_modes[uint8_t(c)];
     }
 
     static inline bool is_ascii_char(char c) {
         return (c & ~0x7f) == 0;
     }
 
+    static bool is_ascii_text(const char* data, size_t size);
+
+    void init(const std::string& input);
+
 public:
 
     explicit Tokenizer(const std::string& input,
@@ -60,12 +67,23 @@ public:
                        const std::vector<char>& separators = {});
 
     ~Tokenizer() {
-        iconv_close(cd);
+        if(cd != (iconv_t) -1) {
+            iconv_close(cd);
+        }
+
         free(normalized_text);
         delete bi;
         delete transliterator;
     }
 
+    Tokenizer(const Tokenizer&) = delete;
+
+    Tokenizer& operator=(const Tokenizer&) = delete;
+
+    // Tokenizes `input` with the same configuration, reusing the converters and break iterator of this instance.
+    // Like the constructor, only a view of `input` is held, so it must outlive the tokenization.
+    void reset(const std::string& input);
+
     bool next(std::string& token, size_t& token_index, size_t& start_index, size_t& end_index);
 
     bool next(std::string& token, size_t& token_index);
@@ -5,6 +5,8 @@
 #include <cstdio>
 #include <algorithm>
 #include <unordered_map>
+#include <mutex>
+#include <tuple>
 
 struct KV {
     uint8_t field_id{};
@@ -95,6 +97,45 @@ struct KV {
     }
 };
 
+/*
+* Lowest scores that can still make it to the final top-K of topsters that are filled from disjoint sets of
+* documents: once any of them is full, documents below its minimum can be skipped by all of them.
+*/
+struct topster_threshold_t {
+    std::mutex mutex;
+    bool valid = false;
+    int64_t scores[3] = {INT64_MIN, INT64_MIN, INT64_MIN};
+
+    // raises the threshold if given scores are larger
+    void publish(const int64_t* min_scores) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if(!valid || std::tie(min_scores[0], min_scores[1], min_scores[2]) >
+                     std::tie(scores[0], scores[1], scores[2])) {
+            scores[0] = min_scores[0];
+            scores[1] = min_scores[1];
+            scores[2] = min_scores[2];
+            valid = true;
+        }
+    }
+
+    // raises given threshold if the shared threshold is larger, returns whether a threshold exists
+    bool merge_into(int64_t* threshold, bool has_threshold) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if(!valid) {
+            return has_threshold;
+        }
+
+        if(!has_threshold || std::tie(scores[0], scores[1], scores[2]) >
+                             std::tie(threshold[0], threshold[1], threshold[2])) {
+            threshold[0] = scores[0];
+            threshold[1] = scores[1];
+            threshold[2] = scores[2];
+        }
+
+        return true;
+    }
+};
+
 /*
 * Remembers the max-K elements seen so far using a min-heap
 */
@@ -269,6 +310,34 @@ struct Topster {
         return true;
     }
 
+    // when full, any element that is smaller than `min_scores()` will be rejected by a non-distinct topster
+    bool is_full() const {
+        return !distinct && size >= MAX_SIZE;
+    }
+
+    const int64_t* min_scores() const {
+        return kvs[0]->scores;
+    }
+
+    /*
+    * Filters a batch of scores laid out column-wise against a threshold and writes the positions of the
+    * elements that are not smaller than it to `survivors`. Branch-free, so that the loop can be vectorized.
+    */
+    static size_t filter_batch(const int64_t* scores0, const int64_t* scores1, const int64_t* scores2,
+                               const size_t n, const int64_t* threshold, uint32_t* survivors) {
+        const int64_t t0 = threshold[0], t1 = threshold[1], t2 = threshold[2];
+        size_t num_survivors = 0;
+
+        for(size_t i = 0; i < n; i++) {
+            const bool keep = (scores0[i] > t0) |
+                              ((scores0[i] == t0) & ((scores1[i] > t1) | ((scores1[i] == t1) & (scores2[i] >= t2))));
+            survivors[num_survivors] = i;
+            num_survivors += keep;
+        }
+
+        return num_survivors;
+    }
+
     static bool is_greater(const struct KV* i, const struct KV* j) {
         return std::tie(i->scores[0], i->scores[1], i->scores[2], i->key) >
                std::tie(j->scores[0], j->scores[1], j->scores[2], j->key);
@@ -7,6 +7,10 @@ uint32_t* array_base::uncompress(uint32_t len) const {
     return out;
 }
 
+void array_base::uncompress_into(uint32_t* out) const {
+    for_uncompress(in, out, length);
+}
+
 uint32_t array_base::getSizeInBytes() {
     return size_bytes;
 }
@@ -12,10 +12,18 @@
 #include <limits>
 #include <queue>
 #include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <atomic>
+#include <unordered_map>
 #include <stdint.h>
 #include <posting.h>
 #include "art.h"
+#include "art_allocator.h"
 #include "logger.h"
+#include "threadpool.h"
 
 /**
  * Macros to manipulate pointer tags
@@ -38,7 +46,8 @@ enum recurse_progress { RECURSE, ABORT, ITERATE };
 
 static void art_fuzzy_recurse(unsigned char p, unsigned char c, const art_node *n, int depth, const unsigned char *term,
                               const int term_len, const int* irow, const int* jrow, const int min_cost,
-                              const int max_cost, const bool prefix, std::vector<const art_node *> &results);
+                              const int max_cost, const bool prefix, const uint64_t filter_summary,
+                              std::vector<const art_node *> &results);
 
 void art_int_fuzzy_recurse(art_node *n, int depth, const unsigned char* int_str, int int_str_len,
                            NUM_COMPARATOR comparator, std::vector<const art_leaf *> &results);
@@ -99,29 +108,135 @@ bool compare_art_node_score_pq(const art_node* a, const art_node* b) {
  * Allocates a node of the given type,
  * initializes to zero and sets the type.
  */
-static art_node* alloc_node(uint8_t type) {
-    art_node* n;
-    switch (type) {
-        case NODE4:
-            n = (art_node *) calloc(1, sizeof(art_node4));
-            break;
-        case NODE16:
-            n = (art_node *) calloc(1, sizeof(art_node16));
-            break;
-        case NODE48:
-            n = (art_node *) calloc(1, sizeof(art_node48));
-            break;
-        case NODE256:
-            n = (art_node *) calloc(1, sizeof(art_node256));
-            break;
-        default:
-            abort();
-    }
+static art_node* alloc_node(art_allocator_t* allocator, uint8_t type) {
+    art_node* n = (art_node *) allocator->alloc_node(type);
     n->type = type;
     n->max_score = 0;
     return n;
 }
 
+static inline uint64_t id_summary_bit(uint32_t id) {
+    // documents indexed together get nearby IDs, so ranges of IDs share a bit
+    return uint64_t(1) << ((id >> ART_ID_SUMMARY_BLOCK_BITS) & 63);
+}
+
+static inline uint64_t node_id_summary(const art_node *n) {
+    return IS_LEAF(n) ? ((const art_leaf *) LEAF_RAW(n))->id_summary : n->id_summary;
+}
+
+// Summary of the filter IDs, or 0 when the filter is too broad for summaries to rule out any subtree
+static uint64_t filter_id_summary(const uint32_t *filter_ids, size_t filter_ids_length) {
+    uint64_t summary = 0;
+
+    for (size_t i = 0; i < filter_ids_length; i++) {
+        summary |= id_summary_bit(filter_ids[i]);
+        if (__builtin_popcountll(summary) > ART_ID_SUMMARY_MAX_FILTER_BITS) {
+            return 0;
+        }
+    }
+
+    return summary;
+}
+
+// Whether the subtree of a node cannot contain any of the filtered documents
+static inline bool pruned_by_filter(const art_node *n, const uint64_t filter_summary) {
+    return filter_summary != 0 && (node_id_summary(n) & filter_summary) == 0;
+}
+
+static void free_node(art_allocator_t* allocator, art_node* n) {
+    allocator->free_node(n, n->type);
+}
+
+static void free_leaf(art_allocator_t* allocator, art_leaf* l) {
+    allocator->free_leaf(l, l->key_len);
+}
+
+/**
+ * Top completions of short prefixes, kept sorted by the token ordering they were computed for.
+ * An entry that is not `complete` holds the best leaves of its prefix, but not every leaf.
+ * Entries are computed lazily by readers and kept up to date by writers.
+ */
+struct art_topk_cache_t {
+    struct entry_t {
+        std::vector<art_leaf*> leaves;
+        size_t capacity = 0;
+        bool complete = false;
+    };
+
+    size_t max_prefix_len = ART_TOPK_CACHE_MAX_PREFIX_LEN;
+
+    // readers copy entries out under a shared lock: only writers and readers that install an entry are exclusive
+    std::shared_mutex mutex;
+
+    // indexed by `topk_slot()`
+    std::unordered_map<std::string, entry_t> entries[2];
+};
+
+static inline size_t topk_slot(const token_ordering token_order) {
+    return (token_order == FREQUENCY) ? 0 : 1;
+}
+
+static inline int64_t topk_score(const art_leaf *l, const token_ordering token_order) {
+    return (token_order == FREQUENCY) ? posting_t::num_ids(l->values) : l->max_score;
+}
+
+static bool topk_cache_empty(art_topk_cache_t* cache) {
+    std::shared_lock<std::shared_mutex> lock(cache->mutex);
+    return cache->entries[0].empty() && cache->entries[1].empty();
+}
+
+static void topk_cache_remove(art_topk_cache_t* cache, const art_leaf *l) {
+    std::unique_lock<std::shared_mutex> lock(cache->mutex);
+    const size_t num_prefixes = std::min<size_t>(cache->max_prefix_len, l->key_len - 1);
+
+    for (size_t prefix_len = 1; prefix_len <= num_prefixes; prefix_len++) {
+        const std::string prefix((const char*) l->key, prefix_len);
+
+        for (auto& slot_entries: cache->entries) {
+            auto entry_it = slot_entries.find(prefix);
+            if (entry_it == slot_entries.end()) continue;
+
+            // the remaining leaves are still the best ones of the prefix
+            std::vector<art_leaf*>& leaves = entry_it->second.leaves;
+            leaves.erase(std::remove(leaves.begin(), leaves.end(), l), leaves.end());
+        }
+    }
+}
+
+static void topk_cache_update(art_topk_cache_t* cache, art_leaf *l) {
+    std::unique_lock<std::shared_mutex> lock(cache->mutex);
+    const size_t num_prefixes = std::min<size_t>(cache->max_prefix_len, l->key_len - 1);
+
+    for (size_t prefix_len = 1; prefix_len <= num_prefixes; prefix_len++) {
+        const std::string prefix((const char*) l->key, prefix_len);
+
+        for (size_t slot = 0; slot < 2; slot++) {
+            auto entry_it = cache->entries[slot].find(prefix);
+            if (entry_it == cache->entries[slot].end()) continue;
+
+            art_topk_cache_t::entry_t& entry = entry_it->second;
+            const token_ordering token_order = (slot == 0) ? FREQUENCY : MAX_SCORE;
+            const int64_t score = topk_score(l, token_order);
+
+            entry.leaves.erase(std::remove(entry.leaves.begin(), entry.leaves.end(), l), entry.leaves.end());
+
+            auto pos = std::find_if(entry.leaves.begin(), entry.leaves.end(), [&](const art_leaf* other) {
+                return topk_score(other, token_order) < score;
+            });
+
+            // beyond the last leaf of an incomplete entry, leaves that are not cached could rank higher
+            if (pos == entry.leaves.end() && !entry.complete) continue;
+
+            entry.leaves.insert(pos, l);
+
+            if (entry.leaves.size() > entry.capacity) {
+                entry.leaves.pop_back();
+                entry.complete = false;
+            }
+        }
+    }
+}
+
 /**
  * Initializes an ART tree
  * @return 0 on success.
@@ -129,11 +244,25 @@ static art_node* alloc_node(uint8_t type) {
 int art_tree_init(art_tree *t) {
     t->root = NULL;
     t->size = 0;
+    t->allocator = new art_allocator_t();
+    t->compacted_bytes_reserved = 0;
+    t->topk_cache = new art_topk_cache_t();
     return 0;
 }
 
+void art_set_topk_cache_prefix_len(art_tree *t, size_t max_prefix_len) {
+    std::unique_lock<std::shared_mutex> lock(t->topk_cache->mutex);
+    t->topk_cache->max_prefix_len = max_prefix_len;
+    t->topk_cache->entries[0].clear();
+    t->topk_cache->entries[1].clear();
+}
+
+void art_topk_update(art_tree *t, art_leaf *l) {
+    topk_cache_update(t->topk_cache, l);
+}
+
 // Recursively destroys the tree
-static void destroy_node(art_node *n) {
+static void destroy_node(art_allocator_t* allocator, art_node *n) {
     // Break if null
     if (!n) return;
 
@@ -141,7 +270,7 @@ static void destroy_node(art_node *n) {
     if (IS_LEAF(n)) {
         art_leaf *leaf = (art_leaf *) LEAF_RAW(n);
         posting_t::destroy_list(leaf->values);
-        free(leaf);
+        free_leaf(allocator, leaf);
         return;
     }
 
@@ -157,21 +286,21 @@ static void destroy_node(art_node *n) {
         case NODE4:
             p.p1 = (art_node4*)n;
             for (i=0;i<n->num_children;i++) {
-                destroy_node(p.p1->children[i]);
+                destroy_node(allocator, p.p1->children[i]);
             }
             break;
 
         case NODE16:
             p.p2 = (art_node16*)n;
             for (i=0;i<n->num_children;i++) {
-                destroy_node(p.p2->children[i]);
+                destroy_node(allocator, p.p2->children[i]);
             }
             break;
 
         case NODE48:
             p.p3 = (art_node48*)n;
             for (i=0;i<48;i++) {
-                destroy_node(p.p3->children[i]);
+                destroy_node(allocator, p.p3->children[i]);
             }
             break;
 
@@ -179,7 +308,7 @@ static void destroy_node(art_node *n) {
             p.p4 = (art_node256*)n;
             for (i=0;i<256;i++) {
                 if (p.p4->children[i])
-                    destroy_node(p.p4->children[i]);
+                    destroy_node(allocator, p.p4->children[i]);
             }
             break;
 
@@ -188,7 +317,7 @@ static void destroy_node(art_node *n) {
     }
 
     // Free ourself on the way up
-    free(n);
+    free_node(allocator, n);
 }
 
 /**
@@ -196,10 +325,125 @@ static void destroy_node(art_node *n) {
  * @return 0 on success.
  */
 int art_tree_destroy(art_tree *t) {
-    destroy_node(t->root);
+    destroy_node(t->allocator, t->root);
+    delete t->allocator;
+    t->allocator = NULL;
+    delete t->topk_cache;
+    t->topk_cache = NULL;
     return 0;
 }
 
+size_t art_bytes_in_use(const art_tree *t) {
+    return t->allocator->bytes_in_use();
+}
+
+size_t art_bytes_reserved(const art_tree *t) {
+    return t->allocator->bytes_reserved();
+}
+
+bool art_is_fragmented(const art_tree *t) {
+    // small trees are not worth compacting, and a compacted tree is left alone until it has doubled, so that
+    // its remaining slack does not trigger a compaction on every delete
+    const size_t reserved = t->allocator->bytes_reserved();
+    return reserved > 16 * art_allocator_t::MAX_SLAB_SIZE && reserved > 2 * t->compacted_bytes_reserved &&
+           reserved > 2 * t->allocator->bytes_in_use();
+}
+
+static size_t node_size(uint8_t type) {
+    switch (type) {
+        case NODE4:
+            return sizeof(art_node4);
+        case NODE16:
+            return sizeof(art_node16);
+        case NODE48:
+            return sizeof(art_node48);
+        case NODE256:
+            return sizeof(art_node256);
+        default:
+            abort();
+    }
+}
+
+// Copies a node and its descendants depth-first into `to`, so that children end up close to their parents
+static art_node* relocate_node(art_allocator_t* from, art_allocator_t* to, art_node *n) {
+    if (!n) return NULL;
+
+    if (IS_LEAF(n)) {
+        art_leaf *l = (art_leaf *) LEAF_RAW(n);
+        art_leaf *new_l = (art_leaf *) to->alloc_leaf(l->key_len);
+        memcpy(new_l, l, sizeof(art_leaf) + l->key_len);
+        free_leaf(from, l);
+
+        // drop the bits of documents that have been removed since the leaf was summarized
+        std::vector<uint32_t> ids;
+        posting_t::merge({new_l->values}, ids);
+        new_l->id_summary = 0;
+        for (uint32_t id: ids) {
+            new_l->id_summary |= id_summary_bit(id);
+        }
+
+        return (art_node *) SET_LEAF(new_l);
+    }
+
+    art_node *new_n = alloc_node(to, n->type);
+    memcpy(new_n, n, node_size(n->type));
+    new_n->id_summary = 0;
+
+    int i;
+    switch (n->type) {
+        case NODE4:
+            for (i=0;i<n->num_children;i++) {
+                ((art_node4*)new_n)->children[i] = relocate_node(from, to, ((art_node4*)n)->children[i]);
+                if ((((art_node4*)new_n)->children[i])) {
+                    new_n->id_summary |= node_id_summary(((art_node4*)new_n)->children[i]);
+                }
+            }
+            break;
+        case NODE16:
+            for (i=0;i<n->num_children;i++) {
+                ((art_node16*)new_n)->children[i] = relocate_node(from, to, ((art_node16*)n)->children[i]);
+                if ((((art_node16*)new_n)->children[i])) {
+                    new_n->id_summary |= node_id_summary(((art_node16*)new_n)->children[i]);
+                }
+            }
+            break;
+        case NODE48:
+            for (i=0;i<48;i++) {
+                ((art_node48*)new_n)->children[i] = relocate_node(from, to, ((art_node48*)n)->children[i]);
+                if ((((art_node48*)new_n)->children[i])) {
+                    new_n->id_summary |= node_id_summary(((art_node48*)new_n)->children[i]);
+                }
+            }
+            break;
+        case NODE256:
+            for (i=0;i<256;i++) {
+                ((art_node256*)new_n)->children[i] = relocate_node(from, to, ((art_node256*)n)->children[i]);
+                if ((((art_node256*)new_n)->children[i])) {
+                    new_n->id_summary |= node_id_summary(((art_node256*)new_n)->children[i]);
+                }
+            }
+            break;
+        default:
+            abort();
+    }
+
+    free_node(from, n);
+    return new_n;
+}
+
+void art_compact(art_tree *t) {
+    art_allocator_t* allocator = new art_allocator_t();
+    t->root = relocate_node(t->allocator, allocator, t->root);
+    delete t->allocator;
+    t->allocator = allocator;
+    t->compacted_bytes_reserved = allocator->bytes_reserved();
+
+    // cached completions point to the old leaves
+    std::unique_lock<std::shared_mutex> lock(t->topk_cache->mutex);
+    t->topk_cache->entries[0].clear();
+    t->topk_cache->entries[1].clear();
+}
+
 /**
  * Returns the size of the ART tree.
  */
@@ -271,6 +515,28 @@ static art_node** find_child(art_node *n, unsigned char c) {
     return NULL;
 }
 
+/**
+ * Builds a bitmap of the key bytes that have a child in a node48 by comparing 16 keys at a time,
+ * so that children can be visited with bit scans instead of probing all 256 key slots.
+ */
+static inline void node48_key_bitmap(const art_node48 *n, uint64_t bitmap[4]) {
+    const __m128i zero = _mm_setzero_si128();
+
+    for (int i = 0; i < 4; i++) {
+        uint64_t bits = 0;
+        for (int j = 0; j < 4; j++) {
+            __m128i keys = _mm_loadu_si128((const __m128i*)(n->keys + i*64 + j*16));
+            unsigned empty = _mm_movemask_epi8(_mm_cmpeq_epi8(keys, zero));
+            bits |= uint64_t(~empty & 0xFFFF) << (j*16);
+        }
+        bitmap[i] = bits;
+    }
+}
+
+static inline void prefetch_node(const art_node *n) {
+    __builtin_prefetch(LEAF_RAW(n));
+}
+
 // Simple inlined if
 static inline int min(int a, int b) {
     return (a < b) ? a : b;
@@ -303,6 +569,43 @@ static int leaf_matches(const art_leaf *n, const unsigned char *key, int key_len
     return memcmp(n->key, key, key_len);
 }
 
+/**
+ * Advances a lookup by one node. Returns the next node to visit, or NULL when the lookup has ended,
+ * in which case `leaf` is set if the key was found.
+ */
+static inline art_node* search_step(art_node *n, const unsigned char *key, int key_len, int& depth,
+                                    art_leaf*& leaf) {
+    // Might be a leaf
+    if (IS_LEAF(n)) {
+        art_leaf *l = (art_leaf *) LEAF_RAW(n);
+        // Check if the expanded path matches
+        if (!leaf_matches(l, key, key_len, depth)) {
+            leaf = l;
+        }
+        return NULL;
+    }
+
+    // Bail if the prefix does not match
+    if (n->partial_len) {
+        int prefix_len = check_prefix(n, key, key_len, depth);
+        if (prefix_len != min(MAX_PREFIX_LEN, n->partial_len)) {
+            return NULL;
+        }
+
+        depth = depth + n->partial_len;
+        if(depth >= key_len) {
+            return NULL;
+        }
+    }
+
+    assert(depth < key_len);
+
+    // Recursively search
+    art_node **child = find_child(n, key[depth]);
+    depth++;
+    return (child) ? *child : NULL;
+}
+
 /**
  * Searches for a value in the ART tree
  * @arg t The tree
@@ -312,41 +615,47 @@ static int leaf_matches(const art_leaf *n, const unsigned char *key, int key_len
  * the value pointer is returned.
  */
 void* art_search(const art_tree *t, const unsigned char *key, int key_len) {
-    art_node **child;
     art_node *n = t->root;
-    int prefix_len, depth = 0;
+    art_leaf *leaf = NULL;
+    int depth = 0;
     while (n) {
-        // Might be a leaf
-        if (IS_LEAF(n)) {
-            n = (art_node *) LEAF_RAW(n);
-            // Check if the expanded path matches
-            if (!leaf_matches((art_leaf*)n, key, key_len, depth)) {
-                return ((art_leaf*)n);
-            }
-            return NULL;
-        }
+        n = search_step(n, key, key_len, depth, leaf);
+    }
+    return leaf;
+}
 
-        // Bail if the prefix does not match
-        if (n->partial_len) {
-            prefix_len = check_prefix(n, key, key_len, depth);
-            if (prefix_len != min(MAX_PREFIX_LEN, n->partial_len)) {
-                return NULL;
-            }
+void art_search_batch(const art_tree *t, const unsigned char* const* keys, const int* key_lens, size_t num_keys,
+                      art_leaf** leaves) {
+    art_node *nodes[ART_SEARCH_BATCH_WIDTH];
+    int depths[ART_SEARCH_BATCH_WIDTH];
 
-            depth = depth + n->partial_len;
-            if(depth >= key_len) {
-                return NULL;
-            }
+    for (size_t batch_start = 0; batch_start < num_keys; batch_start += ART_SEARCH_BATCH_WIDTH) {
+        const size_t batch_size = std::min<size_t>(ART_SEARCH_BATCH_WIDTH, num_keys - batch_start);
+
+        for (size_t i = 0; i < batch_size; i++) {
+            nodes[i] = t->root;
+            depths[i] = 0;
+            leaves[batch_start + i] = NULL;
         }
 
-        assert(depth < key_len);
+        // advance every lookup by one node per round: the node that a lookup will visit next is prefetched
+        // while the other lookups of the batch are being advanced
+        size_t num_active = batch_size;
+        while (num_active != 0) {
+            num_active = 0;
+            for (size_t i = 0; i < batch_size; i++) {
+                if (!nodes[i]) continue;
 
-        // Recursively search
-        child = find_child(n, key[depth]);
-        n = (child) ? *child : NULL;
-        depth++;
+                const size_t k = batch_start + i;
+                nodes[i] = search_step(nodes[i], keys[k], key_lens[k], depths[i], leaves[k]);
+
+                if (nodes[i]) {
+                    prefetch_node(nodes[i]);
+                    num_active++;
+                }
+            }
+        }
     }
-    return NULL;
 }
 
 // Find the minimum leaf under a node
@@ -361,11 +670,14 @@ static art_leaf* minimum(const art_node *n) {
             return minimum(((art_node4*)n)->children[0]);
         case NODE16:
             return minimum(((art_node16*)n)->children[0]);
-        case NODE48:
+        case NODE48: {
+            uint64_t bitmap[4];
+            node48_key_bitmap((const art_node48*)n, bitmap);
             idx=0;
-            while (!((art_node48*)n)->keys[idx]) idx++;
-            idx = ((art_node48*)n)->keys[idx] - 1;
+            while (!bitmap[idx]) idx++;
+            idx = ((art_node48*)n)->keys[idx*64 + __builtin_ctzll(bitmap[idx])] - 1;
             return minimum(((art_node48*)n)->children[idx]);
+        }
         case NODE256:
             idx=0;
             while (!((art_node256*)n)->children[idx]) idx++;
@@ -387,11 +699,14 @@ static art_leaf* maximum(const art_node *n) {
             return maximum(((art_node4*)n)->children[n->num_children-1]);
         case NODE16:
             return maximum(((art_node16*)n)->children[n->num_children-1]);
-        case NODE48:
-            idx=255;
-            while (!((art_node48*)n)->keys[idx]) idx--;
-            idx = ((art_node48*)n)->keys[idx] - 1;
+        case NODE48: {
+            uint64_t bitmap[4];
+            node48_key_bitmap((const art_node48*)n, bitmap);
+            idx=3;
+            while (!bitmap[idx]) idx--;
+            idx = ((art_node48*)n)->keys[idx*64 + 63 - __builtin_clzll(bitmap[idx])] - 1;
             return maximum(((art_node48*)n)->children[idx]);
+        }
         case NODE256:
             idx=255;
             while (!((art_node256*)n)->children[idx]) idx--;
@@ -417,6 +732,7 @@ art_leaf* art_maximum(art_tree *t) {
 
 static void add_document_to_leaf(art_document *document, art_leaf *leaf) {
     leaf->max_score = MAX(leaf->max_score, document->score);
+    leaf->id_summary |= id_summary_bit(document->id);
     posting_t::upsert(leaf->values, document->id, document->offsets);
 
     if(document->score == USE_FREQUENCY_SCORE) {
@@ -424,10 +740,62 @@ static void add_document_to_leaf(art_document *document, art_leaf *leaf) {
     }
 }
 
-static art_leaf* make_leaf(const unsigned char *key, uint32_t key_len, art_document *document) {
-    art_leaf *l = (art_leaf *) malloc(sizeof(art_leaf) + key_len);
+// Adds `documents[begin..]` to a leaf: documents that are sorted by ID and come after the last ID of the leaf
+// (as they do on startup and on bulk imports) are appended to its posting list in one go
+static void add_documents_to_leaf(std::vector<art_document>& documents, size_t begin, art_leaf *leaf) {
+    if (documents.size() - begin < 2) {
+        for (size_t i = begin; i < documents.size(); i++) {
+            add_document_to_leaf(&documents[i], leaf);
+        }
+        return;
+    }
+
+    bool appendable = (posting_t::num_ids(leaf->values) == 0 ||
+                       posting_t::last_id(leaf->values) < documents[begin].id);
+
+    for (size_t i = begin + 1; appendable && i < documents.size(); i++) {
+        appendable = (documents[i - 1].id < documents[i].id);
+    }
+
+    if (!appendable) {
+        for (size_t i = begin; i < documents.size(); i++) {
+            add_document_to_leaf(&documents[i], leaf);
+        }
+        return;
+    }
+
+    std::vector<uint32_t> ids, offset_index, offsets;
+    ids.reserve(documents.size() - begin);
+    offset_index.reserve(documents.size() - begin);
+
+    uint32_t num_ids = posting_t::num_ids(leaf->values);
+
+    for (size_t i = begin; i < documents.size(); i++) {
+        const art_document& document = documents[i];
+        ids.push_back(document.id);
+        offset_index.push_back(offsets.size());
+        offsets.insert(offsets.end(), document.offsets.begin(), document.offsets.end());
+
+        // same scores as adding the documents one by one
+        leaf->max_score = MAX(leaf->max_score, document.score);
+        leaf->id_summary |= id_summary_bit(document.id);
+        num_ids++;
+
+        if (document.score == USE_FREQUENCY_SCORE) {
+            leaf->max_score = num_ids;
+        }
+    }
+
+    posting_t::append_sorted(leaf->values, ids.data(), offset_index.data(), ids.size(),
+                             offsets.data(), offsets.size());
+}
+
+static art_leaf* make_leaf(art_allocator_t* allocator, const unsigned char *key, uint32_t key_len,
+                           art_document *document) {
+    art_leaf *l = (art_leaf *) allocator->alloc_leaf(key_len);
     l->key_len = key_len;
     l->max_score = 0;
+    l->id_summary = 0;
 
     uint32_t ids[1] = {document->id};
     uint32_t offset_index[1] = {0};
@@ -461,17 +829,18 @@ static void copy_header(art_node *dest, art_node *src) {
     dest->num_children = src->num_children;
     dest->partial_len = src->partial_len;
     dest->max_score = src->max_score;
+    dest->id_summary = src->id_summary;
     memcpy(dest->partial, src->partial, min(MAX_PREFIX_LEN, src->partial_len));
 }
 
-static void add_child256(art_node256 *n, art_node **ref, unsigned char c, void *child) {
+static void add_child256(art_allocator_t* allocator, art_node256 *n, art_node **ref, unsigned char c, void *child) {
     (void)ref;
     n->n.num_children++;
     n->children[c] = (art_node *) child;
     n->n.max_score = MAX(n->n.max_score, ((art_leaf *) LEAF_RAW(child))->max_score);
 }
 
-static void add_child48(art_node48 *n, art_node **ref, unsigned char c, void *child) {
+static void add_child48(art_allocator_t* allocator, art_node48 *n, art_node **ref, unsigned char c, void *child) {
     if (n->n.num_children < 48) {
         int pos = 0;
         while (n->children[pos]) pos++;
@@ -480,7 +849,7 @@ static void add_child48(art_node48 *n, art_node **ref, unsigned char c, void *ch
         n->n.num_children++;
         n->n.max_score = MAX(n->n.max_score, ((art_leaf *) LEAF_RAW(child))->max_score);
     } else {
-        art_node256 *new_n = (art_node256*)alloc_node(NODE256);
+        art_node256 *new_n = (art_node256*)alloc_node(allocator, NODE256);
         for (int i=0;i<256;i++) {
             if (n->keys[i]) {
                 new_n->children[i] = n->children[n->keys[i] - 1];
@@ -488,12 +857,12 @@ static void add_child48(art_node48 *n, art_node **ref, unsigned char c, void *ch
         }
         copy_header((art_node*)new_n, (art_node*)n);
         *ref = (art_node*)new_n;
-        free(n);
-        add_child256(new_n, ref, c, child);
+        free_node(allocator, (art_node*) n);
+        add_child256(allocator, new_n, ref, c, child);
     }
 }
 
-static void add_child16(art_node16 *n, art_node **ref, unsigned char c, void *child) {
+static void add_child16(art_allocator_t* allocator, art_node16 *n, art_node **ref, unsigned char c, void *child) {
     if (n->n.num_children < 16) {
         __m128i cmp;
 
@@ -522,7 +891,7 @@ static void add_child16(art_node16 *n, art_node **ref, unsigned char c, void *ch
         n->n.max_score = MAX(n->n.max_score, ((art_leaf *) LEAF_RAW(child))->max_score);
 
     } else {
-        art_node48 *new_n = (art_node48*)alloc_node(NODE48);
+        art_node48 *new_n = (art_node48*)alloc_node(allocator, NODE48);
 
         // Copy the child pointers and populate the key map
         memcpy(new_n->children, n->children,
@@ -532,12 +901,12 @@ static void add_child16(art_node16 *n, art_node **ref, unsigned char c, void *ch
         }
         copy_header((art_node*)new_n, (art_node*)n);
         *ref = (art_node*)new_n;
-        free(n);
-        add_child48(new_n, ref, c, child);
+        free_node(allocator, (art_node*) n);
+        add_child48(allocator, new_n, ref, c, child);
     }
 }
 
-static void add_child4(art_node4 *n, art_node **ref, unsigned char c, void *child) {
+static void add_child4(art_allocator_t* allocator, art_node4 *n, art_node **ref, unsigned char c, void *child) {
     if (n->n.num_children < 4) {
         int idx;
         for (idx=0; idx < n->n.num_children; idx++) {
@@ -555,7 +924,7 @@ static void add_child4(art_node4 *n, art_node **ref, unsigned char c, void *chil
         n->n.max_score = MAX(n->n.max_score, ((art_leaf *) LEAF_RAW(child))->max_score);
 
     } else {
-        art_node16 *new_n = (art_node16*)alloc_node(NODE16);
+        art_node16 *new_n = (art_node16*)alloc_node(allocator, NODE16);
 
         // Copy the child pointers and the key map
         memcpy(new_n->children, n->children,
@@ -564,21 +933,21 @@ static void add_child4(art_node4 *n, art_node **ref, unsigned char c, void *chil
                 sizeof(unsigned char)*n->n.num_children);
         copy_header((art_node*)new_n, (art_node*)n);
         *ref = (art_node*)new_n;
-        free(n);
-        add_child16(new_n, ref, c, child);
+        free_node(allocator, (art_node*) n);
+        add_child16(allocator, new_n, ref, c, child);
     }
 }
 
-static void add_child(art_node *n, art_node **ref, unsigned char c, void *child) {
+static void add_child(art_allocator_t* allocator, art_node *n, art_node **ref, unsigned char c, void *child) {
     switch (n->type) {
         case NODE4:
-            return add_child4((art_node4*)n, ref, c, child);
+            return add_child4(allocator, (art_node4*)n, ref, c, child);
         case NODE16:
-            return add_child16((art_node16*)n, ref, c, child);
+            return add_child16(allocator, (art_node16*)n, ref, c, child);
         case NODE48:
-            return add_child48((art_node48*)n, ref, c, child);
+            return add_child48(allocator, (art_node48*)n, ref, c, child);
         case NODE256:
-            return add_child256((art_node256*)n, ref, c, child);
+            return add_child256(allocator, (art_node256*)n, ref, c, child);
         default:
             abort();
     }
@@ -608,15 +977,14 @@ static int prefix_mismatch(const art_node *n, const unsigned char *key, int key_
     return idx;
 }
 
-static void* recursive_insert(art_node* n, art_node** ref, const unsigned char* key, uint32_t key_len,
-                              const int64_t docs_max_score, std::vector<art_document>& documents, int depth,
+static void* recursive_insert(art_allocator_t* allocator, art_node* n, art_node** ref, const unsigned char* key, uint32_t key_len,
+                              const int64_t docs_max_score, const uint64_t docs_id_summary,
+                              std::vector<art_document>& documents, int depth,
                               std::list<art_node*>& path, int* old) {
     // If we are at a NULL node, inject a leaf
     if (!n) {
-        art_leaf* new_leaf = make_leaf(key, key_len, &documents[0]);
-        for(size_t i = 1; i < documents.size(); i++) {
-            add_document_to_leaf(&documents[i], new_leaf);
-        }
+        art_leaf* new_leaf = make_leaf(allocator, key, key_len, &documents[0]);
+        add_documents_to_leaf(documents, 1, new_leaf);
 
         *ref = (art_node*)SET_LEAF(new_leaf);
         return NULL;
@@ -629,30 +997,27 @@ static void* recursive_insert(art_node* n, art_node** ref, const unsigned char*
         // Check if we are updating an existing value
         if (!leaf_matches(l, key, key_len, depth)) {
             *old = 1;
-            for(size_t i = 0; i < documents.size(); i++) {
-                add_document_to_leaf(&documents[i], l);
-            }
+            add_documents_to_leaf(documents, 0, l);
             return l->values;
         }
 
         // New value, we must split the leaf into a node4
-        art_node4 *new_n = (art_node4*)alloc_node(NODE4);
+        art_node4 *new_n = (art_node4*)alloc_node(allocator, NODE4);
 
         // Create a new leaf
-        art_leaf *l2 = make_leaf(key, key_len, &documents[0]);
+        art_leaf *l2 = make_leaf(allocator, key, key_len, &documents[0]);
 
         uint32_t longest_prefix = longest_common_prefix(l, l2, depth);
         new_n->n.partial_len = longest_prefix;
         memcpy(new_n->n.partial, key+depth, min(MAX_PREFIX_LEN, longest_prefix));
 
-        for(size_t i = 1; i < documents.size(); i++) {
-            add_document_to_leaf(&documents[i], l2);
-        }
+        add_documents_to_leaf(documents, 1, l2);
 
         // Add the leafs to the new node4
+        new_n->n.id_summary = l->id_summary | l2->id_summary;
         *ref = (art_node*)new_n;
-        add_child4(new_n, ref, l->key[depth+longest_prefix], SET_LEAF(l));
-        add_child4(new_n, ref, l2->key[depth+longest_prefix], SET_LEAF(l2));
+        add_child4(allocator, new_n, ref, l->key[depth+longest_prefix], SET_LEAF(l));
+        add_child4(allocator, new_n, ref, l2->key[depth+longest_prefix], SET_LEAF(l2));
         return NULL;
     }
 
@@ -660,6 +1025,8 @@ static void* recursive_insert(art_node* n, art_node** ref, const unsigned char*
         n->max_score = MAX(n->max_score, docs_max_score);
     }
 
+    n->id_summary |= docs_id_summary;
+
     // Check if given node has a prefix
     if (n->partial_len) {
         // Determine if the prefixes differ, since we need to split
@@ -670,32 +1037,31 @@ static void* recursive_insert(art_node* n, art_node** ref, const unsigned char*
         }
 
         // Create a new node
-        art_node4 *new_n = (art_node4*)alloc_node(NODE4);
+        art_node4 *new_n = (art_node4*)alloc_node(allocator, NODE4);
         *ref = (art_node*)new_n;
+        new_n->n.id_summary = n->id_summary;
         new_n->n.partial_len = prefix_diff;
         memcpy(new_n->n.partial, n->partial, min(MAX_PREFIX_LEN, prefix_diff));
 
         // Adjust the prefix of the old node
         if (n->partial_len <= MAX_PREFIX_LEN) {
-            add_child4(new_n, ref, n->partial[prefix_diff], n);
+            add_child4(allocator, new_n, ref, n->partial[prefix_diff], n);
             n->partial_len -= (prefix_diff+1);
             memmove(n->partial, n->partial+prefix_diff+1,
                     min(MAX_PREFIX_LEN, n->partial_len));
         } else {
             n->partial_len -= (prefix_diff+1);
             art_leaf *l = minimum(n);
-            add_child4(new_n, ref, l->key[depth+prefix_diff], n);
+            add_child4(allocator, new_n, ref, l->key[depth+prefix_diff], n);
             memcpy(n->partial, l->key+depth+prefix_diff+1,
                    min(MAX_PREFIX_LEN, n->partial_len));
         }
 
         // Insert the new leaf
-        art_leaf *l = make_leaf(key, key_len, &documents[0]);
-        for(size_t i = 1; i < documents.size(); i++) {
-            add_document_to_leaf(&documents[i], l);
-        }
+        art_leaf *l = make_leaf(allocator, key, key_len, &documents[0]);
+        add_documents_to_leaf(documents, 1, l);
 
-        add_child4(new_n, ref, key[depth+prefix_diff], SET_LEAF(l));
+        add_child4(allocator, new_n, ref, key[depth+prefix_diff], SET_LEAF(l));
         path.push_back(*ref);
         return NULL;
     }
@@ -705,16 +1071,15 @@ static void* recursive_insert(art_node* n, art_node** ref, const unsigned char*
     // Find a child to recurse to
     art_node **child = find_child(n, key[depth]);
     if (child) {
-        return recursive_insert(*child, child, key, key_len, docs_max_score, documents, depth + 1, path, old);
+        return recursive_insert(allocator, *child, child, key, key_len, docs_max_score, docs_id_summary, documents,
+                                depth + 1, path, old);
     }
 
     // No child, node goes within us
-    art_leaf *l = make_leaf(key, key_len, &documents[0]);
-    for(size_t i = 1; i < documents.size(); i++) {
-        add_document_to_leaf(&documents[i], l);
-    }
+    art_leaf *l = make_leaf(allocator, key, key_len, &documents[0]);
+    add_documents_to_leaf(documents, 1, l);
 
-    add_child(n, ref, key[depth], SET_LEAF(l));
+    add_child(allocator, n, ref, key[depth], SET_LEAF(l));
     path.push_back(*ref);
     return NULL;
 }
@@ -733,32 +1098,172 @@ void* art_insert(art_tree *t, const unsigned char *key, int key_len, art_documen
     return art_inserts(t, key, key_len, document->score, documents);
 }
 
-void* art_inserts(art_tree *t, const unsigned char *key, int key_len, const int64_t docs_max_score,
-                  std::vector<art_document>& documents) {
-    int old_val = 0;
-
+// Inserts the documents of a key into the subtree at `n`, which is found at `depth` of the key
+static void* insert_documents(art_tree *t, art_node *n, art_node **ref, int depth,
+                              const unsigned char *key, int key_len, const int64_t docs_max_score,
+                              std::vector<art_document>& documents, int* old_val) {
     std::list<art_node*> path;
     bool frequency_based_ordering = (docs_max_score == USE_FREQUENCY_SCORE);
-    void *old = recursive_insert(t->root, &t->root, key, key_len, docs_max_score, documents, 0, path, &old_val);
-    if (!old_val) t->size++;
+
+    uint64_t docs_id_summary = 0;
+    for(const auto& document: documents) {
+        docs_id_summary |= id_summary_bit(document.id);
+    }
+
+    void *old = recursive_insert(t->allocator, n, ref, key, key_len, docs_max_score, docs_id_summary,
+                                 documents, depth, path, old_val);
+
+    if (key_len > 1 && !topk_cache_empty(t->topk_cache)) {
+        art_leaf* leaf = (art_leaf*) art_search(t, key, key_len);
+        topk_cache_update(t->topk_cache, leaf);
+    }
 
     if(frequency_based_ordering) {
-        for(art_node* n: path) {
-            n->max_score = MAX(n->max_score, docs_max_score);
+        for(art_node* path_node: path) {
+            path_node->max_score = MAX(path_node->max_score, docs_max_score);
         }
     }
 
     return old;
 }
 
-static void remove_child256(art_node256 *n, art_node **ref, unsigned char c) {
+void* art_inserts(art_tree *t, const unsigned char *key, int key_len, const int64_t docs_max_score,
+                  std::vector<art_document>& documents) {
+    int old_val = 0;
+    void *old = insert_documents(t, t->root, &t->root, 0, key, key_len, docs_max_score, documents, &old_val);
+    if (!old_val) t->size++;
+    return old;
+}
+
+// Whether the children of the root hold the keys of each first byte apart
+static inline bool root_partitions_keys(const art_tree *t) {
+    return t->root != NULL && !IS_LEAF(t->root) && t->root->partial_len == 0;
+}
+
+void art_inserts_batch(art_tree *t, std::vector<art_key_documents>& keys, const int64_t docs_max_score,
+                       ThreadPool* thread_pool) {
+    if (thread_pool == nullptr || keys.size() < ART_PARALLEL_INSERT_MIN_KEYS) {
+        for (auto& key: keys) {
+            art_inserts(t, key.key, key.key_len, docs_max_score, *key.documents);
+        }
+        return;
+    }
+
+    std::vector<std::vector<art_key_documents*>> first_byte_keys(256);
+    for (auto& key: keys) {
+        first_byte_keys[key.key[0]].push_back(&key);
+    }
+
+    // A group of keys can only be inserted on its own once the root has a child for its first byte:
+    // the first key of a group without one is inserted upfront to create it.
+    std::vector<size_t> group_begins(256, 0);
+
+    for (size_t c = 0; c < 256; c++) {
+        if (first_byte_keys[c].empty()) continue;
+
+        if (!root_partitions_keys(t) || find_child(t->root, c) == NULL) {
+            art_key_documents* key = first_byte_keys[c][0];
+            art_inserts(t, key->key, key->key_len, docs_max_score, *key->documents);
+            group_begins[c] = 1;
+        }
+    }
+
+    if (!root_partitions_keys(t)) {
+        // all keys share their first byte
+        for (size_t c = 0; c < 256; c++) {
+            for (size_t i = group_begins[c]; i < first_byte_keys[c].size(); i++) {
+                art_key_documents* key = first_byte_keys[c][i];
+                art_inserts(t, key->key, key->key_len, docs_max_score, *key->documents);
+            }
+        }
+        return;
+    }
+
+    // Groups are claimed by the calling thread and the helpers in order of size, so the largest groups start
+    // first. Helpers that get to run only after every group was claimed have nothing left to touch, which
+    // also means that the caller never waits on a task that is still queued behind it.
+    struct batch_state_t {
+        std::vector<std::vector<art_key_documents*>> groups;
+        std::atomic<size_t> next_group{0};
+        std::atomic<uint64_t> num_new_keys{0};
+        std::atomic<uint64_t> id_summary{0};
+        size_t num_done = 0;
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+
+    auto state = std::make_shared<batch_state_t>();
+
+    for (size_t c = 0; c < 256; c++) {
+        if (group_begins[c] < first_byte_keys[c].size()) {
+            state->groups.emplace_back(first_byte_keys[c].begin() + group_begins[c], first_byte_keys[c].end());
+        }
+    }
+
+    std::sort(state->groups.begin(), state->groups.end(), [](const std::vector<art_key_documents*>& a,
+                                                             const std::vector<art_key_documents*>& b) {
+        return a.size() > b.size();
+    });
+
+    auto insert_groups = [state, t, docs_max_score]() {
+        size_t group_index;
+
+        while ((group_index = state->next_group++) < state->groups.size()) {
+            const std::vector<art_key_documents*>& group = state->groups[group_index];
+
+            // the root itself is left untouched until every group is done
+            art_node **child = find_child(t->root, group[0]->key[0]);
+            uint64_t num_new_keys = 0;
+            uint64_t id_summary = 0;
+
+            for (art_key_documents* key: group) {
+                int old_val = 0;
+                insert_documents(t, *child, child, 1, key->key, key->key_len, docs_max_score, *key->documents,
+                                 &old_val);
+                num_new_keys += !old_val;
+
+                for (const auto& document: *key->documents) {
+                    id_summary |= id_summary_bit(document.id);
+                }
+            }
+
+            state->num_new_keys += num_new_keys;
+            state->id_summary |= id_summary;
+
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->num_done++;
+            state->cv.notify_all();
+        }
+    };
+
+    const size_t num_helpers = std::min<size_t>(ART_PARALLEL_INSERT_CONCURRENCY, state->groups.size()) - 1;
+    for (size_t i = 0; i < num_helpers; i++) {
+        thread_pool->enqueue(insert_groups);
+    }
+
+    insert_groups();
+
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->cv.wait(lock, [&state]() { return state->num_done == state->groups.size(); });
+    }
+
+    t->size += state->num_new_keys;
+    t->root->id_summary |= state->id_summary;
+
+    if (docs_max_score != USE_FREQUENCY_SCORE) {
+        t->root->max_score = MAX(t->root->max_score, docs_max_score);
+    }
+}
+
+static void remove_child256(art_allocator_t* allocator, art_node256 *n, art_node **ref, unsigned char c) {
     n->children[c] = NULL;
     n->n.num_children--;
 
     // Resize to a node48 on underflow, not immediately to prevent
     // trashing if we sit on the 48/49 boundary
     if (n->n.num_children == 37) {
-        art_node48 *new_n = (art_node48*)alloc_node(NODE48);
+        art_node48 *new_n = (art_node48*)alloc_node(allocator, NODE48);
         *ref = (art_node*)new_n;
         copy_header((art_node*)new_n, (art_node*)n);
 
@@ -770,18 +1275,18 @@ static void remove_child256(art_node256 *n, art_node **ref, unsigned char c) {
                 pos++;
             }
         }
-        free(n);
+        free_node(allocator, (art_node*) n);
     }
 }
 
-static void remove_child48(art_node48 *n, art_node **ref, unsigned char c) {
+static void remove_child48(art_allocator_t* allocator, art_node48 *n, art_node **ref, unsigned char c) {
     int pos = n->keys[c];
     n->keys[c] = 0;
     n->children[pos-1] = NULL;
     n->n.num_children--;
 
     if (n->n.num_children == 12) {
-        art_node16 *new_n = (art_node16*)alloc_node(NODE16);
+        art_node16 *new_n = (art_node16*)alloc_node(allocator, NODE16);
         *ref = (art_node*)new_n;
         copy_header((art_node*)new_n, (art_node*)n);
 
@@ -794,27 +1299,27 @@ static void remove_child48(art_node48 *n, art_node **ref, unsigned char c) {
                 child++;
             }
         }
-        free(n);
+        free_node(allocator, (art_node*) n);
     }
 }
 
-static void remove_child16(art_node16 *n, art_node **ref, art_node **l) {
+static void remove_child16(art_allocator_t* allocator, art_node16 *n, art_node **ref, art_node **l) {
     int pos = l - n->children;
     memmove(n->keys+pos, n->keys+pos+1, n->n.num_children - 1 - pos);
     memmove(n->children+pos, n->children+pos+1, (n->n.num_children - 1 - pos)*sizeof(void*));
     n->n.num_children--;
 
     if (n->n.num_children == 3) {
-        art_node4 *new_n = (art_node4*)alloc_node(NODE4);
+        art_node4 *new_n = (art_node4*)alloc_node(allocator, NODE4);
         *ref = (art_node*)new_n;
         copy_header((art_node*)new_n, (art_node*)n);
         memcpy(new_n->keys, n->keys, 4);
         memcpy(new_n->children, n->children, 4*sizeof(void*));
-        free(n);
+        free_node(allocator, (art_node*) n);
     }
 }
 
-static void remove_child4(art_node4 *n, art_node **ref, art_node **l) {
+static void remove_child4(art_allocator_t* allocator, art_node4 *n, art_node **ref, art_node **l) {
     int pos = l - n->children;
     memmove(n->keys+pos, n->keys+pos+1, n->n.num_children - 1 - pos);
     memmove(n->children+pos, n->children+pos+1, (n->n.num_children - 1 - pos)*sizeof(void*));
@@ -841,26 +1346,27 @@ static void remove_child4(art_node4 *n, art_node **ref, art_node **l) {
             child->partial_len += n->n.partial_len + 1;
         }
         *ref = child;
-        free(n);
+        free_node(allocator, (art_node*) n);
     }
 }
 
-static void remove_child(art_node *n, art_node **ref, unsigned char c, art_node **l) {
+static void remove_child(art_allocator_t* allocator, art_node *n, art_node **ref, unsigned char c, art_node **l) {
     switch (n->type) {
         case NODE4:
-            return remove_child4((art_node4*)n, ref, l);
+            return remove_child4(allocator, (art_node4*)n, ref, l);
         case NODE16:
-            return remove_child16((art_node16*)n, ref, l);
+            return remove_child16(allocator, (art_node16*)n, ref, l);
         case NODE48:
-            return remove_child48((art_node48*)n, ref, c);
+            return remove_child48(allocator, (art_node48*)n, ref, c);
         case NODE256:
-            return remove_child256((art_node256*)n, ref, c);
+            return remove_child256(allocator, (art_node256*)n, ref, c);
         default:
             abort();
     }
 }
 
-static art_leaf* recursive_delete(art_node *n, art_node **ref, const unsigned char *key, int key_len, int depth) {
+static art_leaf* recursive_delete(art_allocator_t* allocator, art_node *n, art_node **ref,
+                                  const unsigned char *key, int key_len, int depth) {
     // Search terminated
     if (!n) return NULL;
 
@@ -896,14 +1402,14 @@ static art_leaf* recursive_delete(art_node *n, art_node **ref, const unsigned ch
     if (IS_LEAF(*child)) {
         art_leaf *l = (art_leaf *) LEAF_RAW(*child);
         if (!leaf_matches(l, key, key_len, depth)) {
-            remove_child(n, ref, key[depth], child);
+            remove_child(allocator, n, ref, key[depth], child);
             return l;
         }
         return NULL;
 
         // Recurse
     } else {
-        return recursive_delete(*child, child, key, key_len, depth+1);
+        return recursive_delete(allocator, *child, child, key, key_len, depth+1);
     }
 }
 
@@ -916,11 +1422,12 @@ static art_leaf* recursive_delete(art_node *n, art_node **ref, const unsigned ch
  * the value pointer is returned.
  */
 void* art_delete(art_tree *t, const unsigned char *key, int key_len) {
-    art_leaf *l = recursive_delete(t->root, &t->root, key, key_len, 0);
+    art_leaf *l = recursive_delete(t->allocator, t->root, &t->root, key, key_len, 0);
     if (l) {
         t->size--;
         void *old = l->values;
-        free(l);
+        topk_cache_remove(t->topk_cache, l);
+        free_leaf(t->allocator, l);
         return old;
     }
     return NULL;
@@ -936,7 +1443,7 @@ void* art_delete(art_tree *t, const unsigned char *key, int key_len) {
 }*/
 
 int art_topk_iter(const art_node *root, token_ordering token_order, size_t max_results,
-                  const uint32_t* filter_ids, size_t filter_ids_length,
+                  const uint32_t* filter_ids, size_t filter_ids_length, const uint64_t filter_summary,
                   const std::set<art_leaf*>& exclude_leaves, std::vector<art_leaf *> &results) {
     printf("INSIDE art_topk_iter: root->type: %d\n", root->type);
 
@@ -964,6 +1471,8 @@ int art_topk_iter(const art_node *root, token_ordering token_order, size_t max_r
         }*/
 
         if (!n) continue;
+        if (pruned_by_filter(n, filter_summary)) continue;
+
         if (IS_LEAF(n)) {
             art_leaf *l = (art_leaf *) LEAF_RAW(n);
 
@@ -1006,15 +1515,19 @@ int art_topk_iter(const art_node *root, token_ordering token_order, size_t max_r
                 }
                 break;
 
-            case NODE48:
+            case NODE48: {
                 //LOG(INFO)  << "NODE48, SCORE: " << n->max_score;
-                for (int i=0; i < 256; i++) {
-                    idx = ((art_node48*)n)->keys[i];
-                    if (!idx) continue;
-                    art_node *child = ((art_node48*)n)->children[idx - 1];
-                    q.push(child);
+                uint64_t bitmap[4];
+                node48_key_bitmap((const art_node48*)n, bitmap);
+                for (int w=0; w < 4; w++) {
+                    for (uint64_t bits = bitmap[w]; bits; bits &= bits - 1) {
+                        idx = ((art_node48*)n)->keys[w*64 + __builtin_ctzll(bits)];
+                        art_node *child = ((art_node48*)n)->children[idx - 1];
+                        q.push(child);
+                    }
                 }
                 break;
+            }
 
             case NODE256:
                 //LOG(INFO)  << "NODE256, SCORE: " << n->max_score;
@@ -1067,15 +1580,18 @@ static int recursive_iter(art_node *n, art_callback cb, void *data) {
             }
             break;
 
-        case NODE48:
-            for (int i=0; i < 256; i++) {
-                idx = ((art_node48*)n)->keys[i];
-                if (!idx) continue;
-
-                res = recursive_iter(((art_node48*)n)->children[idx-1], cb, data);
-                if (res) return res;
+        case NODE48: {
+            uint64_t bitmap[4];
+            node48_key_bitmap((const art_node48*)n, bitmap);
+            for (int w=0; w < 4; w++) {
+                for (uint64_t bits = bitmap[w]; bits; bits &= bits - 1) {
+                    idx = ((art_node48*)n)->keys[w*64 + __builtin_ctzll(bits)];
+                    res = recursive_iter(((art_node48*)n)->children[idx-1], cb, data);
+                    if (res) return res;
+                }
             }
             break;
+        }
 
         case NODE256:
             for (int i=0; i < 256; i++) {
@@ -1235,40 +1751,58 @@ static inline void levenshtein_dist(const int depth, const unsigned char p, cons
 
 static inline void art_fuzzy_children(unsigned char p, const art_node *n, int depth, const unsigned char *term, const int term_len,
                                       const int* irow, const int* jrow, const int min_cost, const int max_cost,
-                                      const bool prefix, std::vector<const art_node *> &results) {
+                                      const bool prefix, const uint64_t filter_summary,
+                                      std::vector<const art_node *> &results) {
     char child_char;
     art_node* child;
 
     switch (n->type) {
         case NODE4:
             printf("\nNODE4\n");
+            for (int i=0; i < n->num_children; i++) {
+                prefetch_node(((art_node4*)n)->children[i]);
+            }
             for (int i=n->num_children-1; i >= 0; i--) {
                 child_char = ((art_node4*)n)->keys[i];
                 printf("4!child_char: %c, %d, depth: %d\n", child_char, child_char, depth);
                 child = ((art_node4*)n)->children[i];
-                art_fuzzy_recurse(p, child_char, child, depth, term, term_len, irow, jrow, min_cost, max_cost, prefix, results);
+                art_fuzzy_recurse(p, child_char, child, depth, term, term_len, irow, jrow, min_cost, max_cost, prefix,
+                                  filter_summary, results);
             }
             break;
         case NODE16:
             printf("\nNODE16\n");
+            for (int i=0; i < n->num_children; i++) {
+                prefetch_node(((art_node16*)n)->children[i]);
+            }
             for (int i=n->num_children-1; i >= 0; i--) {
                 child_char = ((art_node16*)n)->keys[i];
                 printf("16!child_char: %c, depth: %d\n", child_char, depth);
                 child = ((art_node16*)n)->children[i];
-                art_fuzzy_recurse(p, child_char, child, depth, term, term_len, irow, jrow, min_cost, max_cost, prefix, results);
+                art_fuzzy_recurse(p, child_char, child, depth, term, term_len, irow, jrow, min_cost, max_cost, prefix,
+                                  filter_summary, results);
             }
             break;
-        case NODE48:
+        case NODE48: {
             printf("\nNODE48\n");
-            for (int i=255; i >= 0; i--) {
-                int ix = ((art_node48*)n)->keys[i];
-                if (!ix) continue;
-                child = ((art_node48*)n)->children[ix - 1];
-                child_char = (char)i;
-                printf("48!child_char: %c, depth: %d, ix: %d\n", child_char, depth, ix);
-                art_fuzzy_recurse(p, child_char, child, depth, term, term_len, irow, jrow, min_cost, max_cost, prefix, results);
+            uint64_t bitmap[4];
+            node48_key_bitmap((const art_node48*)n, bitmap);
+            for (int w=3; w >= 0; w--) {
+                for (uint64_t bits = bitmap[w]; bits; ) {
+                    const int bit = 63 - __builtin_clzll(bits);
+                    bits &= ~(uint64_t(1) << bit);
+
+                    const int i = w*64 + bit;
+                    int ix = ((art_node48*)n)->keys[i];
+                    child = ((art_node48*)n)->children[ix - 1];
+                    child_char = (char)i;
+                    printf("48!child_char: %c, depth: %d, ix: %d\n", child_char, depth, ix);
+                    art_fuzzy_recurse(p, child_char, child, depth, term, term_len, irow, jrow, min_cost, max_cost,
+                                      prefix, filter_summary, results);
+                }
             }
             break;
+        }
         case NODE256:
             printf("\nNODE256\n");
             for (int i=255; i >= 0; i--) {
@@ -1276,7 +1810,8 @@ static inline void art_fuzzy_children(unsigned char p, const art_node *n, int de
                 child_char = (char) i;
                 printf("256!child_char: %c, depth: %d\n", child_char, depth);
                 child = ((art_node256*)n)->children[i];
-                art_fuzzy_recurse(p, child_char, child, depth, term, term_len, irow, jrow, min_cost, max_cost, prefix, results);
+                art_fuzzy_recurse(p, child_char, child, depth, term, term_len, irow, jrow, min_cost, max_cost, prefix,
+                                  filter_summary, results);
             }
             break;
         default:
@@ -1335,10 +1870,14 @@ static inline int fuzzy_search_state(const bool prefix, int key_index, bool last
 
 static void art_fuzzy_recurse(unsigned char p, unsigned char c, const art_node *n, int depth, const unsigned char *term,
                               const int term_len, const int* irow, const int* jrow, const int min_cost,
-                              const int max_cost, const bool prefix, std::vector<const art_node *> &results) {
+                              const int max_cost, const bool prefix, const uint64_t filter_summary,
+                              std::vector<const art_node *> &results) {
 
     if (!n) return ;
 
+    // no document beneath the node passes the filter
+    if (pruned_by_filter(n, filter_summary)) return ;
+
     const int columns = term_len+1;
     int i=0, j=1, k=2;
     int row0[columns];
@@ -1475,17 +2014,233 @@ static void art_fuzzy_recurse(unsigned char p, unsigned char c, const art_node *
         partial_len++;
     }
 
-    art_fuzzy_children(c, n, depth, term, term_len, rows[i], rows[j], min_cost, max_cost, prefix, results);
+    art_fuzzy_children(c, n, depth, term, term_len, rows[i], rows[j], min_cost, max_cost, prefix, filter_summary,
+                       results);
 }
 
 /**
  * Returns leaves that match a given string within a fuzzy distance of max_cost.
  */
+// Returns the node whose leaves are exactly the keys that begin with the given prefix
+static const art_node* find_prefix_node(const art_tree *t, const unsigned char *prefix, int prefix_len) {
+    art_node **child;
+    art_node *n = t->root;
+    int depth = 0;
+    while (n) {
+        if (IS_LEAF(n)) {
+            return leaf_prefix_matches((art_leaf *) LEAF_RAW(n), prefix, prefix_len) ? NULL : n;
+        }
+
+        if (depth == prefix_len) {
+            return leaf_prefix_matches(minimum(n), prefix, prefix_len) ? NULL : n;
+        }
+
+        if (n->partial_len) {
+            int matched_len = prefix_mismatch(n, prefix, prefix_len, depth);
+            if (matched_len > n->partial_len) {
+                matched_len = n->partial_len;
+            }
+
+            if (!matched_len) {
+                return NULL;
+            } else if (depth + matched_len == prefix_len) {
+                return n;
+            } else if (depth + n->partial_len >= prefix_len) {
+                return NULL;
+            }
+
+            depth = depth + n->partial_len;
+        }
+
+        child = find_child(n, prefix[depth]);
+        n = (child) ? *child : NULL;
+        depth++;
+    }
+
+    return NULL;
+}
+
+static void push_children(const art_node *n, std::vector<const art_node*>& nodes) {
+    switch (n->type) {
+        case NODE4:
+            nodes.insert(nodes.end(), ((art_node4*)n)->children, ((art_node4*)n)->children + n->num_children);
+            break;
+        case NODE16:
+            nodes.insert(nodes.end(), ((art_node16*)n)->children, ((art_node16*)n)->children + n->num_children);
+            break;
+        case NODE48:
+            for (int i=0; i < 48; i++) {
+                if (((art_node48*)n)->children[i]) nodes.push_back(((art_node48*)n)->children[i]);
+            }
+            break;
+        case NODE256:
+            for (int i=0; i < 256; i++) {
+                if (((art_node256*)n)->children[i]) nodes.push_back(((art_node256*)n)->children[i]);
+            }
+            break;
+        default:
+            abort();
+    }
+}
+
+// Collects the best `capacity` leaves under `root` in descending order of the given token ordering
+static void topk_collect(const art_node *root, const token_ordering token_order, const size_t capacity,
+                         art_topk_cache_t::entry_t& entry) {
+    entry.capacity = capacity;
+    entry.leaves.clear();
+
+    if (token_order != FREQUENCY) {
+        // node scores bound the scores of their leaves, so a best-first walk visits leaves in order of score
+        std::priority_queue<const art_node *, std::vector<const art_node *>,
+                decltype(&compare_art_node_score_pq)> q(compare_art_node_score_pq);
+        std::vector<const art_node*> children;
+
+        q.push(root);
+        while (!q.empty() && entry.leaves.size() < capacity) {
+            const art_node *n = q.top();
+            q.pop();
+
+            if (IS_LEAF(n)) {
+                entry.leaves.push_back((art_leaf *) LEAF_RAW(n));
+                continue;
+            }
+
+            children.clear();
+            push_children(n, children);
+            for (const art_node* child: children) {
+                q.push(child);
+            }
+        }
+
+        entry.complete = q.empty();
+        return ;
+    }
+
+    // frequencies are not aggregated on inner nodes, so every leaf of the subtree has to be ranked
+    std::vector<const art_node*> stack = {root};
+    while (!stack.empty()) {
+        const art_node *n = stack.back();
+        stack.pop_back();
+
+        if (IS_LEAF(n)) {
+            entry.leaves.push_back((art_leaf *) LEAF_RAW(n));
+        } else {
+            push_children(n, stack);
+        }
+    }
+
+    auto compare_frequency = [](const art_leaf* a, const art_leaf* b) {
+        return posting_t::num_ids(a->values) > posting_t::num_ids(b->values);
+    };
+
+    entry.complete = (entry.leaves.size() <= capacity);
+
+    if (entry.complete) {
+        std::stable_sort(entry.leaves.begin(), entry.leaves.end(), compare_frequency);
+    } else {
+        std::partial_sort(entry.leaves.begin(), entry.leaves.begin() + capacity, entry.leaves.end(),
+                          compare_frequency);
+        entry.leaves.resize(capacity);
+    }
+}
+
+// Picks the first `max_words` eligible leaves of an entry: fails when the entry might not hold enough of them
+static bool topk_serve(const art_topk_cache_t::entry_t& entry, const size_t max_words,
+                       const uint32_t *filter_ids, size_t filter_ids_length,
+                       const std::set<art_leaf *>& exclude_leaves, std::vector<art_leaf *> &results) {
+    std::vector<art_leaf*> found;
+
+    for (art_leaf* l: entry.leaves) {
+        if (found.size() == max_words) break;
+        if (exclude_leaves.count(l) != 0) continue;
+
+        if (filter_ids_length != 0 && !posting_t::contains_atleast_one(l->values, filter_ids, filter_ids_length)) {
+            continue;
+        }
+
+        found.push_back(l);
+    }
+
+    if (found.size() < max_words && !entry.complete) {
+        return false;
+    }
+
+    results.insert(results.end(), found.begin(), found.end());
+    return true;
+}
+
+// Serves the candidates of a short prefix from the cache, computing the cache entry if required
+static bool topk_cache_search(const art_tree *t, const unsigned char *prefix, const int prefix_len,
+                              const size_t max_words, const token_ordering token_order,
+                              const uint32_t *filter_ids, size_t filter_ids_length,
+                              const std::set<art_leaf *>& exclude_leaves, std::vector<art_leaf *> &results) {
+    art_topk_cache_t* cache = t->topk_cache;
+    const std::string key((const char*) prefix, prefix_len);
+    auto& slot_entries = cache->entries[topk_slot(token_order)];
+
+    const size_t capacity = std::min<size_t>(ART_TOPK_CACHE_MAX_SIZE,
+                                             std::max<size_t>(ART_TOPK_CACHE_MIN_SIZE, max_words * 4));
+
+    art_topk_cache_t::entry_t cached_entry;
+    bool is_cached = false;
+
+    {
+        std::shared_lock<std::shared_mutex> lock(cache->mutex);
+        if (prefix_len == 0 || (size_t) prefix_len > cache->max_prefix_len) {
+            return false;
+        }
+
+        auto entry_it = slot_entries.find(key);
+        if (entry_it != slot_entries.end()) {
+            cached_entry = entry_it->second;
+            is_cached = true;
+        }
+    }
+
+    // the filters are probed on a copy of the entry, so that searches on the field do not wait on one another
+    if (is_cached) {
+        if (topk_serve(cached_entry, max_words, filter_ids, filter_ids_length, exclude_leaves, results)) {
+            return true;
+        }
+
+        if (cached_entry.complete || cached_entry.capacity >= capacity) {
+            // a fresh entry would not hold more eligible leaves
+            return false;
+        }
+    }
+
+    art_topk_cache_t::entry_t entry;
+    const art_node* node = find_prefix_node(t, prefix, prefix_len);
+
+    if (node != NULL) {
+        topk_collect(node, token_order, capacity, entry);
+    } else {
+        entry.capacity = capacity;
+        entry.complete = true;
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> lock(cache->mutex);
+        slot_entries[key] = entry;
+    }
+
+    return topk_serve(entry, max_words, filter_ids, filter_ids_length, exclude_leaves, results);
+}
+
 int art_fuzzy_search(art_tree *t, const unsigned char *term, const int term_len, const int min_cost, const int max_cost,
                      const int max_words, const token_ordering token_order, const bool prefix,
                      const uint32_t *filter_ids, size_t filter_ids_length,
                      std::vector<art_leaf *> &results, const std::set<art_leaf *>& exclude_leaves) {
 
+    // candidates of short prefixes that are searched without typos are served from the top-k cache
+    if (prefix && max_cost == 0 && t->root != nullptr &&
+        topk_cache_search(t, term, term_len, max_words, token_order, filter_ids, filter_ids_length,
+                          exclude_leaves, results)) {
+        return 0;
+    }
+
+    const uint64_t filter_summary = filter_id_summary(filter_ids, filter_ids_length);
+
     std::vector<const art_node*> nodes;
     int irow[term_len + 1];
     int jrow[term_len + 1];
@@ -1497,14 +2252,16 @@ int art_fuzzy_search(art_tree *t, const unsigned char *term, const int term_len,
 
     if(IS_LEAF(t->root)) {
         art_leaf *l = (art_leaf *) LEAF_RAW(t->root);
-        art_fuzzy_recurse(0, l->key[0], t->root, 0, term, term_len, irow, jrow, min_cost, max_cost, prefix, nodes);
+        art_fuzzy_recurse(0, l->key[0], t->root, 0, term, term_len, irow, jrow, min_cost, max_cost, prefix,
+                          filter_summary, nodes);
     } else {
         if(t->root == nullptr) {
             return 0;
         }
 
         // send depth as -1 to indicate that this is a root node
-        art_fuzzy_recurse(0, 0, t->root, -1, term, term_len, irow, jrow, min_cost, max_cost, prefix, nodes);
+        art_fuzzy_recurse(0, 0, t->root, -1, term, term_len, irow, jrow, min_cost, max_cost, prefix,
+                          filter_summary, nodes);
     }
 
     //long long int time_micro = microseconds(std::chrono::high_resolution_clock::now() - begin).count();
@@ -1513,7 +2270,8 @@ int art_fuzzy_search(art_tree *t, const unsigned char *term, const int term_len,
     //auto begin = std::chrono::high_resolution_clock::now();
 
     for(auto node: nodes) {
-        art_topk_iter(node, token_order, max_words, filter_ids, filter_ids_length, exclude_leaves, results);
+        art_topk_iter(node, token_order, max_words, filter_ids, filter_ids_length, filter_summary, exclude_leaves,
+                      results);
     }
 
     if(token_order == FREQUENCY) {
@@ -0,0 +1,131 @@
+#include "art_allocator.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "art.h"
+
+static inline size_t round_up_slot_size(size_t size) {
+    return (size + art_allocator_t::LEAF_SIZE_STEP - 1) & ~(art_allocator_t::LEAF_SIZE_STEP - 1);
+}
+
+static inline size_t leaf_size(uint32_t key_len) {
+    return round_up_slot_size(sizeof(art_leaf) + key_len);
+}
+
+art_allocator_t::art_allocator_t() {
+    classes[0].slot_size = round_up_slot_size(sizeof(art_node4));
+    classes[1].slot_size = round_up_slot_size(sizeof(art_node16));
+    classes[2].slot_size = round_up_slot_size(sizeof(art_node48));
+    classes[3].slot_size = round_up_slot_size(sizeof(art_node256));
+
+    for(size_t i = 0; i < NUM_LEAF_CLASSES; i++) {
+        classes[NUM_NODE_CLASSES + i].slot_size = (i + 1) * LEAF_SIZE_STEP;
+    }
+
+    for(size_class_t& size_class: classes) {
+        size_class.next_slab_size = size_class.slot_size * MIN_SLAB_SLOTS;
+    }
+}
+
+art_allocator_t::~art_allocator_t() {
+    for(char* slab: slabs) {
+        free(slab);
+    }
+}
+
+art_allocator_t::size_class_t& art_allocator_t::node_class(uint8_t type) {
+    switch(type) {
+        case NODE4:
+            return classes[0];
+        case NODE16:
+            return classes[1];
+        case NODE48:
+            return classes[2];
+        case NODE256:
+            return classes[3];
+        default:
+            abort();
+    }
+}
+
+void* art_allocator_t::alloc_slot(size_class_t& size_class) {
+    num_bytes_in_use += size_class.slot_size;
+
+    if(size_class.free_list != nullptr) {
+        free_slot_t* slot = size_class.free_list;
+        size_class.free_list = slot->next;
+        return slot;
+    }
+
+    if(size_class.bump + size_class.slot_size > size_class.bump_end) {
+        const size_t slab_size = size_class.next_slab_size;
+        char* slab = (char*) malloc(slab_size);
+        slabs.push_back(slab);
+        num_slab_bytes += slab_size;
+        size_class.bump = slab;
+        size_class.bump_end = slab + slab_size;
+        size_class.next_slab_size = std::max(slab_size, std::min(slab_size * 2, MAX_SLAB_SIZE));
+    }
+
+    void* slot = size_class.bump;
+    size_class.bump += size_class.slot_size;
+    return slot;
+}
+
+void art_allocator_t::free_slot(size_class_t& size_class, void* ptr) {
+    num_bytes_in_use -= size_class.slot_size;
+
+    free_slot_t* slot = (free_slot_t*) ptr;
+    slot->next = size_class.free_list;
+    size_class.free_list = slot;
+}
+
+void* art_allocator_t::alloc_node(uint8_t type) {
+    std::unique_lock<std::mutex> lock(mutex);
+    size_class_t& size_class = node_class(type);
+    void* node = alloc_slot(size_class);
+    memset(node, 0, size_class.slot_size);
+    return node;
+}
+
+void art_allocator_t::free_node(void* node, uint8_t type) {
+    std::unique_lock<std::mutex> lock(mutex);
+    free_slot(node_class(type), node);
+}
+
+void* art_allocator_t::alloc_leaf(uint32_t key_len) {
+    std::unique_lock<std::mutex> lock(mutex);
+    const size_t size = leaf_size(key_len);
+
+    if(size > MAX_SLAB_LEAF_SIZE) {
+        num_bytes_in_use += size;
+        num_large_bytes += size;
+        return malloc(size);
+    }
+
+    return alloc_slot(classes[NUM_NODE_CLASSES + (size / LEAF_SIZE_STEP) - 1]);
+}
+
+void art_allocator_t::free_leaf(void* leaf, uint32_t key_len) {
+    std::unique_lock<std::mutex> lock(mutex);
+    const size_t size = leaf_size(key_len);
+
+    if(size > MAX_SLAB_LEAF_SIZE) {
+        num_bytes_in_use -= size;
+        num_large_bytes -= size;
+        free(leaf);
+        return ;
+    }
+
+    free_slot(classes[NUM_NODE_CLASSES + (size / LEAF_SIZE_STEP) - 1], leaf);
+}
+
+size_t art_allocator_t::bytes_in_use() const {
+    std::unique_lock<std::mutex> lock(mutex);
+    return num_bytes_in_use;
+}
+
+size_t art_allocator_t::bytes_reserved() const {
+    std::unique_lock<std::mutex> lock(mutex);
+    return num_slab_bytes + num_large_bytes;
+}
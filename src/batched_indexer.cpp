@@ -1,10 +1,13 @@
 #include "batched_indexer.h"
+#include <cmath>
 #include "core_api.h"
 #include "thread_local_vars.h"
+#include "config.h"
 
 BatchedIndexer::BatchedIndexer(HttpServer* server, Store* store, Store* meta_store, const size_t num_threads):
                                server(server), store(store), meta_store(meta_store), num_threads(num_threads),
-                               last_gc_run(std::chrono::high_resolution_clock::now()), quit(false) {
+                               last_gc_run(std::chrono::high_resolution_clock::now()),
+                               last_write_stats_run(std::chrono::high_resolution_clock::now()), quit(false) {
     queues.resize(num_threads);
     qmutuxes = new await_t[num_threads];
 }
@@ -16,6 +19,7 @@ void BatchedIndexer::enqueue(const std::shared_ptr<http_req>& req, const std::sh
 
     //LOG(INFO) << "BatchedIndexer::enqueue";
     uint32_t chunk_sequence = 0;
+    const std::string& serialized_req = req->to_json();
 
     {
         uint64_t now = std::chrono::duration_cast<std::chrono::seconds>(
@@ -27,20 +31,24 @@ void BatchedIndexer::enqueue(const std::shared_ptr<http_req>& req, const std::sh
         if(req_res_map_it == req_res_map.end()) {
             // first chunk
             req_res_t req_res(req->start_ts, "", req, res, now, 1, 0, false);
+            req_res.pending_bytes = serialized_req.size();
             req_res_map.emplace(req->start_ts, req_res);
         } else {
             chunk_sequence = req_res_map_it->second.num_chunks;
             req_res_map_it->second.num_chunks += 1;
             req_res_map_it->second.last_updated = now;
+            req_res_map_it->second.pending_bytes += serialized_req.size();
         }
     }
 
+    update_write_stats(req, 0, serialized_req.size(), 0, 0);
+
     const std::string& req_key_prefix = get_req_prefix_key(req->start_ts);
     const std::string& request_chunk_key = req_key_prefix + StringUtils::serialize_uint32_t(chunk_sequence);
 
     //LOG(INFO) << "request_chunk_key: " << req->start_ts << "_" << chunk_sequence << ", req body: " << req->body;
 
-    store->insert(request_chunk_key, req->to_json());
+    store->insert(request_chunk_key, serialized_req);
 
     bool is_old_serialized_request = (req->start_ts == 0);
     bool read_more_input = (req->_req != nullptr && req->_req->proceed_req);
@@ -48,6 +56,7 @@ void BatchedIndexer::enqueue(const std::shared_ptr<http_req>& req, const std::sh
     if(req->last_chunk_aggregate) {
         //LOG(INFO) << "Last chunk for req_id: " << req->start_ts;
         queued_writes += (chunk_sequence + 1);
+        update_write_stats(req, 1, 0, 0, 0);
 
         {
             const std::string& coll_name = get_collection_name(req);
@@ -125,6 +134,9 @@ void BatchedIndexer::run() {
 
     LOG(INFO) << "BatchedIndexer skip_index: " << skip_index;
 
+    populate_uncoalesced_index();
+    LOG(INFO) << "BatchedIndexer uncoalesced_log_index: " << uncoalesced_log_index;
+
     for(size_t i = 0; i < num_threads; i++) {
         std::deque<uint64_t>& queue = queues[i];
         await_t& queue_mutex = qmutuxes[i];
@@ -140,8 +152,36 @@ void BatchedIndexer::run() {
 
                 uint64_t req_id = queue.front();
                 queue.pop_front();
+
+                std::vector<uint64_t> coalesced_req_ids;
+
+                if(!queue.empty() && is_coalescable_write(req_id, req_id)) {
+                    coalesced_req_ids.push_back(req_id);
+                    const auto window_end = std::chrono::steady_clock::now() +
+                                            std::chrono::microseconds(COALESCE_WINDOW_MICROS);
+
+                    while(coalesced_req_ids.size() < MAX_COALESCED_WRITES) {
+                        if(queue.empty() && !queue_mutex.cv.wait_until(qlk, window_end,
+                                                                       [&] { return quit || !queue.empty(); })) {
+                            break;
+                        }
+
+                        if(quit || !is_coalescable_write(queue.front(), req_id)) {
+                            break;
+                        }
+
+                        coalesced_req_ids.push_back(queue.front());
+                        queue.pop_front();
+                    }
+                }
+
                 qlk.unlock();
 
+                if(coalesced_req_ids.size() > 1) {
+                    index_coalesced_writes(coalesced_req_ids);
+                    continue;
+                }
+
                 std::unique_lock mlk(mutex);
                 auto req_res_map_it = req_res_map.find(req_id);
                 if(req_res_map_it == req_res_map.end()) {
@@ -209,6 +249,8 @@ void BatchedIndexer::run() {
 
                     queued_writes--;
                     orig_req_res.next_chunk_index++;
+                    orig_req_res.pending_bytes -= iter->value().size();
+                    update_write_stats(orig_req, 0, -int64_t(iter->value().size()), 0, iter->value().size());
                     iter->Next();
 
                     if(quit) {
@@ -218,6 +260,9 @@ void BatchedIndexer::run() {
 
                 delete iter;
 
+                // the request is done: chunks that were left out are dropped along with it
+                update_write_stats(orig_req, -1, -orig_req_res.pending_bytes, 1, 0);
+
                 //LOG(INFO) << "Erasing request data from disk and memory for request " << req_id;
 
                 // we can delete the buffered request content
@@ -232,6 +277,8 @@ void BatchedIndexer::run() {
     while(!quit) {
         std::this_thread::sleep_for(std::chrono::milliseconds (1000));
 
+        update_write_throughput();
+
         // do gc, if we are due for one
         uint64_t seconds_elapsed = std::chrono::duration_cast<std::chrono::seconds>(
                 std::chrono::high_resolution_clock::now() - last_gc_run).count();
@@ -251,6 +298,7 @@ void BatchedIndexer::run() {
 
                 if(!it->second.is_complete && seconds_since_batch_update > GC_PRUNE_MAX_SECONDS) {
                     LOG(INFO) << "Deleting partial upload for req id " << it->second.start_ts;
+                    update_write_stats(it->second.req, 0, -it->second.pending_bytes, 0, 0);
 
                     const std::string& req_key_prefix = get_req_prefix_key(it->second.start_ts);
                     store->delete_range(req_key_prefix, req_key_prefix + StringUtils::serialize_uint32_t(UINT32_MAX));
@@ -284,6 +332,101 @@ void BatchedIndexer::run() {
     delete thread_pool;
 }
 
+bool BatchedIndexer::is_coalescable_write(uint64_t req_id, uint64_t batch_req_id) {
+    if(req_id == 0 || skip_index != UNSET_SKIP_INDEX) {
+        // requests from older versions share an ID, and a write that previously crashed must be skipped on its own
+        return false;
+    }
+
+    std::unique_lock lk(mutex);
+    auto req_res_map_it = req_res_map.find(req_id);
+    auto batch_req_res_it = req_res_map.find(batch_req_id);
+
+    if(req_res_map_it == req_res_map.end() || batch_req_res_it == req_res_map.end()) {
+        return false;
+    }
+
+    const req_res_t& req_res = req_res_map_it->second;
+
+    if(!req_res.is_complete || req_res.num_chunks != 1 || req_res.next_chunk_index != 0 ||
+       req_res.req->log_index <= uncoalesced_log_index) {
+        return false;
+    }
+
+    route_path* rpath = nullptr;
+    if(!server->get_route(req_res.req->route_hash, &rpath) || rpath->handler != post_add_document) {
+        return false;
+    }
+
+    const std::shared_ptr<http_req>& batch_req = batch_req_res_it->second.req;
+    return req_res.req->route_hash == batch_req->route_hash && req_res.req->params == batch_req->params;
+}
+
+void BatchedIndexer::index_coalesced_writes(const std::vector<uint64_t>& req_ids) {
+    std::vector<req_res_t*> req_reses;
+    std::vector<std::shared_ptr<http_req>> reqs;
+    std::vector<std::shared_ptr<http_res>> ress;
+    std::vector<bool> live_reqs;
+    std::vector<size_t> req_sizes;
+
+    {
+        std::unique_lock lk(mutex);
+        for(uint64_t req_id: req_ids) {
+            req_res_t& req_res = req_res_map[req_id];
+            req_reses.push_back(&req_res);
+            reqs.push_back(req_res.req);
+            ress.push_back(req_res.res);
+            live_reqs.push_back(req_res.res->is_alive);
+        }
+    }
+
+    for(size_t i = 0; i < req_ids.size(); i++) {
+        const std::string& request_chunk_key = get_req_prefix_key(req_ids[i]) + StringUtils::serialize_uint32_t(0);
+        std::string serialized_req;
+        store->get(request_chunk_key, serialized_req);
+
+        reqs[i]->body = "";
+        reqs[i]->load_from_json(serialized_req);
+        req_sizes.push_back(serialized_req.size());
+    }
+
+    {
+        std::shared_lock slk(pause_mutex); // used for snapshot
+
+        // after a crash, these writes are applied one by one (see `persist_applying_index`)
+        write_log_index = reqs[0]->log_index;
+        write_log_index_end = reqs[0]->log_index;
+
+        for(const auto& req: reqs) {
+            write_log_index = std::min(write_log_index, req->log_index);
+            write_log_index_end = std::max(write_log_index_end, req->log_index);
+        }
+
+        post_add_documents(reqs, ress);
+        write_log_index_end = 0;
+
+        for(size_t i = 0; i < req_ids.size(); i++) {
+            queued_writes--;
+            req_reses[i]->next_chunk_index++;
+            req_reses[i]->pending_bytes = 0;
+            update_write_stats(reqs[i], -1, -int64_t(req_sizes[i]), 1, req_sizes[i]);
+        }
+    }
+
+    for(size_t i = 0; i < req_ids.size(); i++) {
+        if(live_reqs[i]) {
+            async_req_res_t* async_req_res = new async_req_res_t(reqs[i], ress[i], true);
+            server->get_message_dispatcher()->send_message(HttpServer::STREAM_RESPONSE_MESSAGE, async_req_res);
+        }
+
+        const std::string& req_key_prefix = get_req_prefix_key(req_ids[i]);
+        store->delete_range(req_key_prefix, req_key_prefix + StringUtils::serialize_uint32_t(UINT32_MAX));
+
+        std::unique_lock lk(mutex);
+        req_res_map.erase(req_ids[i]);
+    }
+}
+
 std::string BatchedIndexer::get_req_prefix_key(uint64_t req_id) {
     const std::string& req_key_prefix =
             RAFT_REQ_LOG_PREFIX + StringUtils::serialize_uint64_t(req_id) + "_";
@@ -304,6 +447,125 @@ int64_t BatchedIndexer::get_queued_writes() {
     return queued_writes;
 }
 
+void BatchedIndexer::update_write_stats(const std::shared_ptr<http_req>& req, int64_t queued_writes,
+                                        int64_t pending_bytes, int64_t indexed_writes, int64_t indexed_bytes) {
+    auto coll_name_it = req->params.find("collection");
+    if(coll_name_it == req->params.end() || coll_name_it->second.empty()) {
+        return ;
+    }
+
+    std::unique_lock lk(write_stats_mutex);
+    write_stats_t& stats = write_stats[coll_name_it->second];
+
+    // requests restored from a snapshot do not account for their size
+    stats.queued_writes = std::max<int64_t>(0, stats.queued_writes + queued_writes);
+    stats.pending_bytes = std::max<int64_t>(0, stats.pending_bytes + pending_bytes);
+    stats.indexed_writes += indexed_writes;
+    stats.indexed_bytes += indexed_bytes;
+}
+
+void BatchedIndexer::update_write_throughput() {
+    const auto now = std::chrono::high_resolution_clock::now();
+    const double seconds_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            now - last_write_stats_run).count() / 1000.0;
+
+    if(seconds_elapsed <= 0) {
+        return ;
+    }
+
+    last_write_stats_run = now;
+    std::unique_lock lk(write_stats_mutex);
+
+    for(auto it = write_stats.begin(); it != write_stats.end();) {
+        write_stats_t& stats = it->second;
+
+        // moving average, so that a single slow write does not swing the throughput
+        stats.writes_per_second = (stats.writes_per_second + stats.indexed_writes / seconds_elapsed) / 2;
+        stats.bytes_per_second = (stats.bytes_per_second + stats.indexed_bytes / seconds_elapsed) / 2;
+        stats.indexed_writes = 0;
+        stats.indexed_bytes = 0;
+
+        if(stats.queued_writes == 0 && stats.pending_bytes == 0 && stats.writes_per_second < 0.01 &&
+           stats.bytes_per_second < 1) {
+            it = write_stats.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
+
+bool BatchedIndexer::is_write_admitted(const std::string& coll_name, uint32_t& retry_after_seconds) {
+    const Config& config = Config::get_instance();
+    const int64_t max_queued_writes = config.get_collection_write_lag();
+    const int64_t max_pending_bytes = config.get_collection_pending_write_bytes();
+
+    std::unique_lock lk(write_stats_mutex);
+    auto stats_it = write_stats.find(coll_name);
+
+    if(stats_it == write_stats.end()) {
+        return true;
+    }
+
+    const write_stats_t& stats = stats_it->second;
+
+    // a threshold of 0 disables it
+    const bool queue_exceeded = (max_queued_writes != 0 && stats.queued_writes > max_queued_writes);
+    const bool bytes_exceeded = (max_pending_bytes != 0 && stats.pending_bytes > max_pending_bytes);
+
+    if(!queue_exceeded && !bytes_exceeded) {
+        return true;
+    }
+
+    retry_after_seconds = get_retry_after_seconds(stats, queue_exceeded ? max_queued_writes : 0,
+                                                  bytes_exceeded ? max_pending_bytes : 0);
+    return false;
+}
+
+uint32_t BatchedIndexer::get_retry_after_seconds(const write_stats_t& stats, int64_t max_queued_writes,
+                                                 int64_t max_pending_bytes) {
+    // a threshold of 0 is not exceeded, and a backlog that is not being worked on takes the longest wait
+    double seconds_to_drain = 0;
+
+    if(max_queued_writes != 0) {
+        seconds_to_drain = (stats.writes_per_second > 0) ?
+                           (stats.queued_writes - max_queued_writes / 2.0) / stats.writes_per_second :
+                           MAX_RETRY_AFTER_SECONDS;
+    }
+
+    if(max_pending_bytes != 0) {
+        seconds_to_drain = std::max(seconds_to_drain, (stats.bytes_per_second > 0) ?
+                                    (stats.pending_bytes - max_pending_bytes / 2.0) / stats.bytes_per_second :
+                                    MAX_RETRY_AFTER_SECONDS);
+    }
+
+    return std::min<double>(MAX_RETRY_AFTER_SECONDS, std::max<double>(1, std::ceil(seconds_to_drain)));
+}
+
+void BatchedIndexer::get_write_stats(nlohmann::json& stats) {
+    stats = nlohmann::json::object();
+
+    std::vector<std::string> coll_names;
+
+    {
+        std::unique_lock lk(write_stats_mutex);
+        for(const auto& kv: write_stats) {
+            nlohmann::json& coll_stats = stats[kv.first];
+            coll_stats["queued_writes"] = kv.second.queued_writes;
+            coll_stats["pending_bytes"] = kv.second.pending_bytes;
+            coll_stats["writes_per_second"] = kv.second.writes_per_second;
+            coll_stats["bytes_per_second"] = kv.second.bytes_per_second;
+            coll_names.push_back(kv.first);
+        }
+    }
+
+    for(const auto& coll_name: coll_names) {
+        uint32_t retry_after_seconds = 0;
+        const bool admitted = is_write_admitted(coll_name, retry_after_seconds);
+        stats[coll_name]["throttled"] = !admitted;
+        stats[coll_name]["retry_after_seconds"] = retry_after_seconds;
+    }
+}
+
 void BatchedIndexer::populate_skip_index() {
     if(skip_index_iter->Valid() && skip_index_iter->key().starts_with(SKIP_INDICES_PREFIX)) {
         const std::string& index_value = skip_index_iter->value().ToString();
@@ -317,7 +579,30 @@ void BatchedIndexer::populate_skip_index() {
     }
 }
 
+void BatchedIndexer::populate_uncoalesced_index() {
+    rocksdb::Iterator* iter = meta_store->scan(COALESCED_INDICES_PREFIX);
+
+    while(iter->Valid() && iter->key().starts_with(COALESCED_INDICES_PREFIX)) {
+        const std::string& index_value = iter->value().ToString();
+        if(StringUtils::is_int64_t(index_value)) {
+            uncoalesced_log_index = std::max<int64_t>(uncoalesced_log_index, std::stoll(index_value));
+        }
+
+        iter->Next();
+    }
+
+    delete iter;
+}
+
 void BatchedIndexer::persist_applying_index() {
+    if(write_log_index_end != 0) {
+        LOG(INFO) << "Saving currently applying coalesced indices: " << write_log_index
+                  << " to " << write_log_index_end;
+        std::string key = COALESCED_INDICES_PREFIX + std::to_string(write_log_index);
+        meta_store->insert(key, std::to_string(write_log_index_end));
+        return ;
+    }
+
     LOG(INFO) << "Saving currently applying index: " << write_log_index;
     std::string key = SKIP_INDICES_PREFIX + std::to_string(write_log_index);
     meta_store->insert(key, std::to_string(write_log_index));
@@ -383,6 +668,7 @@ void BatchedIndexer::load_state(const nlohmann::json& state) {
             const std::string& coll_name = get_collection_name(req);
             uint64_t queue_id = StringUtils::hash_wy(coll_name.c_str(), coll_name.size()) % num_threads;
             queue_ids.insert(queue_id);
+            update_write_stats(req, 1, 0, 0, 0);
             std::unique_lock qlk(qmutuxes[queue_id].mcv);
             queues[queue_id].emplace_back(req->start_ts);
         }
@@ -413,5 +699,14 @@ void BatchedIndexer::clear_skip_indices() {
         skip_index_iter->Next();
     }
 
+    rocksdb::Iterator* iter = meta_store->scan(COALESCED_INDICES_PREFIX);
+
+    while(iter->Valid() && iter->key().starts_with(COALESCED_INDICES_PREFIX)) {
+        meta_store->remove(iter->key().ToString());
+        iter->Next();
+    }
+
+    delete iter;
+
     meta_store->flush();
 }
@@ -71,17 +71,61 @@ Option<doc_seq_id_t> Collection::to_doc(const std::string & json_str, nlohmann::
                                         const index_operation_t& operation,
                                         const DIRTY_VALUES dirty_values,
                                         const std::string& id) {
+    Option<bool> parse_op = parse_doc(json_str, document);
+
+    if(!parse_op.ok()) {
+        return Option<doc_seq_id_t>(parse_op.code(), parse_op.error());
+    }
+
+    return get_doc_seq_id(document, operation, id);
+}
+
+Option<bool> Collection::parse_doc(const std::string& json_str, nlohmann::json& document) {
     try {
         document = nlohmann::json::parse(json_str);
     } catch(const std::exception& e) {
         LOG(ERROR) << "JSON error: " << e.what();
-        return Option<doc_seq_id_t>(400, std::string("Bad JSON: ") + e.what());
+        return Option<bool>(400, std::string("Bad JSON: ") + e.what());
     }
 
     if(!document.is_object()) {
-        return Option<doc_seq_id_t>(400, "Bad JSON: not a properly formed document.");
+        return Option<bool>(400, "Bad JSON: not a properly formed document.");
+    }
+
+    return Option<bool>(true);
+}
+
+Option<bool> Collection::parse_doc_for_indexing(const char* json, size_t size, nlohmann::json& document) const {
+    // any field can be indexed when the schema has dynamic fields
+    const bool keep_all_fields = !fallback_field_type.empty() || !dynamic_fields.empty();
+
+    // values of the dropped keys are still scanned, but are never materialized into the document
+    nlohmann::json::parser_callback_t keep_indexed_fields =
+        [this, keep_all_fields](int depth, nlohmann::json::parse_event_t event, nlohmann::json& parsed) {
+        if(keep_all_fields || depth != 1 || event != nlohmann::json::parse_event_t::key) {
+            return true;
+        }
+
+        const std::string& key = parsed.get_ref<const std::string&>();
+        return key == "id" || search_schema.count(key) != 0;
+    };
+
+    try {
+        document = nlohmann::json::parse(json, json + size, keep_indexed_fields);
+    } catch(const std::exception& e) {
+        LOG(ERROR) << "JSON error: " << e.what();
+        return Option<bool>(400, std::string("Bad JSON: ") + e.what());
     }
 
+    if(!document.is_object()) {
+        return Option<bool>(400, "Bad JSON: not a properly formed document.");
+    }
+
+    return Option<bool>(true);
+}
+
+Option<doc_seq_id_t> Collection::get_doc_seq_id(nlohmann::json& document, const index_operation_t& operation,
+                                                const std::string& id) {
     if(document.count("id") != 0 && id != "" && document["id"] != id) {
         return Option<doc_seq_id_t>(400, "The `id` of the resource does not match the `id` in the JSON body.");
     }
@@ -168,6 +212,17 @@ nlohmann::json Collection::get_summary_json() const {
         field_json[fields::facet] = coll_field.facet;
         field_json[fields::optional] = coll_field.optional;
         field_json[fields::index] = coll_field.index;
+        field_json[fields::positions] = coll_field.positions;
+        field_json[fields::suggest] = coll_field.suggest;
+        field_json[fields::infix] = coll_field.infix;
+
+        if(coll_field.is_string() && coll_field.index) {
+            field_json["index_bytes"] = index->get_search_index_bytes(coll_field.name);
+        }
+
+        if(!coll_field.positions) {
+            field_json["skipped_position_bytes"] = index->get_skipped_position_bytes(coll_field.name);
+        }
 
         fields_arr.push_back(field_json);
     }
@@ -200,9 +255,35 @@ Option<nlohmann::json> Collection::add(const std::string & json_str,
     return Option<nlohmann::json>(document);
 }
 
+void Collection::add_batch(std::vector<std::string>& json_strs, std::vector<Option<nlohmann::json>>& results,
+                           const index_operation_t& operation, const DIRTY_VALUES& dirty_values) {
+    nlohmann::json document;
+    std::vector<nlohmann::json> documents(json_strs.size());
+    add_many(json_strs, document, operation, "", dirty_values, &documents);
+
+    for(size_t i = 0; i < json_strs.size(); i++) {
+        nlohmann::json res_doc;
+
+        try {
+            res_doc = nlohmann::json::parse(json_strs[i]);
+        } catch(const std::exception& e) {
+            LOG(ERROR) << "JSON error: " << e.what();
+            results.emplace_back(400, std::string("Bad JSON: ") + e.what());
+            continue;
+        }
+
+        if(!res_doc["success"].get<bool>()) {
+            results.emplace_back(res_doc["code"].get<size_t>(), res_doc["error"].get<std::string>());
+            continue;
+        }
+
+        results.emplace_back(documents[i]);
+    }
+}
+
 nlohmann::json Collection::add_many(std::vector<std::string>& json_lines, nlohmann::json& document,
                                     const index_operation_t& operation, const std::string& id,
-                                    const DIRTY_VALUES& dirty_values) {
+                                    const DIRTY_VALUES& dirty_values, std::vector<nlohmann::json>* documents) {
     //LOG(INFO) << "Memory ratio. Max = " << max_memory_ratio << ", Used = " << SystemMetrics::used_memory_ratio();
     std::vector<index_record> index_records;
 
@@ -213,12 +294,76 @@ nlohmann::json Collection::add_many(std::vector<std::string>& json_lines, nlohma
     // ensures that document IDs are not repeated within the same batch
     std::set<std::string> batch_doc_ids;
 
+    // Every batch is parsed on the thread pool while the previous batch is assigned sequence IDs, indexed in
+    // memory and written to disk. The two buffers bound the number of parsed documents held at a time.
+    ThreadPool* thread_pool = CollectionManager::get_instance().get_thread_pool();
+    std::vector<nlohmann::json> parsed_docs[2];
+    std::vector<Option<bool>> parse_ops[2];
+    std::vector<std::future<void>> parse_futures[2];
+
+    const size_t num_batches = (json_lines.size() + index_batch_size - 1) / index_batch_size;
+    size_t current_batch = num_batches;
+
+    auto parse_batch = [&](const size_t batch) {
+        const size_t begin = batch * index_batch_size;
+        const size_t end = std::min(begin + index_batch_size, json_lines.size());
+        auto& docs = parsed_docs[batch % 2];
+        auto& ops = parse_ops[batch % 2];
+
+        docs.clear();
+        docs.resize(end - begin);
+        ops.clear();
+        ops.resize(end - begin, Option<bool>(500, "Document could not be parsed."));
+
+        if(thread_pool == nullptr || end - begin < 2 * PARSE_BATCH_SIZE) {
+            for(size_t j = begin; j < end; j++) {
+                ops[j - begin] = parse_doc(json_lines[j], docs[j - begin]);
+            }
+            return ;
+        }
+
+        for(size_t parse_begin = begin; parse_begin < end; parse_begin += PARSE_BATCH_SIZE) {
+            const size_t parse_end = std::min(parse_begin + PARSE_BATCH_SIZE, end);
+            parse_futures[batch % 2].push_back(
+                thread_pool->enqueue([&json_lines, &docs, &ops, begin, parse_begin, parse_end]() {
+                    for(size_t j = parse_begin; j < parse_end; j++) {
+                        ops[j - begin] = parse_doc(json_lines[j], docs[j - begin]);
+                    }
+                })
+            );
+        }
+    };
+
     for(size_t i=0; i < json_lines.size(); i++) {
-        const std::string & json_line = json_lines[i];
-        Option<doc_seq_id_t> doc_seq_id_op = to_doc(json_line, document, operation, dirty_values, id);
+        const size_t batch = i / index_batch_size;
+
+        if(batch != current_batch) {
+            if(current_batch == num_batches) {
+                // first batch
+                parse_batch(batch);
+            }
+
+            for(auto& parse_future: parse_futures[batch % 2]) {
+                parse_future.wait();
+            }
+
+            parse_futures[batch % 2].clear();
+            current_batch = batch;
+
+            if(batch + 1 < num_batches) {
+                parse_batch(batch + 1);
+            }
+        }
+
+        const size_t batch_pos = i - (batch * index_batch_size);
+        nlohmann::json& parsed_doc = parsed_docs[batch % 2][batch_pos];
+        const Option<bool>& parse_op = parse_ops[batch % 2][batch_pos];
+
+        Option<doc_seq_id_t> doc_seq_id_op = parse_op.ok() ? get_doc_seq_id(parsed_doc, operation, id) :
+                                             Option<doc_seq_id_t>(parse_op.code(), parse_op.error());
 
         const uint32_t seq_id = doc_seq_id_op.ok() ? doc_seq_id_op.get().seq_id : 0;
-        index_record record(i, seq_id, document, operation, dirty_values);
+        index_record record(i, seq_id, std::move(parsed_doc), operation, dirty_values);
 
         // NOTE: we overwrite the input json_lines with result to avoid memory pressure
 
@@ -233,6 +378,8 @@ nlohmann::json Collection::add_many(std::vector<std::string>& json_lines, nlohma
 
             if(repeated_doc) {
                 // when a document repeats, we send the batch until this document so that we can deal with conflicts
+                // and then pick it up again: its parsed form is handed back for that
+                parsed_doc = std::move(record.doc);
                 i--;
                 goto do_batched_index;
             }
@@ -266,6 +413,15 @@ nlohmann::json Collection::add_many(std::vector<std::string>& json_lines, nlohma
                 const auto& rec = index_records[0];
                 document = rec.is_update ? rec.new_doc : rec.doc;
             }
+
+            if(documents != nullptr) {
+                for(const auto& rec: index_records) {
+                    if(rec.indexed.ok()) {
+                        (*documents)[rec.position] = rec.is_update ? rec.new_doc : rec.doc;
+                    }
+                }
+            }
+
             index_records.clear();
             batch_doc_ids.clear();
         }
@@ -287,45 +443,47 @@ void Collection::batch_index(std::vector<index_record>& index_records, std::vect
 
     batch_index_in_memory(index_records);
 
-    // store only documents that were indexed in-memory successfully
+    // store only documents that were indexed in-memory successfully: they are written together in one batch
+    rocksdb::WriteBatch batch;
+
+    for(auto& index_record: index_records) {
+        if(!index_record.indexed.ok()) {
+            continue;
+        }
+
+        if(index_record.is_update) {
+            const std::string& serialized_json = index_record.new_doc.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore);
+            batch.Put(get_seq_id_key(index_record.seq_id), serialized_json);
+        } else {
+            const std::string& seq_id_str = std::to_string(index_record.seq_id);
+            const std::string& serialized_json = index_record.doc.dump(-1, ' ', false,
+                                                                       nlohmann::detail::error_handler_t::ignore);
+
+            batch.Put(get_doc_id_key(index_record.doc["id"]), seq_id_str);
+            batch.Put(get_seq_id_key(index_record.seq_id), serialized_json);
+        }
+    }
+
+    const bool write_ok = (batch.Count() == 0) || store->batch_write(batch);
+
     for(auto& index_record: index_records) {
         nlohmann::json res;
 
         if(index_record.indexed.ok()) {
-            if(index_record.is_update) {
-                const std::string& serialized_json = index_record.new_doc.dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore);
-                bool write_ok = store->insert(get_seq_id_key(index_record.seq_id), serialized_json);
-
-                if(!write_ok) {
-                    // we will attempt to reindex the old doc on a best-effort basis
-                    LOG(ERROR) << "Update to disk failed. Will restore old document";
-                    remove_document(index_record.new_doc, index_record.seq_id, false);
-                    index_in_memory(index_record.old_doc, index_record.seq_id, index_record.operation, index_record.dirty_values);
-                    index_record.index_failure(500, "Could not write to on-disk storage.");
-                } else {
-                    num_indexed++;
-                    index_record.index_success();
-                }
-
+            if(!write_ok && index_record.is_update) {
+                // we will attempt to reindex the old doc on a best-effort basis
+                LOG(ERROR) << "Update to disk failed. Will restore old document";
+                remove_document(index_record.new_doc, index_record.seq_id, false);
+                index_in_memory(index_record.old_doc, index_record.seq_id, index_record.operation, index_record.dirty_values);
+                index_record.index_failure(500, "Could not write to on-disk storage.");
+            } else if(!write_ok) {
+                // remove from in-memory store to keep the state synced
+                LOG(ERROR) << "Write to disk failed. Will restore old document";
+                remove_document(index_record.doc, index_record.seq_id, false);
+                index_record.index_failure(500, "Could not write to on-disk storage.");
             } else {
-                const std::string& seq_id_str = std::to_string(index_record.seq_id);
-                const std::string& serialized_json = index_record.doc.dump(-1, ' ', false,
-                                                                           nlohmann::detail::error_handler_t::ignore);
-
-                rocksdb::WriteBatch batch;
-                batch.Put(get_doc_id_key(index_record.doc["id"]), seq_id_str);
-                batch.Put(get_seq_id_key(index_record.seq_id), serialized_json);
-                bool write_ok = store->batch_write(batch);
-
-                if(!write_ok) {
-                    // remove from in-memory store to keep the state synced
-                    LOG(ERROR) << "Write to disk failed. Will restore old document";
-                    remove_document(index_record.doc, index_record.seq_id, false);
-                    index_record.index_failure(500, "Could not write to on-disk storage.");
-                } else {
-                    num_indexed++;
-                    index_record.index_success();
-                }
+                num_indexed++;
+                index_record.index_success();
             }
 
             res["success"] = index_record.indexed.ok();
@@ -351,7 +509,7 @@ Option<uint32_t> Collection::index_in_memory(nlohmann::json &document, uint32_t
     std::unique_lock lock(mutex);
 
     Option<uint32_t> validation_op = Index::validate_index_in_memory(document, seq_id, default_sorting_field,
-                                                                     search_schema, facet_schema, op,
+                                                                     validation_plan, facet_schema, op,
                                                                      fallback_field_type, dirty_values);
 
     if(!validation_op.ok()) {
@@ -363,8 +521,8 @@ Option<uint32_t> Collection::index_in_memory(nlohmann::json &document, uint32_t
 
     std::vector<index_record> index_batch;
     index_batch.emplace_back(std::move(rec));
-    Index::batch_memory_index(index, index_batch, default_sorting_field, search_schema, facet_schema,
-                              fallback_field_type, token_separators, symbols_to_index);
+    Index::batch_memory_index(index, index_batch, default_sorting_field, search_schema, validation_plan,
+                              facet_schema, fallback_field_type, token_separators, symbols_to_index);
 
     num_documents += 1;
     return Option<>(200);
@@ -373,7 +531,7 @@ Option<uint32_t> Collection::index_in_memory(nlohmann::json &document, uint32_t
 size_t Collection::batch_index_in_memory(std::vector<index_record>& index_records) {
     std::unique_lock lock(mutex);
     size_t num_indexed = Index::batch_memory_index(index, index_records, default_sorting_field,
-                                                   search_schema, facet_schema, fallback_field_type,
+                                                   search_schema, validation_plan, facet_schema, fallback_field_type,
                                                    token_separators, symbols_to_index);
     num_documents += num_indexed;
     return num_indexed;
@@ -1341,6 +1499,7 @@ void Collection::parse_search_query(const std::string &query, std::vector<std::s
         }
 
         bool exclude_operator_prior = false;
+        std::unique_ptr<Tokenizer> tokenizer;
 
         for(auto& token: tokens) {
             if(token == "-") {
@@ -1356,7 +1515,13 @@ void Collection::parse_search_query(const std::string &query, std::vector<std::s
             if(already_segmented) {
                 StringUtils::split(token, sub_tokens, " ");
             } else {
-                Tokenizer(token, true, false, locale, symbols_to_index, token_separators).tokenize(sub_tokens);
+                if(tokenizer == nullptr) {
+                    tokenizer.reset(new Tokenizer(token, true, false, locale, symbols_to_index, token_separators));
+                } else {
+                    tokenizer->reset(token);
+                }
+
+                tokenizer->tokenize(sub_tokens);
             }
 
             for(auto& sub_token: sub_tokens) {
@@ -1428,6 +1593,40 @@ Option<bool> Collection::get_filter_ids(const std::string & simple_filter_query,
     return Option<bool>(true);
 }
 
+Option<nlohmann::json> Collection::suggest(const std::string& field_name, const std::string& query,
+                                          size_t num_typos, size_t limit) const {
+    std::shared_lock lock(mutex);
+
+    const auto field_it = search_schema.find(field_name);
+    if(field_it == search_schema.end()) {
+        return Option<nlohmann::json>(404, "Could not find a field named `" + field_name + "` in the schema.");
+    }
+
+    if(!field_it->second.suggest) {
+        return Option<nlohmann::json>(400, "Field `" + field_name + "` is not enabled for suggestions.");
+    }
+
+    if(num_typos > 2) {
+        return Option<nlohmann::json>(400, "Value of `num_typos` must not be greater than 2.");
+    }
+
+    std::vector<suggestion_t> suggestions;
+    index->suggest(field_name, query, num_typos, limit, suggestions);
+
+    nlohmann::json result = nlohmann::json::object();
+    result["suggestions"] = nlohmann::json::array();
+
+    for(const auto& suggestion: suggestions) {
+        nlohmann::json suggestion_json;
+        suggestion_json["text"] = suggestion.text;
+        suggestion_json["weight"] = suggestion.weight;
+        suggestion_json["typos"] = suggestion.num_typos;
+        result["suggestions"].push_back(suggestion_json);
+    }
+
+    return Option<nlohmann::json>(result);
+}
+
 bool Collection::facet_value_to_string(const facet &a_facet, const facet_count_t &facet_count,
                                        const nlohmann::json &document, std::string &value) const {
 
@@ -1506,6 +1705,12 @@ void Collection::highlight_result(const field &search_field,
     std::vector<art_leaf*> query_suggestion;
     std::set<std::string> query_suggestion_tokens;
 
+    // tokens are looked up on this field in batches, which lets the tree lookups overlap
+    std::vector<std::string> candidate_tokens;
+    std::vector<const unsigned char*> candidate_keys;
+    std::vector<int> candidate_key_lens;
+    std::vector<art_leaf*> candidate_leaves;
+
     size_t qindex = 0;
 
     do {
@@ -1522,24 +1727,42 @@ void Collection::highlight_result(const field &search_field,
         for (art_leaf* token_leaf : searched_query) {
             std::string token(reinterpret_cast<char*>(token_leaf->key), token_leaf->key_len - 1);
 
-            if(query_suggestion_tokens.count(token) != 0) {
+            if(std::find(candidate_tokens.begin(), candidate_tokens.end(), token) != candidate_tokens.end()) {
                 continue;
             }
 
             // Must search for the token string fresh on that field for the given document since `token_leaf`
             // is from the best matched field and need not be present in other fields of a document.
-            art_leaf* actual_leaf = index->get_token_leaf(search_field.name, &token_leaf->key[0], token_leaf->key_len);
-
-            if(actual_leaf != nullptr && posting_t::contains(actual_leaf->values, field_order_kv->key)) {
-                query_suggestion.push_back(actual_leaf);
-                query_suggestion_tokens.insert(token);
-                //LOG(INFO) << "field: " << search_field.name << ", key: " << token;
-            }
+            candidate_tokens.push_back(token);
+            candidate_keys.push_back(&token_leaf->key[0]);
+            candidate_key_lens.push_back(token_leaf->key_len);
         }
 
         qindex++;
     } while(field_order_kv->query_indices != nullptr && qindex < field_order_kv->query_indices[0]);
 
+    index->get_token_leaves(search_field.name, candidate_keys, candidate_key_lens, candidate_leaves);
+
+    for(size_t i = 0; i < candidate_tokens.size(); i++) {
+        art_leaf* actual_leaf = candidate_leaves[i];
+
+        if(actual_leaf != nullptr && posting_t::contains(actual_leaf->values, field_order_kv->key)) {
+            query_suggestion.push_back(actual_leaf);
+            query_suggestion_tokens.insert(candidate_tokens[i]);
+            //LOG(INFO) << "field: " << search_field.name << ", key: " << candidate_tokens[i];
+        }
+    }
+
+    candidate_keys.clear();
+    candidate_key_lens.clear();
+
+    for(const std::string& q_token: q_tokens) {
+        candidate_keys.push_back(reinterpret_cast<const unsigned char *>(q_token.c_str()));
+        candidate_key_lens.push_back(q_token.size() + 1);
+    }
+
+    index->get_token_leaves(search_field.name, candidate_keys, candidate_key_lens, candidate_leaves);
+
     for(size_t i = 0; i < q_tokens.size(); i++) {
         const std::string& q_token = q_tokens[i];
 
@@ -1547,9 +1770,7 @@ void Collection::highlight_result(const field &search_field,
             continue;
         }
 
-        art_leaf *actual_leaf = index->get_token_leaf(search_field.name,
-                                                      reinterpret_cast<const unsigned char *>(q_token.c_str()),
-                                                      q_token.size() + 1);
+        art_leaf *actual_leaf = candidate_leaves[i];
 
         if(actual_leaf != nullptr && posting_t::contains(actual_leaf->values, field_order_kv->key)) {
             query_suggestion.push_back(actual_leaf);
@@ -1571,10 +1792,28 @@ void Collection::highlight_result(const field &search_field,
     }
 
     std::unordered_map<size_t, std::vector<token_positions_t>> array_token_positions;
-    posting_t::get_array_token_positions(field_order_kv->key, posting_lists, array_token_positions);
-
     std::vector<match_index_t> match_indices;
 
+    if(!search_field.positions) {
+        // without token positions, matching tokens are highlighted wherever they occur in the matched elements
+        if(!posting_lists.empty()) {
+            Match bag_of_words_match(posting_lists.size(), 0);
+            std::vector<size_t> array_indices;
+
+            if(search_field.is_array()) {
+                posting_t::get_matching_array_indices(posting_lists, field_order_kv->key, array_indices);
+            } else {
+                array_indices.push_back(0);
+            }
+
+            for(size_t array_index: array_indices) {
+                match_indices.emplace_back(bag_of_words_match, bag_of_words_match.get_match_score(1), array_index);
+            }
+        }
+    } else {
+        posting_t::get_array_token_positions(field_order_kv->key, posting_lists, array_token_positions);
+    }
+
     for(const auto& kv: array_token_positions) {
         const std::vector<token_positions_t>& token_positions = kv.second;
         size_t array_index = kv.first;
@@ -1678,9 +1917,17 @@ void Collection::highlight_result(const field &search_field,
             bool token_already_found = (token_hits.find(raw_token) != token_hits.end());
 
             // ensures that the `snippet_start_offset` is always from a matched token, and not from query suggestion
-            if ((found_first_match && token_already_found) ||
-                (match_offset_index < match.offsets.size() &&
-                 match.offsets[match_offset_index].offset == raw_token_index)) {
+            if(!search_field.positions && !found_first_match &&
+               query_suggestion_tokens.find(raw_token) != query_suggestion_tokens.end()) {
+                // without token positions, the snippet is anchored on the first occurrence of a query token
+                token_offsets.emplace(tok_start, tok_end);
+                token_hits.insert(raw_token);
+                snippet_start_offset = snippet_start_window.front();
+                last_valid_offset = raw_token_index;
+                found_first_match = true;
+            } else if ((found_first_match && token_already_found) ||
+                       (match_offset_index < match.offsets.size() &&
+                        match.offsets[match_offset_index].offset == raw_token_index)) {
 
                 token_offsets.emplace(tok_start, tok_end);
                 token_hits.insert(raw_token);
@@ -1703,19 +1950,20 @@ void Collection::highlight_result(const field &search_field,
                 token_hits.insert(raw_token);
             }
 
-            if(raw_token_index == last_valid_offset + highlight_affix_num_tokens) {
+            if((search_field.positions || found_first_match) &&
+               raw_token_index == last_valid_offset + highlight_affix_num_tokens) {
                 // register end of highlight snippet
                 snippet_end_offset = tok_end;
             }
 
             // We can break early only if we have:
-            // a) run out of matched indices
+            // a) run out of matched indices (or found the first match, on a field without positions)
             // b) token_index exceeds the suffix tokens boundary
             // c) raw_token_index exceeds snippet threshold
             // d) highlight fully is not requested
 
             if(raw_token_index >= snippet_threshold - 1 &&
-               match_offset_index == match.offsets.size() &&
+               (search_field.positions ? match_offset_index == match.offsets.size() : found_first_match) &&
                raw_token_index >= last_valid_offset + highlight_affix_num_tokens &&
                !highlighted_fully) {
                 break;
@@ -2304,10 +2552,20 @@ Option<bool> Collection::check_and_update_schema(nlohmann::json& document, const
 
     std::vector<field> new_fields;
 
+    if(dynamic_field_regexes.size() != dynamic_fields.size()) {
+        dynamic_field_regexes.clear();
+        for(const auto& dynamic_field: dynamic_fields) {
+            dynamic_field_regexes.emplace_back(dynamic_field.name);
+        }
+
+        // keys were judged against the previous dynamic fields
+        non_indexed_keys.clear();
+    }
+
     auto kv = document.begin();
     while(kv != document.end()) {
         // we will not index the special "id" key
-        if (search_schema.count(kv.key()) == 0 && kv.key() != "id") {
+        if (search_schema.count(kv.key()) == 0 && kv.key() != "id" && non_indexed_keys.count(kv.key()) == 0) {
             const std::string &fname = kv.key();
             field new_field(fname, field_types::STRING, false, true);
             std::string field_type;
@@ -2316,9 +2574,9 @@ Option<bool> Collection::check_and_update_schema(nlohmann::json& document, const
             bool found_dynamic_field = false;
 
             // check against dynamic field definitions
-            for(const auto& dynamic_field: dynamic_fields) {
-                if(std::regex_match (kv.key(), std::regex(dynamic_field.name))) {
-                    new_field = dynamic_field;
+            for(size_t i = 0; i < dynamic_fields.size(); i++) {
+                if(std::regex_match(kv.key(), dynamic_field_regexes[i])) {
+                    new_field = dynamic_fields[i];
                     new_field.name = fname;
                     found_dynamic_field = true;
                     break;
@@ -2327,11 +2585,17 @@ Option<bool> Collection::check_and_update_schema(nlohmann::json& document, const
 
             if(!found_dynamic_field && fallback_field_type.empty()) {
                 // we will not auto detect schema for non-dynamic fields if auto detection is not enabled
+                if(non_indexed_keys.size() < MAX_NON_INDEXED_KEYS) {
+                    non_indexed_keys.insert(fname);
+                }
                 kv++;
                 continue;
             }
 
             if(!new_field.index) {
+                if(non_indexed_keys.size() < MAX_NON_INDEXED_KEYS) {
+                    non_indexed_keys.insert(fname);
+                }
                 kv++;
                 continue;
             }
@@ -2402,6 +2666,8 @@ Option<bool> Collection::check_and_update_schema(nlohmann::json& document, const
     }
 
     if(!new_fields.empty()) {
+        Index::compile_validation_plan(search_schema, validation_plan);
+
         // we should persist changes to fields in store
         std::string coll_meta_json;
         StoreStatus status = store->get(Collection::get_meta_key(name), coll_meta_json);
@@ -2430,6 +2696,7 @@ Option<bool> Collection::check_and_update_schema(nlohmann::json& document, const
             }
 
             index->refresh_schemas(new_fields);
+            non_indexed_keys.clear();
 
         } catch(...) {
             return Option<bool>(500, "Unable to parse collection meta.");
@@ -2462,6 +2729,9 @@ Index* Collection::init_index() {
         }
     }
 
+    Index::compile_validation_plan(search_schema, validation_plan);
+    non_indexed_keys.clear();
+
     return new Index(name+std::to_string(0),
                      collection_id,
                      store,
@@ -37,8 +37,22 @@ Collection* CollectionManager::init_collection(const nlohmann::json & collection
             field_obj[fields::locale] = "";
         }
 
+        if(field_obj.count(fields::positions) == 0) {
+            field_obj[fields::positions] = true;
+        }
+
+        if(field_obj.count(fields::suggest) == 0) {
+            field_obj[fields::suggest] = false;
+        }
+
+        if(field_obj.count(fields::infix) == 0) {
+            field_obj[fields::infix] = false;
+        }
+
         fields.push_back({field_obj[fields::name], field_obj[fields::type], field_obj[fields::facet],
-                          field_obj[fields::optional], field_obj[fields::index], field_obj[fields::locale]});
+                          field_obj[fields::optional], field_obj[fields::index], field_obj[fields::locale],
+                          field_obj[fields::positions], field_obj[fields::suggest],
+                          field_obj[fields::infix]});
     }
 
     std::string default_sorting_field = collection_meta[Collection::COLLECTION_DEFAULT_SORTING_FIELD_KEY].get<std::string>();
@@ -1095,11 +1109,11 @@ Option<bool> CollectionManager::load_collection(const nlohmann::json &collection
         const uint32_t seq_id = Collection::get_seq_id_from_key(iter->key().ToString());
 
         nlohmann::json document;
+        const rocksdb::Slice& doc_value = iter->value();
+        const Option<bool>& parse_op = collection->parse_doc_for_indexing(doc_value.data(), doc_value.size(),
+                                                                          document);
 
-        try {
-            document = nlohmann::json::parse(iter->value().ToString());
-        } catch(const std::exception& e) {
-            LOG(ERROR) << "JSON error: " << e.what();
+        if(!parse_op.ok()) {
             return Option<bool>(false, "Bad JSON.");
         }
 
@@ -203,6 +203,7 @@ bool get_stats_json(const std::shared_ptr<http_req>& req, const std::shared_ptr<
     nlohmann::json result;
     AppMetrics::get_instance().get("requests_per_second", "latency_ms", result);
     result["pending_write_batches"] = server->get_num_queued_writes();
+    server->get_write_stats(result["collection_writes"]);
 
     res->set_body(200, result.dump(2));
     return true;
@@ -633,17 +634,9 @@ bool post_import_documents(const std::shared_ptr<http_req>& req, const std::shar
         req->body = "";
     } else {
         if(!json_lines.empty()) {
-            // check if req->body had complete last record
-            bool complete_document;
-
-            try {
-                nlohmann::json document = nlohmann::json::parse(json_lines.back());
-                complete_document = document.is_object();
-            } catch(const std::exception& e) {
-                complete_document = false;
-            }
-
-            if(!complete_document) {
+            // check if req->body had complete last record: a structural scan is enough here since the
+            // record is parsed (and validated) again when it is imported
+            if(!StringUtils::is_complete_json_object(json_lines.back())) {
                 // eject partial record
                 req->body = json_lines.back();
                 json_lines.pop_back();
@@ -734,6 +727,68 @@ bool post_add_document(const std::shared_ptr<http_req>& req, const std::shared_p
     return true;
 }
 
+bool post_add_documents(const std::vector<std::shared_ptr<http_req>>& reqs,
+                        const std::vector<std::shared_ptr<http_res>>& ress) {
+    const std::shared_ptr<http_req>& req = reqs[0];
+    const char *ACTION = "action";
+    const char *DIRTY_VALUES_PARAM = "dirty_values";
+
+    if(req->params.count(ACTION) == 0) {
+        req->params[ACTION] = "create";
+    }
+
+    if(req->params.count(DIRTY_VALUES_PARAM) == 0) {
+        req->params[DIRTY_VALUES_PARAM] = "";  // set it empty as default will depend on whether schema is enabled
+    }
+
+    if(req->params[ACTION] != "create" && req->params[ACTION] != "update" && req->params[ACTION] != "upsert") {
+        for(const auto& res: ress) {
+            res->set_400("Parameter `" + std::string(ACTION) + "` must be a create|update|upsert.");
+        }
+        return false;
+    }
+
+    CollectionManager & collectionManager = CollectionManager::get_instance();
+    auto collection = collectionManager.get_collection(req->params["collection"]);
+
+    if(collection == nullptr) {
+        for(const auto& res: ress) {
+            res->set_404();
+        }
+        return false;
+    }
+
+    const index_operation_t operation = get_index_operation(req->params[ACTION]);
+    const auto& dirty_values = collection->parse_dirty_values_option(req->params[DIRTY_VALUES_PARAM]);
+
+    std::vector<std::string> json_strs;
+    json_strs.reserve(reqs.size());
+
+    for(const auto& doc_req: reqs) {
+        json_strs.push_back(std::move(doc_req->body));
+        doc_req->body.clear();
+    }
+
+    std::vector<Option<nlohmann::json>> inserted_doc_ops;
+    collection->add_batch(json_strs, inserted_doc_ops, operation, dirty_values);
+
+    bool all_ok = true;
+
+    for(size_t i = 0; i < ress.size(); i++) {
+        const Option<nlohmann::json>& inserted_doc_op = inserted_doc_ops[i];
+
+        if(!inserted_doc_op.ok()) {
+            ress[i]->set(inserted_doc_op.code(), inserted_doc_op.error());
+            all_ok = false;
+            continue;
+        }
+
+        ress[i]->set_201(inserted_doc_op.get().dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore));
+    }
+
+    return all_ok;
+}
+
 bool patch_update_document(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
     std::string doc_id = req->params["id"];
 
@@ -763,6 +818,56 @@ bool patch_update_document(const std::shared_ptr<http_req>& req, const std::shar
     return true;
 }
 
+bool get_suggest(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    const char *SUGGEST_QUERY = "q";
+    const char *SUGGEST_FIELD = "field";
+    const char *SUGGEST_LIMIT = "limit";
+    const char *SUGGEST_NUM_TYPOS = "num_typos";
+
+    CollectionManager & collectionManager = CollectionManager::get_instance();
+    auto collection = collectionManager.get_collection(req->params["collection"]);
+    if(collection == nullptr) {
+        res->set_404();
+        return false;
+    }
+
+    if(req->params.count(SUGGEST_FIELD) == 0) {
+        res->set_400("Parameter `" + std::string(SUGGEST_FIELD) + "` is required.");
+        return false;
+    }
+
+    size_t limit = 10;
+    if(req->params.count(SUGGEST_LIMIT) != 0) {
+        if(!StringUtils::is_uint32_t(req->params[SUGGEST_LIMIT])) {
+            res->set_400("Parameter `" + std::string(SUGGEST_LIMIT) + "` must be a positive integer.");
+            return false;
+        }
+
+        limit = std::stoul(req->params[SUGGEST_LIMIT]);
+    }
+
+    size_t num_typos = 0;
+    if(req->params.count(SUGGEST_NUM_TYPOS) != 0) {
+        if(!StringUtils::is_uint32_t(req->params[SUGGEST_NUM_TYPOS])) {
+            res->set_400("Parameter `" + std::string(SUGGEST_NUM_TYPOS) + "` must be a positive integer.");
+            return false;
+        }
+
+        num_typos = std::stoul(req->params[SUGGEST_NUM_TYPOS]);
+    }
+
+    Option<nlohmann::json> suggest_op = collection->suggest(req->params[SUGGEST_FIELD], req->params[SUGGEST_QUERY],
+                                                            num_typos, limit);
+
+    if(!suggest_op.ok()) {
+        res->set(suggest_op.code(), suggest_op.error());
+        return false;
+    }
+
+    res->set_200(suggest_op.get().dump(-1, ' ', false, nlohmann::detail::error_handler_t::ignore));
+    return true;
+}
+
 bool get_fetch_document(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
     std::string doc_id = req->params["id"];
 
@@ -328,6 +328,12 @@ Option<bool> filter::parse_filter_query(const string& simple_filter_query,
                 while(++filter_value_index < raw_value.size() && raw_value[filter_value_index] == ' ');
             }
 
+            if(str_comparator != CONTAINS && !_field.positions) {
+                // an exact match cannot be told apart from a partial one without token positions
+                return Option<bool>(400, "Error with filter field `" + _field.name +
+                                         "`: Exact filtering is not supported on a field indexed without positions.");
+            }
+
             if(filter_value_index == raw_value.size()) {
                 return Option<bool>(400, "Error with filter field `" + _field.name +
                                          "`: Filter value cannot be empty.");
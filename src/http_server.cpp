@@ -396,6 +396,24 @@ int HttpServer::catch_all_handler(h2o_handler_t *_h2o_handler, h2o_req_t *req) {
         else if(write_op && !h2o_handler->http_server->get_replication_state()->is_write_caught_up()) {
             return send_response(req, 503, message);
         }
+
+        // writes to a collection that the indexer is lagging on are held back before they can add to the backlog,
+        // except for deletes, which shrink the collection
+        uint32_t retry_after_seconds = 0;
+
+        if(write_op && http_method != "DELETE" && root_resource == "collections" &&
+           path_parts.size() >= 3 && path_parts[2] == "documents" &&
+           !h2o_handler->http_server->get_replication_state()->is_write_admitted(
+                   StringUtils::url_decode(path_parts[1]), retry_after_seconds)) {
+            const std::string& retry_after = std::to_string(retry_after_seconds);
+            h2o_iovec_t retry_after_value = h2o_strdup(&req->pool, retry_after.c_str(), retry_after.size());
+            h2o_add_header_by_str(&req->pool, &req->res.headers, H2O_STRLIT("retry-after"),
+                                  0, NULL, retry_after_value.base, retry_after_value.len);
+
+            nlohmann::json resp;
+            resp["message"] = "Too many pending writes to this collection. Retry after " + retry_after + " seconds.";
+            return send_response(req, 429, resp.dump());
+        }
     }
 
     // iterate and extract path params
@@ -1014,6 +1032,10 @@ int64_t HttpServer::get_num_queued_writes() {
     return replication_state->get_num_queued_writes();
 }
 
+void HttpServer::get_write_stats(nlohmann::json& stats) {
+    replication_state->get_write_stats(stats);
+}
+
 bool HttpServer::is_leader() const {
     return replication_state->is_leader();
 }
@@ -20,6 +20,7 @@
 #include <thread_local_vars.h>
 #include <unordered_set>
 #include "logger.h"
+#include "config.h"
 
 #define RETURN_CIRCUIT_BREAKER if(std::chrono::duration_cast<std::chrono::milliseconds>(\
                                 std::chrono::high_resolution_clock::now() - search_begin).count() > search_stop_ms) { \
@@ -33,9 +34,41 @@
                                     break;\
                                 }
 
-spp::sparse_hash_map<uint32_t, int64_t> Index::text_match_sentinel_value;
-spp::sparse_hash_map<uint32_t, int64_t> Index::seq_id_sentinel_value;
-spp::sparse_hash_map<uint32_t, int64_t> Index::geo_sentinel_value;
+// Maps the per-query sort slot kinds to a scoring kernel specialized on them. Only the common sort configurations
+// get a dedicated kernel to keep code size bounded: everything else (e.g. geo sorting) uses the generic kernel.
+template<bool grouping, class F>
+static void dispatch_score_kernel_slots(const std::array<sort_slot_t, 3>& sort_slots, F&& func) {
+    using slot = sort_slot_t;
+
+    const auto is = [&sort_slots](slot s0, slot s1, slot s2) {
+        return sort_slots[0] == s0 && sort_slots[1] == s1 && sort_slots[2] == s2;
+    };
+
+    if(is(slot::TEXT_MATCH, slot::NONE, slot::NONE)) {
+        func(score_kernel_t<slot::TEXT_MATCH, slot::NONE, slot::NONE, grouping>());
+    } else if(is(slot::TEXT_MATCH, slot::VALUE, slot::NONE)) {
+        func(score_kernel_t<slot::TEXT_MATCH, slot::VALUE, slot::NONE, grouping>());
+    } else if(is(slot::TEXT_MATCH, slot::SEQ_ID, slot::NONE)) {
+        func(score_kernel_t<slot::TEXT_MATCH, slot::SEQ_ID, slot::NONE, grouping>());
+    } else if(is(slot::VALUE, slot::TEXT_MATCH, slot::NONE)) {
+        func(score_kernel_t<slot::VALUE, slot::TEXT_MATCH, slot::NONE, grouping>());
+    } else if(is(slot::TEXT_MATCH, slot::VALUE, slot::VALUE)) {
+        func(score_kernel_t<slot::TEXT_MATCH, slot::VALUE, slot::VALUE, grouping>());
+    } else if(is(slot::VALUE, slot::VALUE, slot::TEXT_MATCH)) {
+        func(score_kernel_t<slot::VALUE, slot::VALUE, slot::TEXT_MATCH, grouping>());
+    } else {
+        func(score_kernel_t<slot::DYNAMIC, slot::DYNAMIC, slot::DYNAMIC, grouping>());
+    }
+}
+
+template<class F>
+static void dispatch_score_kernel(const std::array<sort_slot_t, 3>& sort_slots, const bool grouping, F&& func) {
+    if(grouping) {
+        dispatch_score_kernel_slots<true>(sort_slots, func);
+    } else {
+        dispatch_score_kernel_slots<false>(sort_slots, func);
+    }
+}
 
 Index::Index(const std::string& name, const uint32_t collection_id, const Store* store, ThreadPool* thread_pool,
              const std::unordered_map<std::string, field> & search_schema,
@@ -50,7 +83,20 @@ Index::Index(const std::string& name, const uint32_t collection_id, const Store*
             if(fname_field.second.index) {
                 art_tree *t = new art_tree;
                 art_tree_init(t);
+                art_set_topk_cache_prefix_len(t, Config::get_instance().get_topk_cache_prefix_len());
                 search_index.emplace(fname_field.first, t);
+
+                if(Config::get_instance().get_enable_forward_index()) {
+                    forward_index.emplace(fname_field.first, new spp::sparse_hash_map<uint32_t, std::string>());
+                }
+            }
+
+            if(fname_field.second.suggest) {
+                suggestion_index.emplace(fname_field.first, new suggestion_index_t());
+            }
+
+            if(fname_field.second.infix) {
+                infix_index.emplace(fname_field.first, new infix_index_t());
             }
         } else if(fname_field.second.is_geopoint()) {
             auto field_geo_index = new spp::sparse_hash_map<std::string, std::vector<uint32_t>>();
@@ -69,6 +115,7 @@ Index::Index(const std::string& name, const uint32_t collection_id, const Store*
         if(fname_field.second.facet && !fname_field.second.is_string()) {
             art_tree *ft = new art_tree;
             art_tree_init(ft);
+            art_set_topk_cache_prefix_len(ft, Config::get_instance().get_topk_cache_prefix_len());
             search_index.emplace(fname_field.second.faceted_name(), ft);
         }
     }
@@ -103,6 +150,27 @@ Index::~Index() {
 
     search_index.clear();
 
+    for(auto& name_index: suggestion_index) {
+        delete name_index.second;
+        name_index.second = nullptr;
+    }
+
+    suggestion_index.clear();
+
+    for(auto& name_index: infix_index) {
+        delete name_index.second;
+        name_index.second = nullptr;
+    }
+
+    infix_index.clear();
+
+    for(auto& name_index: forward_index) {
+        delete name_index.second;
+        name_index.second = nullptr;
+    }
+
+    forward_index.clear();
+
     for(auto & name_index: geopoint_index) {
         delete name_index.second;
         name_index.second = nullptr;
@@ -175,7 +243,8 @@ void Index::compute_token_offsets_facets(index_record& record,
                                           const std::unordered_map<std::string, field>& search_schema,
                                           const std::map<std::string, field>& facet_schema,
                                           const std::vector<char>& local_token_separators,
-                                          const std::vector<char>& local_symbols_to_index) {
+                                          const std::vector<char>& local_symbols_to_index,
+                                          tokenization_cache_t* tokenization_cache) {
 
     const auto& document = record.doc;
 
@@ -189,6 +258,9 @@ void Index::compute_token_offsets_facets(index_record& record,
 
         bool is_facet = (facet_schema.count(field_name) != 0);
 
+        std::unordered_map<std::string, tokenized_value_t>* value_cache =
+                (tokenization_cache == nullptr) ? nullptr : &(*tokenization_cache)[field_name];
+
         // non-string, non-geo faceted field should be indexed as faceted string field as well
         if(field_pair.second.facet && !field_pair.second.is_string() && !field_pair.second.is_geopoint()) {
             if(field_pair.second.is_array()) {
@@ -214,7 +286,8 @@ void Index::compute_token_offsets_facets(index_record& record,
 
                 tokenize_string_array_with_facets(strings, is_facet, field_pair.second,
                                                   local_symbols_to_index, local_token_separators,
-                                                  offset_facet_hashes.offsets, offset_facet_hashes.facet_hashes);
+                                                  offset_facet_hashes.offsets, offset_facet_hashes.facet_hashes,
+                                                  value_cache);
             } else {
                 std::string text;
 
@@ -230,7 +303,8 @@ void Index::compute_token_offsets_facets(index_record& record,
 
                 tokenize_string_with_facets(text, is_facet, field_pair.second,
                                             local_symbols_to_index, local_token_separators,
-                                            offset_facet_hashes.offsets, offset_facet_hashes.facet_hashes);
+                                            offset_facet_hashes.offsets, offset_facet_hashes.facet_hashes,
+                                            value_cache);
             }
         }
 
@@ -239,11 +313,13 @@ void Index::compute_token_offsets_facets(index_record& record,
             if(field_pair.second.type == field_types::STRING) {
                 tokenize_string_with_facets(document[field_name], is_facet, field_pair.second,
                                             local_symbols_to_index, local_token_separators,
-                                            offset_facet_hashes.offsets, offset_facet_hashes.facet_hashes);
+                                            offset_facet_hashes.offsets, offset_facet_hashes.facet_hashes,
+                                            value_cache);
             } else {
                 tokenize_string_array_with_facets(document[field_name], is_facet, field_pair.second,
                                                   local_symbols_to_index, local_token_separators,
-                                                  offset_facet_hashes.offsets, offset_facet_hashes.facet_hashes);
+                                                  offset_facet_hashes.offsets, offset_facet_hashes.facet_hashes,
+                                                  value_cache);
             }
         }
 
@@ -253,9 +329,81 @@ void Index::compute_token_offsets_facets(index_record& record,
     }
 }
 
+void Index::init_field_check(validation_plan_t::field_check_t& field_check) {
+    const std::string& type = field_check.a_field.type;
+
+    if(type == field_types::STRING || type == field_types::STRING_ARRAY) {
+        field_check.is_valid = [](const nlohmann::json& value) { return value.is_string(); };
+        field_check.coerce = coerce_string;
+    } else if(type == field_types::INT32 || type == field_types::INT32_ARRAY) {
+        field_check.is_valid = [](const nlohmann::json& value) { return value.is_number_integer(); };
+        field_check.coerce = [](const DIRTY_VALUES& dirty_values, const std::string& fallback_field_type,
+                                const field& a_field, nlohmann::json& document, const std::string& field_name,
+                                nlohmann::json::iterator& array_iter, bool is_array, bool& array_ele_erased) {
+            return coerce_int32_t(dirty_values, a_field, document, field_name, array_iter, is_array, array_ele_erased);
+        };
+    } else if(type == field_types::INT64 || type == field_types::INT64_ARRAY) {
+        field_check.is_valid = [](const nlohmann::json& value) { return value.is_number_integer(); };
+        field_check.coerce = [](const DIRTY_VALUES& dirty_values, const std::string& fallback_field_type,
+                                const field& a_field, nlohmann::json& document, const std::string& field_name,
+                                nlohmann::json::iterator& array_iter, bool is_array, bool& array_ele_erased) {
+            return coerce_int64_t(dirty_values, a_field, document, field_name, array_iter, is_array, array_ele_erased);
+        };
+    } else if(type == field_types::FLOAT || type == field_types::FLOAT_ARRAY) {
+        // using `is_number` allows integer to be passed to a float field
+        field_check.is_valid = [](const nlohmann::json& value) { return value.is_number(); };
+        field_check.coerce = [](const DIRTY_VALUES& dirty_values, const std::string& fallback_field_type,
+                                const field& a_field, nlohmann::json& document, const std::string& field_name,
+                                nlohmann::json::iterator& array_iter, bool is_array, bool& array_ele_erased) {
+            return coerce_float(dirty_values, a_field, document, field_name, array_iter, is_array, array_ele_erased);
+        };
+    } else if(type == field_types::BOOL || type == field_types::BOOL_ARRAY) {
+        field_check.is_valid = [](const nlohmann::json& value) { return value.is_boolean(); };
+        field_check.coerce = [](const DIRTY_VALUES& dirty_values, const std::string& fallback_field_type,
+                                const field& a_field, nlohmann::json& document, const std::string& field_name,
+                                nlohmann::json::iterator& array_iter, bool is_array, bool& array_ele_erased) {
+            return coerce_bool(dirty_values, a_field, document, field_name, array_iter, is_array, array_ele_erased);
+        };
+    } else if(type == field_types::GEOPOINT || type == field_types::GEOPOINT_ARRAY) {
+        field_check.is_valid = [](const nlohmann::json& value) {
+            return value.is_array() && value.size() == 2 && value[0].is_number() && value[1].is_number();
+        };
+
+        // only the elements of a point are coerced: a value that is not a point is rejected
+        field_check.coerce = [](const DIRTY_VALUES& dirty_values, const std::string& fallback_field_type,
+                                const field& a_field, nlohmann::json& document, const std::string& field_name,
+                                nlohmann::json::iterator& array_iter, bool is_array, bool& array_ele_erased) {
+            const nlohmann::json& value = is_array ? array_iter.value() : document[field_name];
+
+            if(!value.is_array() || value.size() != 2) {
+                return is_array ?
+                       Option<uint32_t>(400, "Field `" + field_name  + "` must contain 2 element arrays: [ [lat, lng],... ].") :
+                       Option<uint32_t>(400, "Field `" + field_name  + "` must be a 2 element array: [lat, lng].");
+            }
+
+            return coerce_geopoint(dirty_values, a_field, document, field_name, array_iter, is_array, array_ele_erased);
+        };
+    }
+}
+
+void Index::compile_validation_plan(const std::unordered_map<std::string, field>& search_schema,
+                                    validation_plan_t& validation_plan) {
+    validation_plan.field_checks.clear();
+
+    for(const auto& field_pair: search_schema) {
+        if(field_pair.first == "id") {
+            continue;
+        }
+
+        validation_plan_t::field_check_t field_check(field_pair.second);
+        init_field_check(field_check);
+        validation_plan.field_checks.push_back(std::move(field_check));
+    }
+}
+
 Option<uint32_t> Index::validate_index_in_memory(nlohmann::json& document, uint32_t seq_id,
                                                  const std::string & default_sorting_field,
-                                                 const std::unordered_map<std::string, field> & search_schema,
+                                                 const validation_plan_t& validation_plan,
                                                  const std::map<std::string, field> & facet_schema,
                                                  const index_operation_t op,
                                                  const std::string& fallback_field_type,
@@ -268,136 +416,75 @@ Option<uint32_t> Index::validate_index_in_memory(nlohmann::json& document, uint3
                 "but is not found in the document.");
     }
 
-    for(const auto& field_pair: search_schema) {
-        const std::string& field_name = field_pair.first;
-        const field& a_field = field_pair.second;
-
-        if(field_name == "id") {
-            continue;
-        }
+    for(const auto& field_check: validation_plan.field_checks) {
+        const field& a_field = field_check.a_field;
+        const std::string& field_name = a_field.name;
+        auto value_it = document.find(field_name);
 
-        if((a_field.optional || op == UPDATE) && document.count(field_name) == 0) {
-            continue;
-        }
+        if(value_it == document.end()) {
+            if(a_field.optional || op == UPDATE) {
+                continue;
+            }
 
-        if(document.count(field_name) == 0) {
             return Option<>(400, "Field `" + field_name  + "` has been declared in the schema, "
                                  "but is not found in the document.");
         }
 
-        if(a_field.optional && document[field_name].is_null()) {
+        if(a_field.optional && value_it->is_null()) {
             // we will ignore `null` on an option field
             if(op != UPDATE) {
                 // for updates, the erasure is done later since we need to keep the key for overwrite
-                document.erase(field_name);
+                document.erase(value_it);
             }
             continue;
         }
 
-        nlohmann::json::iterator dummy_iter;
         bool array_ele_erased = false;
 
-        if(a_field.type == field_types::STRING && !document[field_name].is_string()) {
-            Option<uint32_t> coerce_op = coerce_string(dirty_values, fallback_field_type, a_field, document, field_name, dummy_iter, false, array_ele_erased);
-            if(!coerce_op.ok()) {
-                return coerce_op;
-            }
-        } else if(a_field.type == field_types::INT32) {
-            if(!document[field_name].is_number_integer()) {
-                Option<uint32_t> coerce_op = coerce_int32_t(dirty_values, a_field, document, field_name, dummy_iter, false, array_ele_erased);
+        if(!field_check.is_array) {
+            if(field_check.is_valid != nullptr && !field_check.is_valid(*value_it)) {
+                nlohmann::json::iterator dummy_iter;
+                Option<uint32_t> coerce_op = field_check.coerce(dirty_values, fallback_field_type, a_field, document,
+                                                                field_name, dummy_iter, false, array_ele_erased);
                 if(!coerce_op.ok()) {
                     return coerce_op;
                 }
             }
-        } else if(a_field.type == field_types::INT64 && !document[field_name].is_number_integer()) {
-            Option<uint32_t> coerce_op = coerce_int64_t(dirty_values, a_field, document, field_name, dummy_iter, false, array_ele_erased);
-            if(!coerce_op.ok()) {
-                return coerce_op;
-            }
-        } else if(a_field.type == field_types::FLOAT && !document[field_name].is_number()) {
-            // using `is_number` allows integer to be passed to a float field
-            Option<uint32_t> coerce_op = coerce_float(dirty_values, a_field, document, field_name, dummy_iter, false, array_ele_erased);
-            if(!coerce_op.ok()) {
-                return coerce_op;
-            }
-        } else if(a_field.type == field_types::BOOL && !document[field_name].is_boolean()) {
-            Option<uint32_t> coerce_op = coerce_bool(dirty_values, a_field, document, field_name, dummy_iter, false, array_ele_erased);
-            if(!coerce_op.ok()) {
-                return coerce_op;
-            }
-        } else if(a_field.type == field_types::GEOPOINT) {
-            if(!document[field_name].is_array() || document[field_name].size() != 2) {
-                return Option<>(400, "Field `" + field_name  + "` must be a 2 element array: [lat, lng].");
-            }
 
-            if(!(document[field_name][0].is_number() && document[field_name][1].is_number())) {
-                // one or more elements is not an number, try to coerce
-                Option<uint32_t> coerce_op = coerce_geopoint(dirty_values, a_field, document, field_name, dummy_iter, false, array_ele_erased);
-                if(!coerce_op.ok()) {
-                    return coerce_op;
-                }
-            }
-        } else if(a_field.is_array()) {
-            if(!document[field_name].is_array()) {
-                if(a_field.optional && (dirty_values == DIRTY_VALUES::DROP ||
-                                          dirty_values == DIRTY_VALUES::COERCE_OR_DROP)) {
-                    document.erase(field_name);
-                    continue;
-                } else {
-                    return Option<>(400, "Field `" + field_name  + "` must be an array.");
-                }
+            continue;
+        }
+
+        if(!value_it->is_array()) {
+            if(a_field.optional && (dirty_values == DIRTY_VALUES::DROP ||
+                                    dirty_values == DIRTY_VALUES::COERCE_OR_DROP)) {
+                document.erase(value_it);
+                continue;
+            } else {
+                return Option<>(400, "Field `" + field_name  + "` must be an array.");
             }
+        }
 
-            nlohmann::json::iterator it = document[field_name].begin();
-            for(; it != document[field_name].end(); ) {
-                const auto& item = it.value();
-                array_ele_erased = false;
+        if(field_check.is_valid == nullptr) {
+            continue;
+        }
 
-                if (a_field.type == field_types::STRING_ARRAY && !item.is_string()) {
-                    Option<uint32_t> coerce_op = coerce_string(dirty_values, fallback_field_type, a_field, document, field_name, it, true, array_ele_erased);
-                    if (!coerce_op.ok()) {
-                        return coerce_op;
-                    }
-                } else if (a_field.type == field_types::INT32_ARRAY && !item.is_number_integer()) {
-                    Option<uint32_t> coerce_op = coerce_int32_t(dirty_values, a_field, document, field_name, it, true, array_ele_erased);
-                    if (!coerce_op.ok()) {
-                        return coerce_op;
-                    }
-                } else if (a_field.type == field_types::INT64_ARRAY && !item.is_number_integer()) {
-                    Option<uint32_t> coerce_op = coerce_int64_t(dirty_values, a_field, document, field_name, it, true, array_ele_erased);
-                    if (!coerce_op.ok()) {
-                        return coerce_op;
-                    }
-                } else if (a_field.type == field_types::FLOAT_ARRAY && !item.is_number()) {
-                    // we check for `is_number` to allow whole numbers to be passed into float fields
-                    Option<uint32_t> coerce_op = coerce_float(dirty_values, a_field, document, field_name, it, true, array_ele_erased);
-                    if (!coerce_op.ok()) {
-                        return coerce_op;
-                    }
-                } else if (a_field.type == field_types::BOOL_ARRAY && !item.is_boolean()) {
-                    Option<uint32_t> coerce_op = coerce_bool(dirty_values, a_field, document, field_name, it, true, array_ele_erased);
-                    if (!coerce_op.ok()) {
-                        return coerce_op;
-                    }
-                } else if (a_field.type == field_types::GEOPOINT_ARRAY) {
-                    if(!item.is_array() || item.size() != 2) {
-                        return Option<>(400, "Field `" + field_name  + "` must contain 2 element arrays: [ [lat, lng],... ].");
-                    }
+        nlohmann::json& values = value_it.value();
 
-                    if(!(item[0].is_number() && item[1].is_number())) {
-                        // one or more elements is not an number, try to coerce
-                        Option<uint32_t> coerce_op = coerce_geopoint(dirty_values, a_field, document, field_name, it, true, array_ele_erased);
-                        if(!coerce_op.ok()) {
-                            return coerce_op;
-                        }
-                    }
-                }
+        for(nlohmann::json::iterator it = values.begin(); it != values.end(); ) {
+            array_ele_erased = false;
 
-                if(!array_ele_erased) {
-                    // if it is erased, the iterator will be reassigned
-                    it++;
+            if(!field_check.is_valid(it.value())) {
+                Option<uint32_t> coerce_op = field_check.coerce(dirty_values, fallback_field_type, a_field, document,
+                                                                field_name, it, true, array_ele_erased);
+                if(!coerce_op.ok()) {
+                    return coerce_op;
                 }
             }
+
+            if(!array_ele_erased) {
+                // if it is erased, the iterator will be reassigned
+                it++;
+            }
         }
     }
 
@@ -408,6 +495,7 @@ void Index::validate_and_preprocess(Index *index, std::vector<index_record>& ite
                                       const size_t batch_start_index, const size_t batch_size,
                                       const std::string& default_sorting_field,
                                       const std::unordered_map<std::string, field>& search_schema,
+                                      const validation_plan_t& validation_plan,
                                       const std::map<std::string, field>& facet_schema,
                                       const std::string& fallback_field_type,
                                       const std::vector<char>& token_separators,
@@ -415,6 +503,8 @@ void Index::validate_and_preprocess(Index *index, std::vector<index_record>& ite
 
     // runs in a partitioned thread
 
+    tokenization_cache_t tokenization_cache;
+
     for(size_t i = 0; i < batch_size; i++) {
         index_record& index_rec = iter_batch[batch_start_index + i];
 
@@ -430,7 +520,7 @@ void Index::validate_and_preprocess(Index *index, std::vector<index_record>& ite
 
             Option<uint32_t> validation_op = validate_index_in_memory(index_rec.doc, index_rec.seq_id,
                                                                       default_sorting_field,
-                                                                      search_schema, facet_schema,
+                                                                      validation_plan, facet_schema,
                                                                       index_rec.operation,
                                                                       fallback_field_type,
                                                                       index_rec.dirty_values);
@@ -447,7 +537,8 @@ void Index::validate_and_preprocess(Index *index, std::vector<index_record>& ite
                 scrub_reindex_doc(search_schema, index_rec.doc, index_rec.del_doc, index_rec.old_doc);
             }
 
-            compute_token_offsets_facets(index_rec, search_schema, facet_schema, token_separators, symbols_to_index);
+            compute_token_offsets_facets(index_rec, search_schema, facet_schema, token_separators, symbols_to_index,
+                                         &tokenization_cache);
 
             int64_t points = 0;
 
@@ -479,6 +570,7 @@ void Index::validate_and_preprocess(Index *index, std::vector<index_record>& ite
 size_t Index::batch_memory_index(Index *index, std::vector<index_record>& iter_batch,
                                  const std::string & default_sorting_field,
                                  const std::unordered_map<std::string, field> & search_schema,
+                                 const validation_plan_t& validation_plan,
                                  const std::map<std::string, field> & facet_schema,
                                  const std::string& fallback_field_type,
                                  const std::vector<char>& token_separators,
@@ -508,7 +600,7 @@ size_t Index::batch_memory_index(Index *index, std::vector<index_record>& iter_b
 
         index->thread_pool->enqueue([&, batch_index, batch_len]() {
             validate_and_preprocess(index, iter_batch, batch_index, batch_len, default_sorting_field, search_schema,
-                                    facet_schema, fallback_field_type,
+                                    validation_plan, facet_schema, fallback_field_type,
                                     token_separators, symbols_to_index);
 
             std::unique_lock<std::mutex> lock(m_process);
@@ -601,6 +693,12 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
     if(afield.is_string() || non_string_facet_field) {
         std::unordered_map<std::string, std::vector<art_document>> token_to_doc_offsets;
         int64_t max_score = INT64_MIN;
+        std::vector<std::pair<uint32_t, uint32_t>> seq_id_skipped_position_bytes;
+
+        auto suggestion_index_it = suggestion_index.find(afield.name);
+        std::map<std::string, int64_t> phrase_counts;
+
+        auto forward_index_it = afield.is_string() ? forward_index.find(afield.name) : forward_index.end();
 
         for(const auto& record: iter_batch) {
             if(!record.indexed.ok()) {
@@ -636,11 +734,63 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
                 max_score = record.points;
             }
 
+            if(suggestion_index_it != suggestion_index.end()) {
+                std::vector<std::string> phrases;
+                get_suggestion_phrases(document, afield, phrases);
+                for(const auto& phrase: phrases) {
+                    phrase_counts[phrase]++;
+                }
+            }
+
+            if(forward_index_it != forward_index.end()) {
+                std::string& doc_tokens = (*forward_index_it->second)[seq_id];
+                doc_tokens.clear();
+
+                for(const auto& token_offsets: field_index_it->second.offsets) {
+                    doc_tokens.append(token_offsets.first.c_str(), token_offsets.first.size() + 1);
+                }
+
+                doc_tokens.shrink_to_fit();
+            }
+
+            if(!afield.positions) {
+                std::vector<uint32_t> stripped_offsets;
+                uint32_t num_skipped_position_bytes = 0;
+
+                for(auto &token_offsets: field_index_it->second.offsets) {
+                    strip_token_positions(afield.is_array(), token_offsets.second, stripped_offsets);
+                    num_skipped_position_bytes += (token_offsets.second.size() - stripped_offsets.size()) *
+                                                  sizeof(uint32_t);
+                    token_to_doc_offsets[token_offsets.first].emplace_back(seq_id, record.points, stripped_offsets);
+                }
+
+                seq_id_skipped_position_bytes.emplace_back(seq_id, num_skipped_position_bytes);
+                continue;
+            }
+
             for(auto &token_offsets: field_index_it->second.offsets) {
                 token_to_doc_offsets[token_offsets.first].emplace_back(seq_id, record.points, token_offsets.second);
             }
         }
 
+        if(!seq_id_skipped_position_bytes.empty()) {
+            std::unique_lock lock(skipped_position_bytes_mutex);
+            size_t& field_skipped_position_bytes = skipped_position_bytes[afield.name];
+            auto& field_doc_skipped_position_bytes = doc_skipped_position_bytes[afield.name];
+
+            for(const auto& seq_id_bytes: seq_id_skipped_position_bytes) {
+                // a reindexed document replaces its previous share
+                uint32_t& doc_bytes = field_doc_skipped_position_bytes[seq_id_bytes.first];
+                field_skipped_position_bytes -= doc_bytes;
+                field_skipped_position_bytes += seq_id_bytes.second;
+                doc_bytes = seq_id_bytes.second;
+            }
+        }
+
+        for(const auto& phrase_count: phrase_counts) {
+            suggestion_index_it->second->add(phrase_count.first, phrase_count.second);
+        }
+
         auto tree_it = search_index.find(afield.faceted_name());
         if(tree_it == search_index.end()) {
             return;
@@ -648,15 +798,24 @@ void Index::index_field_in_memory(const field& afield, std::vector<index_record>
 
         art_tree *t = tree_it->second;
 
+        std::vector<art_key_documents> keys;
+        keys.reserve(token_to_doc_offsets.size());
+
         for(auto& token_to_doc: token_to_doc_offsets) {
             const std::string& token = token_to_doc.first;
-            std::vector<art_document>& documents = token_to_doc.second;
-
             const auto *key = (const unsigned char *) token.c_str();
             int key_len = (int) token.length() + 1;  // for the terminating \0 char
+            keys.push_back({key, key_len, &token_to_doc.second});
+        }
 
-            //LOG(INFO) << "key: " << key << ", art_doc.id: " << art_doc.id;
-            art_inserts(t, key, key_len, max_score, documents);
+        // tokens of a large batch are spread across threads by their first byte
+        art_inserts_batch(t, keys, max_score, thread_pool);
+
+        auto infix_index_it = infix_index.find(afield.name);
+        if(infix_index_it != infix_index.end()) {
+            for(const auto& token_to_doc: token_to_doc_offsets) {
+                infix_index_it->second->add(token_to_doc.first);
+            }
         }
     }
 
@@ -845,34 +1004,73 @@ uint64_t Index::facet_token_hash(const field & a_field, const std::string &token
     return hash;
 }
 
-void Index::tokenize_string_with_facets(const std::string& text, bool is_facet, const field& a_field,
-                                        const std::vector<char>& symbols_to_index,
-                                        const std::vector<char>& token_separators,
-                                        std::unordered_map<std::string, std::vector<uint32_t>>& token_to_offsets,
-                                        std::vector<uint64_t>& facet_hashes) {
+const tokenized_value_t& Index::tokenize_value(const std::string& text, bool is_facet, const field& a_field,
+                                               const std::vector<char>& symbols_to_index,
+                                               const std::vector<char>& token_separators,
+                                               std::unordered_map<std::string, tokenized_value_t>* value_cache,
+                                               std::unique_ptr<Tokenizer>& tokenizer,
+                                               tokenized_value_t& value) {
+    if(value_cache != nullptr) {
+        auto value_it = value_cache->find(text);
+        if(value_it != value_cache->end()) {
+            return value_it->second;
+        }
+    }
+
+    // the values of an array share a tokenizer
+    if(tokenizer == nullptr) {
+        tokenizer.reset(new Tokenizer(text, true, !a_field.is_string(), a_field.locale,
+                                      symbols_to_index, token_separators));
+    } else {
+        tokenizer->reset(text);
+    }
 
-    Tokenizer tokenizer(text, true, !a_field.is_string(), a_field.locale, symbols_to_index, token_separators);
     std::string token;
-    std::string last_token;
     size_t token_index = 0;
 
-    while(tokenizer.next(token, token_index)) {
+    while(tokenizer->next(token, token_index)) {
         if(token.empty()) {
             continue;
         }
 
-        token_to_offsets[token].push_back(token_index + 1);
-        last_token = token;
+        value.tokens.emplace_back(token, token_index);
+    }
+
+    if(is_facet) {
+        value.facet_hash = facet_token_hash(a_field, text);
+    }
+
+    if(value_cache != nullptr && text.size() <= MAX_CACHED_VALUE_LEN &&
+       value_cache->size() < MAX_CACHED_VALUES_PER_FIELD) {
+        return value_cache->emplace(text, std::move(value)).first->second;
     }
 
-    if(!token_to_offsets.empty()) {
+    return value;
+}
+
+void Index::tokenize_string_with_facets(const std::string& text, bool is_facet, const field& a_field,
+                                        const std::vector<char>& symbols_to_index,
+                                        const std::vector<char>& token_separators,
+                                        std::unordered_map<std::string, std::vector<uint32_t>>& token_to_offsets,
+                                        std::vector<uint64_t>& facet_hashes,
+                                        std::unordered_map<std::string, tokenized_value_t>* value_cache) {
+
+    std::unique_ptr<Tokenizer> tokenizer;
+    tokenized_value_t uncached_value;
+    const tokenized_value_t& value = tokenize_value(text, is_facet, a_field, symbols_to_index, token_separators,
+                                                    value_cache, tokenizer, uncached_value);
+
+    for(const auto& token_pos: value.tokens) {
+        token_to_offsets[token_pos.first].push_back(token_pos.second + 1);
+    }
+
+    if(!value.tokens.empty()) {
         // push 0 for the last occurring token (used for exact match ranking)
-        token_to_offsets[last_token].push_back(0);
+        token_to_offsets[value.tokens.back().first].push_back(0);
     }
 
     if(is_facet) {
-        uint64_t hash = Index::facet_token_hash(a_field, text);
-        facet_hashes.push_back(hash);
+        facet_hashes.push_back(value.facet_hash);
     }
 }
 
@@ -907,37 +1105,31 @@ void Index::tokenize_string_array_with_facets(const std::vector<std::string>& st
                                               const std::vector<char>& symbols_to_index,
                                               const std::vector<char>& token_separators,
                                               std::unordered_map<std::string, std::vector<uint32_t>>& token_to_offsets,
-                                              std::vector<uint64_t>& facet_hashes) {
+                                              std::vector<uint64_t>& facet_hashes,
+                                              std::unordered_map<std::string, tokenized_value_t>* value_cache) {
+
+    std::unique_ptr<Tokenizer> tokenizer;
 
     for(size_t array_index = 0; array_index < strings.size(); array_index++) {
         const std::string& str = strings[array_index];
         std::set<std::string> token_set;  // required to deal with repeating tokens
 
-        Tokenizer tokenizer(str, true, !a_field.is_string(), a_field.locale, symbols_to_index, token_separators);
-        std::string token, last_token;
-        size_t token_index = 0;
+        tokenized_value_t uncached_value;
+        const tokenized_value_t& value = tokenize_value(str, is_facet, a_field, symbols_to_index, token_separators,
+                                                        value_cache, tokenizer, uncached_value);
 
         // iterate and append offset positions
-        while(tokenizer.next(token, token_index)) {
-            if(token.empty()) {
-                continue;
-            }
-
-            token_to_offsets[token].push_back(token_index + 1);
-            token_set.insert(token);
-            last_token = token;
+        for(const auto& token_pos: value.tokens) {
+            token_to_offsets[token_pos.first].push_back(token_pos.second + 1);
+            token_set.insert(token_pos.first);
         }
 
-        //LOG(INFO) << "Str: " << str << ", last_token: " << last_token;
-
         if(token_set.empty()) {
             continue;
         }
 
         if(is_facet) {
-            uint64_t hash = facet_token_hash(a_field, str);
-            //LOG(INFO) << "indexing " << token  << ", hash:" << hash;
-            facet_hashes.push_back(hash);
+            facet_hashes.push_back(value.facet_hash);
         }
 
         for(auto& the_token: token_set) {
@@ -949,7 +1141,7 @@ void Index::tokenize_string_array_with_facets(const std::vector<std::string>& st
         }
 
         // push 0 for the last occurring token (used for exact match ranking)
-        token_to_offsets[last_token].push_back(0);
+        token_to_offsets[value.tokens.back().first].push_back(0);
     }
 }
 
@@ -1063,7 +1255,7 @@ void Index::aggregate_topster(Topster* agg_topster, Topster* index_topster) {
     }
 }
 
-void Index::search_candidates(const uint8_t & field_id, bool field_is_array,
+void Index::search_candidates(const uint8_t & field_id, bool field_is_array, bool field_has_positions,
                               const uint32_t* filter_ids, size_t filter_ids_length,
                               const uint32_t* exclude_token_ids, size_t exclude_token_ids_size,
                               const std::vector<uint32_t>& curated_ids,
@@ -1089,9 +1281,10 @@ void Index::search_candidates(const uint8_t & field_id, bool field_is_array,
 
     int sort_order[3]; // 1 or -1 based on DESC or ASC respectively
     std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3> field_values;
+    std::array<sort_slot_t, 3> sort_slots;
     std::vector<size_t> geopoint_indices;
 
-    populate_sort_mapping(sort_order, geopoint_indices, sort_fields, field_values);
+    populate_sort_mapping(sort_order, geopoint_indices, sort_fields, field_values, sort_slots);
 
     size_t combination_limit = exhaustive_search ? Index::COMBINATION_MAX_LIMIT : Index::COMBINATION_MIN_LIMIT;
 
@@ -1166,18 +1359,24 @@ void Index::search_candidates(const uint8_t & field_id, bool field_is_array,
                 topsters[i] = new Topster(topster->MAX_SIZE, topster->distinct);
             }
 
-            posting_t::block_intersector_t(
-                posting_lists, iter_state, thread_pool, 100
-            )
-            .intersect([&](uint32_t seq_id, std::vector<posting_list_t::iterator_t>& its, size_t index) {
-                score_results(sort_fields, searched_queries.size(), field_id, field_is_array,
-                              total_cost, topsters[index], query_suggestion, groups_processed_vec[index],
-                              seq_id, sort_order, field_values, geopoint_indices,
-                              group_limit, group_by_fields, token_bits,
-                              prioritize_exact_match, single_exact_query_token, its);
-
-                result_id_vecs[index].push_back(seq_id);
-            }, concurrency);
+            // generic lambdas cannot capture variable length arrays
+            Topster** thread_topsters = topsters;
+            std::vector<uint32_t>* thread_result_id_vecs = result_id_vecs;
+
+            dispatch_score_kernel(sort_slots, group_limit != 0, [&](auto kernel) {
+                posting_t::block_intersector_t(
+                    posting_lists, iter_state, thread_pool, 100
+                )
+                .intersect([&](uint32_t seq_id, std::vector<posting_list_t::iterator_t>& its, size_t index) {
+                    score_results(kernel, sort_fields, searched_queries.size(), field_id, field_is_array,
+                                  field_has_positions, total_cost, thread_topsters[index], query_suggestion, groups_processed_vec[index],
+                                  seq_id, sort_order, field_values, sort_slots, geopoint_indices,
+                                  group_limit, group_by_fields, token_bits,
+                                  prioritize_exact_match, single_exact_query_token, its);
+
+                    thread_result_id_vecs[index].push_back(seq_id);
+                }, concurrency);
+            });
         }
 
         delete [] excluded_result_ids;
@@ -1470,6 +1669,8 @@ void Index::do_filtering(uint32_t*& filter_ids, uint32_t& filter_ids_length,
             uint32_t* ids = nullptr;
             size_t ids_size = 0;
 
+            std::unique_ptr<Tokenizer> tokenizer;
+
             for(const std::string & filter_value: a_filter.values) {
                 uint32_t* strt_ids = nullptr;
                 size_t strt_ids_size = 0;
@@ -1479,13 +1680,18 @@ void Index::do_filtering(uint32_t*& filter_ids, uint32_t& filter_ids_length,
                 // there could be multiple tokens in a filter value, which we have to treat as ANDs
                 // e.g. country: South Africa
 
-                Tokenizer tokenizer(filter_value, true, false, f.locale, symbols_to_index, token_separators);
+                if(tokenizer == nullptr) {
+                    tokenizer.reset(new Tokenizer(filter_value, true, false, f.locale,
+                                                  symbols_to_index, token_separators));
+                } else {
+                    tokenizer->reset(filter_value);
+                }
 
                 std::string str_token;
                 size_t token_index = 0;
                 std::vector<std::string> str_tokens;
 
-                while(tokenizer.next(str_token, token_index)) {
+                while(tokenizer->next(str_token, token_index)) {
                     str_tokens.push_back(str_token);
 
                     art_leaf* leaf = (art_leaf *) art_search(t, (const unsigned char*) str_token.c_str(),
@@ -2684,8 +2890,9 @@ void Index::search_wildcard(const std::vector<std::string>& qtokens, const std::
 
     int sort_order[3]; // 1 or -1 based on DESC or ASC respectively
     std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3> field_values;
+    std::array<sort_slot_t, 3> sort_slots;
     std::vector<size_t> geopoint_indices;
-    populate_sort_mapping(sort_order, geopoint_indices, sort_fields_std, field_values);
+    populate_sort_mapping(sort_order, geopoint_indices, sort_fields_std, field_values, sort_slots);
 
     uint32_t token_bits = 255;
     const bool check_for_circuit_break = (filter_ids_length > 1000000);
@@ -2700,6 +2907,9 @@ void Index::search_wildcard(const std::vector<std::string>& qtokens, const std::
     Topster* topsters[num_threads];
     std::vector<posting_list_t::iterator_t> plists;
 
+    // partitions hold disjoint documents, so the heap minimum of one partition bounds the others
+    topster_threshold_t shared_threshold;
+
     size_t num_processed = 0;
     std::mutex m_process;
     std::condition_variable cv_process;
@@ -2726,7 +2936,8 @@ void Index::search_wildcard(const std::vector<std::string>& qtokens, const std::
         thread_pool->enqueue([this, &parent_search_begin, &parent_search_stop_ms, &parent_search_cutoff,
                              thread_id, &sort_fields_std, &searched_queries, &field_id,
                              &group_limit, &group_by_fields, &topsters, &tgroups_processed,
-                             &sort_order, field_values, &geopoint_indices, &token_bits, &plists,
+                             &sort_order, &field_values, &sort_slots, &geopoint_indices, &token_bits, &plists,
+                             &shared_threshold,
                              check_for_circuit_break,
                              batch_result_ids, batch_res_len,
                              &num_processed, &m_process, &cv_process]() {
@@ -2735,18 +2946,27 @@ void Index::search_wildcard(const std::vector<std::string>& qtokens, const std::
             search_stop_ms = parent_search_stop_ms;
             search_cutoff = parent_search_cutoff;
 
-            for(size_t i = 0; i < batch_res_len; i++) {
-                const uint32_t seq_id = batch_result_ids[i];
-                score_results(sort_fields_std, (uint16_t) searched_queries.size(), field_id, false, 0,
-                              topsters[thread_id], {}, tgroups_processed[thread_id], seq_id, sort_order, field_values,
-                              geopoint_indices, group_limit, group_by_fields, token_bits,
-                              false, false, plists);
+            // generic lambdas cannot capture variable length arrays
+            Topster* thread_topster = topsters[thread_id];
+            spp::sparse_hash_set<uint64_t>& thread_groups_processed = tgroups_processed[thread_id];
+
+            dispatch_score_kernel(sort_slots, group_limit != 0, [&](auto kernel) {
+                // (1 << 15) is a multiple of the score batch size
+                const size_t breaker_batch_size = check_for_circuit_break ? (1 << 15) : batch_res_len;
+
+                for(size_t i = 0; i < batch_res_len; i += breaker_batch_size) {
+                    const size_t num_seq_ids = std::min(breaker_batch_size, batch_res_len - i);
+                    score_results_batch(kernel, sort_fields_std, (uint16_t) searched_queries.size(), field_id,
+                                        thread_topster, &shared_threshold, thread_groups_processed,
+                                        batch_result_ids + i, num_seq_ids, sort_order, field_values, sort_slots,
+                                        geopoint_indices, group_by_fields, token_bits, plists);
 
-                if(check_for_circuit_break && ((i + 1) % (1 << 15)) == 0) {
-                    // check only once every 2^15 docs to reduce overhead
-                    BREAK_CIRCUIT_BREAKER
+                    if(check_for_circuit_break) {
+                        // check only once every 2^15 docs to reduce overhead
+                        BREAK_CIRCUIT_BREAKER
+                    }
                 }
-            }
+            });
 
             std::unique_lock<std::mutex> lock(m_process);
             num_processed++;
@@ -2783,7 +3003,11 @@ void Index::search_wildcard(const std::vector<std::string>& qtokens, const std::
 
 void Index::populate_sort_mapping(int* sort_order, std::vector<size_t>& geopoint_indices,
                                   const std::vector<sort_by>& sort_fields_std,
-                                  std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3>& field_values) const {
+                                  std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3>& field_values,
+                                  std::array<sort_slot_t, 3>& sort_slots) const {
+    field_values.fill(nullptr);
+    sort_slots.fill(sort_slot_t::NONE);
+
     for (size_t i = 0; i < sort_fields_std.size(); i++) {
         sort_order[i] = 1;
         if (sort_fields_std[i].order == sort_field_const::asc) {
@@ -2791,24 +3015,81 @@ void Index::populate_sort_mapping(int* sort_order, std::vector<size_t>& geopoint
         }
 
         if (sort_fields_std[i].name == sort_field_const::text_match) {
-            field_values[i] = &text_match_sentinel_value;
+            sort_slots[i] = sort_slot_t::TEXT_MATCH;
         } else if (sort_fields_std[i].name == sort_field_const::seq_id) {
-            field_values[i] = &seq_id_sentinel_value;
+            sort_slots[i] = sort_slot_t::SEQ_ID;
         } else if (sort_schema.count(sort_fields_std[i].name) != 0) {
             if (sort_schema.at(sort_fields_std[i].name).type == field_types::GEOPOINT_ARRAY) {
                 geopoint_indices.push_back(i);
                 field_values[i] = nullptr; // GEOPOINT_ARRAY uses a multi-valued index
+                sort_slots[i] = sort_slot_t::GEO;
             } else {
                 field_values[i] = sort_index.at(sort_fields_std[i].name);
 
                 if (sort_schema.at(sort_fields_std[i].name).is_geopoint()) {
                     geopoint_indices.push_back(i);
+                    sort_slots[i] = sort_slot_t::GEO;
+                } else {
+                    sort_slots[i] = sort_slot_t::VALUE;
                 }
             }
         }
     }
 }
 
+// Appends the best `max_candidates` leaves of the tokens that contain `token`, by document frequency
+void Index::search_infix(const std::string& field_name, const std::string& token,
+                         const uint32_t* filter_ids, const size_t filter_ids_length, const size_t max_candidates,
+                         const std::set<art_leaf*>& exclude_leaves, std::vector<art_leaf*>& leaves) const {
+    auto infix_index_it = infix_index.find(field_name);
+    if(infix_index_it == infix_index.end()) {
+        return ;
+    }
+
+    std::vector<std::string> matched_tokens;
+    infix_index_it->second->search(token, matched_tokens);
+
+    if(matched_tokens.empty()) {
+        return ;
+    }
+
+    std::vector<const unsigned char*> keys;
+    std::vector<int> key_lens;
+
+    for(const std::string& matched_token: matched_tokens) {
+        keys.push_back((const unsigned char*) matched_token.c_str());
+        key_lens.push_back((int) matched_token.length() + 1);
+    }
+
+    std::vector<art_leaf*> matched_leaves(keys.size());
+    art_search_batch(search_index.at(field_name), keys.data(), key_lens.data(), keys.size(), matched_leaves.data());
+
+    std::set<art_leaf*> found_leaves(leaves.begin(), leaves.end());
+    std::vector<art_leaf*> infix_leaves;
+
+    for(art_leaf* leaf: matched_leaves) {
+        if(leaf == nullptr || exclude_leaves.count(leaf) != 0 || found_leaves.count(leaf) != 0) {
+            continue;
+        }
+
+        if(filter_ids_length != 0 && !posting_t::contains_atleast_one(leaf->values, filter_ids, filter_ids_length)) {
+            continue;
+        }
+
+        infix_leaves.push_back(leaf);
+    }
+
+    std::sort(infix_leaves.begin(), infix_leaves.end(), [](const art_leaf* a, const art_leaf* b) {
+        return posting_t::num_ids(a->values) > posting_t::num_ids(b->values);
+    });
+
+    if(infix_leaves.size() > max_candidates) {
+        infix_leaves.resize(max_candidates);
+    }
+
+    leaves.insert(leaves.end(), infix_leaves.begin(), infix_leaves.end());
+}
+
 /*
    1. Split the query into tokens
    2. Outer loop will generate bounded cartesian product with costs for each token
@@ -2920,6 +3201,12 @@ void Index::search_field(const uint8_t & field_id,
                                  costs[token_index], costs[token_index], num_fuzzy_candidates, token_order, prefix_search,
                                  filter_ids, filter_ids_length, leaves, unique_tokens);
 
+                if(costs[token_index] == 0 && the_field.infix) {
+                    // tokens that contain the query token are matched along with the exact/prefix matches
+                    search_infix(field_name, token, filter_ids, filter_ids_length, num_fuzzy_candidates,
+                                 unique_tokens, leaves);
+                }
+
                 /*auto timeMillis = std::chrono::duration_cast<std::chrono::milliseconds>(
                                 std::chrono::high_resolution_clock::now() - begin).count();
 
@@ -2972,7 +3259,7 @@ void Index::search_field(const uint8_t & field_id,
             std::vector<uint32_t> id_buff;
 
             // If atleast one token is found, go ahead and search for candidates
-            search_candidates(field_id, the_field.is_array(), filter_ids, filter_ids_length,
+            search_candidates(field_id, the_field.is_array(), the_field.positions, filter_ids, filter_ids_length,
                               exclude_token_ids, exclude_token_ids_size,
                               curated_ids, sort_fields, token_candidates_vec, searched_queries, topster,
                               groups_processed, all_result_ids, all_result_ids_len, field_num_results,
@@ -3066,22 +3353,9 @@ void Index::log_leaves(const int cost, const std::string &token, const std::vect
     }
 }
 
-void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16_t & query_index,
-                          const uint8_t & field_id, const bool field_is_array, const uint32_t total_cost,
-                          Topster* topster /**/,
-                          const std::vector<art_leaf *> &query_suggestion,
-                          spp::sparse_hash_set<uint64_t>& groups_processed /**/,
-                          const uint32_t seq_id, const int sort_order[3],
-                          std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3> field_values /**/,
-                          const std::vector<size_t>& geopoint_indices,
-                          const size_t group_limit, const std::vector<std::string>& group_by_fields,
-                          const uint32_t token_bits,
-                          const bool prioritize_exact_match,
-                          const bool single_exact_query_token,
-                          const std::vector<posting_list_t::iterator_t>& posting_lists) const {
-
-    int64_t geopoint_distances[3];
-
+void Index::compute_geo_distances(const std::vector<sort_by>& sort_fields, const uint32_t seq_id,
+                                  const std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3>& field_values,
+                                  const std::vector<size_t>& geopoint_indices, int64_t* geopoint_distances) const {
     for(auto& i: geopoint_indices) {
         spp::sparse_hash_map<uint32_t, int64_t>* geopoints = field_values[i];
         int64_t dist = INT32_MAX;
@@ -3127,15 +3401,18 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
         }
 
         geopoint_distances[i] = dist;
-
-        // Swap (id -> latlong) index to (id -> distance) index
-        field_values[i] = &geo_sentinel_value;
     }
+}
 
-    //auto begin = std::chrono::high_resolution_clock::now();
-    //const std::string first_token((const char*)query_suggestion[0]->key, query_suggestion[0]->key_len-1);
-
-    uint64_t match_score = 0;
+uint64_t Index::compute_match_score(const uint32_t seq_id, const bool field_is_array,
+                                    const bool field_has_positions, const uint32_t total_cost,
+                                    const bool prioritize_exact_match, const bool single_exact_query_token,
+                                    const std::vector<posting_list_t::iterator_t>& posting_lists) {
+    if(!field_has_positions) {
+        // only a placeholder offset is stored per document, so every token of the suggestion is present
+        Match bag_of_words_match = Match(posting_lists.size(), 0, 0);
+        return bag_of_words_match.get_match_score(total_cost);
+    }
 
     if (posting_lists.size() <= 1) {
         const uint8_t is_verbatim_match = uint8_t(
@@ -3143,10 +3420,29 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
             posting_list_t::is_single_token_verbatim_match(posting_lists[0], field_is_array)
         );
         Match single_token_match = Match(1, 0, is_verbatim_match);
-        match_score = single_token_match.get_match_score(total_cost);
-    } else {
-        uint64_t total_tokens_found = 0, total_num_typos = 0, total_distance = 0, total_verbatim = 0;
+        return single_token_match.get_match_score(total_cost);
+    }
+
+    uint64_t total_tokens_found = 0, total_num_typos = 0, total_distance = 0, total_verbatim = 0;
 
+    auto add_match_score = [&](const Match& match) {
+        uint64_t this_match_score = match.get_match_score(total_cost);
+
+        total_tokens_found += ((this_match_score >> 24) & 0xFF);
+        total_num_typos += 255 - ((this_match_score >> 16) & 0xFF);
+        total_distance += 100 - ((this_match_score >> 8) & 0xFF);
+        total_verbatim += (this_match_score & 0xFF);
+    };
+
+    if(!field_is_array) {
+        // plain fields have a single set of positions: score them from per-thread buffers without allocating
+        thread_local doc_token_positions_t doc_token_positions;
+        posting_list_t::get_offsets(posting_lists, doc_token_positions);
+
+        if(!doc_token_positions.tokens.empty()) {
+            add_match_score(Match(seq_id, doc_token_positions, false, prioritize_exact_match));
+        }
+    } else {
         std::unordered_map<size_t, std::vector<token_positions_t>> array_token_positions;
         posting_list_t::get_offsets(posting_lists, array_token_positions);
 
@@ -3155,110 +3451,230 @@ void Index::score_results(const std::vector<sort_by> & sort_fields, const uint16
             if (token_positions.empty()) {
                 continue;
             }
-            const Match &match = Match(seq_id, token_positions, false, prioritize_exact_match);
-            uint64_t this_match_score = match.get_match_score(total_cost);
-
-            total_tokens_found += ((this_match_score >> 24) & 0xFF);
-            total_num_typos += 255 - ((this_match_score >> 16) & 0xFF);
-            total_distance += 100 - ((this_match_score >> 8) & 0xFF);
-            total_verbatim += (this_match_score & 0xFF);
 
-            /*std::ostringstream os;
-            os << name << ", total_cost: " << (255 - total_cost)
-               << ", words_present: " << match.words_present
-               << ", match_score: " << match_score
-               << ", match.distance: " << match.distance
-               << ", seq_id: " << seq_id << std::endl;
-            LOG(INFO) << os.str();*/
+            add_match_score(Match(seq_id, token_positions, false, prioritize_exact_match));
         }
-
-        match_score = (
-            (uint64_t(total_tokens_found) << 24) |
-            (uint64_t(255 - total_num_typos) << 16) |
-            (uint64_t(100 - total_distance) << 8) |
-            (uint64_t(total_verbatim) << 0)
-        );
-
-        /*LOG(INFO) << "Match score: " << match_score << ", for seq_id: " << seq_id
-                  << " - total_tokens_found: " << total_tokens_found
-                  << " - total_num_typos: " << total_num_typos
-                  << " - total_distance: " << total_distance
-                  << " - total_verbatim: " << total_verbatim
-                  << " - total_cost: " << total_cost;*/
     }
 
-    const int64_t default_score = INT64_MIN;  // to handle field that doesn't exist in document (e.g. optional)
-    int64_t scores[3] = {0};
-    size_t match_score_index = 0;
+    /*LOG(INFO) << "Match score for seq_id: " << seq_id
+              << " - total_tokens_found: " << total_tokens_found
+              << " - total_num_typos: " << total_num_typos
+              << " - total_distance: " << total_distance
+              << " - total_verbatim: " << total_verbatim
+              << " - total_cost: " << total_cost;*/
+
+    return (
+        (uint64_t(total_tokens_found) << 24) |
+        (uint64_t(255 - total_num_typos) << 16) |
+        (uint64_t(100 - total_distance) << 8) |
+        (uint64_t(total_verbatim) << 0)
+    );
+}
 
-    // avoiding loop
-    if (sort_fields.size() > 0) {
-        if (field_values[0] == &text_match_sentinel_value) {
-            scores[0] = int64_t(match_score);
-            match_score_index = 0;
-        } else if (field_values[0] == &seq_id_sentinel_value) {
-            scores[0] = seq_id;
-        } else if(field_values[0] == &geo_sentinel_value) {
-            scores[0] = geopoint_distances[0];
+template<sort_slot_t slot>
+inline void Index::compute_sort_score(const size_t i, const uint32_t seq_id, const uint64_t match_score,
+                                      const int64_t* geopoint_distances, const int sort_order[3],
+                                      const std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3>& field_values,
+                                      const std::array<sort_slot_t, 3>& sort_slots,
+                                      int64_t* scores, size_t& match_score_index) {
+    if constexpr (slot == sort_slot_t::NONE) {
+        return ;
+    } else if constexpr (slot == sort_slot_t::DYNAMIC) {
+        switch(sort_slots[i]) {
+            case sort_slot_t::TEXT_MATCH:
+                compute_sort_score<sort_slot_t::TEXT_MATCH>(i, seq_id, match_score, geopoint_distances, sort_order,
+                                                            field_values, sort_slots, scores, match_score_index);
+                break;
+            case sort_slot_t::SEQ_ID:
+                compute_sort_score<sort_slot_t::SEQ_ID>(i, seq_id, match_score, geopoint_distances, sort_order,
+                                                        field_values, sort_slots, scores, match_score_index);
+                break;
+            case sort_slot_t::GEO:
+                compute_sort_score<sort_slot_t::GEO>(i, seq_id, match_score, geopoint_distances, sort_order,
+                                                     field_values, sort_slots, scores, match_score_index);
+                break;
+            case sort_slot_t::VALUE:
+                compute_sort_score<sort_slot_t::VALUE>(i, seq_id, match_score, geopoint_distances, sort_order,
+                                                       field_values, sort_slots, scores, match_score_index);
+                break;
+            default:
+                break;
+        }
+    } else {
+        if constexpr (slot == sort_slot_t::TEXT_MATCH) {
+            scores[i] = int64_t(match_score);
+            match_score_index = i;
+        } else if constexpr (slot == sort_slot_t::SEQ_ID) {
+            scores[i] = seq_id;
+        } else if constexpr (slot == sort_slot_t::GEO) {
+            scores[i] = geopoint_distances[i];
         } else {
-            auto it = field_values[0]->find(seq_id);
-            scores[0] = (it == field_values[0]->end()) ? default_score : it->second;
+            // missing value can happen for a field that doesn't exist in document (e.g. optional)
+            const int64_t default_score = INT64_MIN;
+            auto it = field_values[i]->find(seq_id);
+            scores[i] = (it == field_values[i]->end()) ? default_score : it->second;
         }
 
-        if (sort_order[0] == -1) {
-            scores[0] = -scores[0];
+        if (sort_order[i] == -1) {
+            scores[i] = -scores[i];
         }
     }
+}
 
-    if(sort_fields.size() > 1) {
-        if (field_values[1] == &text_match_sentinel_value) {
-            scores[1] = int64_t(match_score);
-            match_score_index = 1;
-        } else if (field_values[1] == &seq_id_sentinel_value) {
-            scores[1] = seq_id;
-        } else if(field_values[1] == &geo_sentinel_value) {
-            scores[1] = geopoint_distances[1];
-        } else {
-            auto it = field_values[1]->find(seq_id);
-            scores[1] = (it == field_values[1]->end()) ? default_score : it->second;
-        }
+template<sort_slot_t S0, sort_slot_t S1, sort_slot_t S2, bool grouping>
+inline void Index::compute_sort_scores(score_kernel_t<S0, S1, S2, grouping> kernel,
+                                       const std::vector<sort_by>& sort_fields, const bool field_is_array,
+                                       const bool field_has_positions,
+                                       const uint32_t total_cost, const uint32_t seq_id, const int sort_order[3],
+                                       const std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3>& field_values,
+                                       const std::array<sort_slot_t, 3>& sort_slots,
+                                       const std::vector<size_t>& geopoint_indices,
+                                       const bool prioritize_exact_match, const bool single_exact_query_token,
+                                       const std::vector<posting_list_t::iterator_t>& posting_lists,
+                                       int64_t* scores, size_t& match_score_index) const {
+
+    constexpr bool is_dynamic = (S0 == sort_slot_t::DYNAMIC);
+    constexpr bool needs_match_score = is_dynamic || S0 == sort_slot_t::TEXT_MATCH ||
+                                       S1 == sort_slot_t::TEXT_MATCH || S2 == sort_slot_t::TEXT_MATCH;
 
-        if (sort_order[1] == -1) {
-            scores[1] = -scores[1];
-        }
+    int64_t geopoint_distances[3];
+
+    if constexpr (is_dynamic) {
+        compute_geo_distances(sort_fields, seq_id, field_values, geopoint_indices, geopoint_distances);
     }
 
-    if(sort_fields.size() > 2) {
-        if (field_values[2] == &text_match_sentinel_value) {
-            scores[2] = int64_t(match_score);
-            match_score_index = 2;
-        } else if (field_values[2] == &seq_id_sentinel_value) {
-            scores[2] = seq_id;
-        } else if(field_values[2] == &geo_sentinel_value) {
-            scores[2] = geopoint_distances[2];
-        } else {
-            auto it = field_values[2]->find(seq_id);
-            scores[2] = (it == field_values[2]->end()) ? default_score : it->second;
-        }
+    uint64_t match_score = 0;
 
-        if (sort_order[2] == -1) {
-            scores[2] = -scores[2];
-        }
+    if constexpr (needs_match_score) {
+        match_score = compute_match_score(seq_id, field_is_array, field_has_positions, total_cost,
+                                          prioritize_exact_match, single_exact_query_token, posting_lists);
     }
 
+    // avoiding loop: slots that are not in use are `NONE` and compile to nothing
+    compute_sort_score<S0>(0, seq_id, match_score, geopoint_distances, sort_order, field_values, sort_slots,
+                           scores, match_score_index);
+    compute_sort_score<S1>(1, seq_id, match_score, geopoint_distances, sort_order, field_values, sort_slots,
+                           scores, match_score_index);
+    compute_sort_score<S2>(2, seq_id, match_score, geopoint_distances, sort_order, field_values, sort_slots,
+                           scores, match_score_index);
+}
+
+template<sort_slot_t S0, sort_slot_t S1, sort_slot_t S2, bool grouping>
+void Index::score_results(score_kernel_t<S0, S1, S2, grouping> kernel,
+                          const std::vector<sort_by> & sort_fields, const uint16_t & query_index,
+                          const uint8_t & field_id, const bool field_is_array, const bool field_has_positions,
+                          const uint32_t total_cost, Topster* topster /**/,
+                          const std::vector<art_leaf *> &query_suggestion,
+                          spp::sparse_hash_set<uint64_t>& groups_processed /**/,
+                          const uint32_t seq_id, const int sort_order[3],
+                          const std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3>& field_values,
+                          const std::array<sort_slot_t, 3>& sort_slots,
+                          const std::vector<size_t>& geopoint_indices,
+                          const size_t group_limit, const std::vector<std::string>& group_by_fields,
+                          const uint32_t token_bits,
+                          const bool prioritize_exact_match,
+                          const bool single_exact_query_token,
+                          const std::vector<posting_list_t::iterator_t>& posting_lists) const {
+
+    int64_t scores[3] = {0};
+    size_t match_score_index = 0;
+
+    compute_sort_scores(kernel, sort_fields, field_is_array, field_has_positions, total_cost, seq_id, sort_order,
+                        field_values, sort_slots, geopoint_indices, prioritize_exact_match, single_exact_query_token,
+                        posting_lists, scores, match_score_index);
+
     uint64_t distinct_id = seq_id;
 
-    if(group_limit != 0) {
+    if constexpr (grouping) {
         distinct_id = get_distinct_id(group_by_fields, seq_id);
         groups_processed.emplace(distinct_id);
     }
 
-    //LOG(INFO) << "Seq id: " << seq_id << ", match_score: " << match_score;
     KV kv(field_id, query_index, token_bits, seq_id, distinct_id, match_score_index, scores);
     topster->add(&kv);
+}
 
-    //long long int timeNanos = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - begin).count();
-    //LOG(INFO) << "Time taken for results iteration: " << timeNanos << "ms";
+template<sort_slot_t S0, sort_slot_t S1, sort_slot_t S2, bool grouping>
+void Index::score_results_batch(score_kernel_t<S0, S1, S2, grouping> kernel,
+                                const std::vector<sort_by>& sort_fields, const uint16_t& query_index,
+                                const uint8_t& field_id, Topster* topster, topster_threshold_t* shared_threshold,
+                                spp::sparse_hash_set<uint64_t>& groups_processed,
+                                const uint32_t* seq_ids, const size_t num_seq_ids, const int sort_order[3],
+                                const std::array<spp::sparse_hash_map<uint32_t, int64_t>*, 3>& field_values,
+                                const std::array<sort_slot_t, 3>& sort_slots,
+                                const std::vector<size_t>& geopoint_indices,
+                                const std::vector<std::string>& group_by_fields, const uint32_t token_bits,
+                                const std::vector<posting_list_t::iterator_t>& posting_lists) const {
+
+    // grouped results are aggregated per group, so there is no threshold to prune against
+    if constexpr (grouping) {
+        for(size_t i = 0; i < num_seq_ids; i++) {
+            score_results(kernel, sort_fields, query_index, field_id, false, true, 0, topster, {}, groups_processed,
+                          seq_ids[i], sort_order, field_values, sort_slots, geopoint_indices, 1,
+                          group_by_fields, token_bits, false, false, posting_lists);
+        }
+
+        return ;
+    } else {
+        // sort keys are gathered column-wise so that they can be compared against the threshold in one pass
+        int64_t batch_scores[3][SCORE_BATCH_SIZE];
+        uint32_t survivors[SCORE_BATCH_SIZE];
+        size_t match_score_index = 0;
+
+        for(size_t offset = 0; offset < num_seq_ids; offset += SCORE_BATCH_SIZE) {
+            const size_t batch_size = std::min<size_t>(SCORE_BATCH_SIZE, num_seq_ids - offset);
+
+            for(size_t i = 0; i < batch_size; i++) {
+                int64_t scores[3] = {0};
+                compute_sort_scores(kernel, sort_fields, false, true, 0, seq_ids[offset + i], sort_order,
+                                    field_values, sort_slots, geopoint_indices, false, false, posting_lists,
+                                    scores, match_score_index);
+
+                batch_scores[0][i] = scores[0];
+                batch_scores[1][i] = scores[1];
+                batch_scores[2][i] = scores[2];
+            }
+
+            int64_t threshold[3];
+            bool has_threshold = false;
+
+            if(topster->is_full()) {
+                const int64_t* min_scores = topster->min_scores();
+                threshold[0] = min_scores[0];
+                threshold[1] = min_scores[1];
+                threshold[2] = min_scores[2];
+                has_threshold = true;
+            }
+
+            if(shared_threshold != nullptr) {
+                has_threshold = shared_threshold->merge_into(threshold, has_threshold);
+            }
+
+            size_t num_survivors = batch_size;
+
+            if(has_threshold) {
+                num_survivors = Topster::filter_batch(batch_scores[0], batch_scores[1], batch_scores[2],
+                                                      batch_size, threshold, survivors);
+            } else {
+                for(size_t i = 0; i < batch_size; i++) {
+                    survivors[i] = i;
+                }
+            }
+
+            for(size_t i = 0; i < num_survivors; i++) {
+                const size_t index = survivors[i];
+                const uint32_t seq_id = seq_ids[offset + index];
+                const int64_t scores[3] = {batch_scores[0][index], batch_scores[1][index], batch_scores[2][index]};
+
+                KV kv(field_id, query_index, token_bits, seq_id, seq_id, match_score_index, scores);
+                topster->add(&kv);
+            }
+
+            if(shared_threshold != nullptr && topster->is_full()) {
+                shared_threshold->publish(topster->min_scores());
+            }
+        }
+    }
 }
 
 // pre-filter group_by_fields such that we can avoid the find() check
@@ -3352,7 +3768,10 @@ Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & doc
         // Go through all the field names and find the keys+values so that they can be removed from in-memory index
         if(search_field.type == field_types::STRING_ARRAY || search_field.type == field_types::STRING) {
             std::vector<std::string> tokens;
-            tokenize_string_field(document, search_field, tokens, search_field.locale);
+
+            if(!get_forward_index_tokens(field_name, seq_id, tokens)) {
+                tokenize_string_field(document, search_field, tokens, search_field.locale);
+            }
 
             for(size_t i = 0; i < tokens.size(); i++) {
                 const auto& token = tokens[i];
@@ -3365,9 +3784,36 @@ Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & doc
                     if (posting_t::num_ids(leaf->values) == 0) {
                         void* values = art_delete(search_index.at(field_name), key, key_len);
                         posting_t::destroy_list(values);
+
+                        auto infix_index_it = infix_index.find(field_name);
+                        if(infix_index_it != infix_index.end()) {
+                            infix_index_it->second->remove(token);
+                        }
+                    } else {
+                        // the token's document frequency dropped
+                        art_topk_update(search_index.at(field_name), leaf);
                     }
                 }
             }
+
+            if(!search_field.positions) {
+                remove_skipped_position_bytes(field_name, seq_id);
+            }
+
+            // deletions leave holes in the slabs of the tree: pack the tree once they dominate its footprint
+            art_tree* t = search_index.at(field_name);
+            if(art_is_fragmented(t)) {
+                art_compact(t);
+            }
+
+            auto suggestion_index_it = suggestion_index.find(field_name);
+            if(suggestion_index_it != suggestion_index.end()) {
+                std::vector<std::string> phrases;
+                get_suggestion_phrases(document, search_field, phrases);
+                for(const auto& phrase: phrases) {
+                    suggestion_index_it->second->add(phrase, -1);
+                }
+            }
         } else if(search_field.is_int32()) {
             const std::vector<int32_t>& values = search_field.is_single_integer() ?
                     std::vector<int32_t>{document[field_name].get<int32_t>()} :
@@ -3461,6 +3907,32 @@ Option<uint32_t> Index::remove(const uint32_t seq_id, const nlohmann::json & doc
     return Option<uint32_t>(seq_id);
 }
 
+bool Index::get_forward_index_tokens(const std::string& field_name, const uint32_t seq_id,
+                                     std::vector<std::string>& tokens) {
+    auto forward_index_it = forward_index.find(field_name);
+    if(forward_index_it == forward_index.end()) {
+        return false;
+    }
+
+    auto doc_tokens_it = forward_index_it->second->find(seq_id);
+    if(doc_tokens_it == forward_index_it->second->end()) {
+        return false;
+    }
+
+    const std::string& doc_tokens = doc_tokens_it->second;
+    size_t token_begin = 0;
+
+    while(token_begin < doc_tokens.size()) {
+        const size_t token_end = doc_tokens.find('\0', token_begin);
+        tokens.emplace_back(doc_tokens, token_begin, token_end - token_begin);
+        token_begin = token_end + 1;
+    }
+
+    // the tokens are only needed to remove the document
+    forward_index_it->second->erase(doc_tokens_it);
+    return true;
+}
+
 void Index::tokenize_string_field(const nlohmann::json& document, const field& search_field,
                                   std::vector<std::string>& tokens, const std::string& locale) {
 
@@ -3470,18 +3942,98 @@ void Index::tokenize_string_field(const nlohmann::json& document, const field& s
         Tokenizer(document[field_name], true, false, locale).tokenize(tokens);
     } else if(search_field.type == field_types::STRING_ARRAY) {
         const std::vector<std::string>& values = document[field_name].get<std::vector<std::string>>();
+        std::unique_ptr<Tokenizer> tokenizer;
+
         for(const std::string & value: values) {
-            Tokenizer(value, true, false, locale).tokenize(tokens);
+            if(tokenizer == nullptr) {
+                tokenizer.reset(new Tokenizer(value, true, false, locale));
+            } else {
+                tokenizer->reset(value);
+            }
+
+            tokenizer->tokenize(tokens);
         }
     }
 }
 
+void Index::get_suggestion_phrases(const nlohmann::json& document, const field& search_field,
+                                   std::vector<std::string>& phrases) {
+    std::vector<std::string> values;
+
+    if(search_field.type == field_types::STRING) {
+        values.push_back(document[search_field.name].get<std::string>());
+    } else if(search_field.type == field_types::STRING_ARRAY) {
+        values = document[search_field.name].get<std::vector<std::string>>();
+    }
+
+    std::unique_ptr<Tokenizer> tokenizer;
+
+    for(const std::string& value: values) {
+        if(tokenizer == nullptr) {
+            tokenizer.reset(new Tokenizer(value, true, false, search_field.locale));
+        } else {
+            tokenizer->reset(value);
+        }
+
+        std::vector<std::string> tokens;
+        tokenizer->tokenize(tokens);
+
+        std::string phrase;
+        for(const std::string& token: tokens) {
+            if(token.empty()) {
+                continue;
+            }
+
+            if(!phrase.empty()) {
+                phrase += ' ';
+            }
+
+            phrase += token;
+        }
+
+        if(!phrase.empty()) {
+            phrases.push_back(std::move(phrase));
+        }
+    }
+}
+
+void Index::suggest(const std::string& field_name, const std::string& query, size_t num_typos, size_t limit,
+                    std::vector<suggestion_t>& suggestions) const {
+    std::shared_lock lock(mutex);
+
+    auto suggestion_index_it = suggestion_index.find(field_name);
+    if(suggestion_index_it == suggestion_index.end()) {
+        return ;
+    }
+
+    const field query_field(field_name, field_types::STRING, false, false, true, search_schema.at(field_name).locale);
+
+    std::vector<std::string> prefixes;
+    get_suggestion_phrases(nlohmann::json{{field_name, query}}, query_field, prefixes);
+
+    // a trailing space means that the last word is complete
+    std::string prefix = prefixes.empty() ? "" : prefixes[0];
+    if(!prefix.empty() && !query.empty() && query.back() == ' ') {
+        prefix += ' ';
+    }
+
+    suggestion_index_it->second->suggest(prefix, num_typos, limit, suggestions);
+}
+
 art_leaf* Index::get_token_leaf(const std::string & field_name, const unsigned char* token, uint32_t token_len) {
     std::shared_lock lock(mutex);
     const art_tree *t = search_index.at(field_name);
     return (art_leaf*) art_search(t, token, (int) token_len);
 }
 
+void Index::get_token_leaves(const std::string & field_name, const std::vector<const unsigned char*>& tokens,
+                             const std::vector<int>& token_lens, std::vector<art_leaf*>& leaves) {
+    std::shared_lock lock(mutex);
+    const art_tree *t = search_index.at(field_name);
+    leaves.resize(tokens.size());
+    art_search_batch(t, tokens.data(), token_lens.data(), tokens.size(), leaves.data());
+}
+
 const spp::sparse_hash_map<std::string, art_tree *> &Index::_get_search_index() const {
     return search_index;
 }
@@ -3501,7 +4053,20 @@ void Index::refresh_schemas(const std::vector<field>& new_fields) {
             if(new_field.is_string() || field_types::is_string_or_array(new_field.type)) {
                 art_tree *t = new art_tree;
                 art_tree_init(t);
+                art_set_topk_cache_prefix_len(t, Config::get_instance().get_topk_cache_prefix_len());
                 search_index.emplace(new_field.name, t);
+
+                if(new_field.index && Config::get_instance().get_enable_forward_index()) {
+                    forward_index.emplace(new_field.name, new spp::sparse_hash_map<uint32_t, std::string>());
+                }
+
+                if(new_field.suggest) {
+                    suggestion_index.emplace(new_field.name, new suggestion_index_t());
+                }
+
+                if(new_field.infix) {
+                    infix_index.emplace(new_field.name, new infix_index_t());
+                }
             } else if(new_field.is_geopoint()) {
                 auto field_geo_index = new spp::sparse_hash_map<std::string, std::vector<uint32_t>>();
                 geopoint_index.emplace(new_field.name, field_geo_index);
@@ -3529,6 +4094,7 @@ void Index::refresh_schemas(const std::vector<field>& new_fields) {
             if(!new_field.is_string()) {
                 art_tree *ft = new art_tree;
                 art_tree_init(ft);
+                art_set_topk_cache_prefix_len(ft, Config::get_instance().get_topk_cache_prefix_len());
                 search_index.emplace(new_field.faceted_name(), ft);
             }
         }
@@ -3985,6 +4551,71 @@ size_t Index::num_seq_ids() const {
     return seq_ids.getLength();
 }
 
+size_t Index::get_search_index_bytes(const std::string& field_name) const {
+    std::shared_lock lock(mutex);
+    auto it = search_index.find(field_name);
+    return (it == search_index.end()) ? 0 : art_bytes_in_use(it->second);
+}
+
+void Index::remove_skipped_position_bytes(const std::string& field_name, const uint32_t seq_id) {
+    std::unique_lock lock(skipped_position_bytes_mutex);
+    auto field_doc_bytes_it = doc_skipped_position_bytes.find(field_name);
+    if(field_doc_bytes_it == doc_skipped_position_bytes.end()) {
+        return ;
+    }
+
+    auto doc_bytes_it = field_doc_bytes_it->second.find(seq_id);
+    if(doc_bytes_it == field_doc_bytes_it->second.end()) {
+        return ;
+    }
+
+    skipped_position_bytes[field_name] -= doc_bytes_it->second;
+    field_doc_bytes_it->second.erase(doc_bytes_it);
+}
+
+size_t Index::get_skipped_position_bytes(const std::string& field_name) const {
+    std::unique_lock lock(skipped_position_bytes_mutex);
+    auto it = skipped_position_bytes.find(field_name);
+    return (it == skipped_position_bytes.end()) ? 0 : it->second;
+}
+
+void Index::strip_token_positions(const bool is_array, const std::vector<uint32_t>& offsets,
+                                  std::vector<uint32_t>& stripped_offsets) {
+    stripped_offsets.clear();
+
+    if(!is_array) {
+        // a posting list needs atleast one offset per document: `0` is never a valid token position
+        stripped_offsets.push_back(0);
+        return ;
+    }
+
+    // array offsets are laid out as: [pos1, pos2, ..., last_pos, last_pos, array_index, (0 if last token)]
+    // every element that contains the token is kept as [1, 1, array_index]
+    int prev_pos = -1;
+
+    for(size_t i = 0; i < offsets.size(); i++) {
+        int pos = offsets[i];
+
+        if(pos == prev_pos) {
+            const uint32_t array_index = offsets[i + 1];
+            stripped_offsets.push_back(1);
+            stripped_offsets.push_back(1);
+            stripped_offsets.push_back(array_index);
+            i++;
+
+            if(i + 1 < offsets.size() && offsets[i + 1] == 0) {
+                // last token flag
+                i++;
+            }
+
+            prev_pos = -1;
+            continue;
+        }
+
+        prev_pos = pos;
+    }
+}
+
 /*
 // https://stackoverflow.com/questions/924171/geo-fencing-point-inside-outside-polygon
 // NOTE: polygon and point should have been transformed with `transform_for_180th_meridian`
@@ -0,0 +1,134 @@
+#include "infix_index.h"
+#include <algorithm>
+#include "posting.h"
+
+infix_index_t::infix_index_t(size_t ngram_len, size_t max_token_len):
+        ngram_len(ngram_len), max_token_len(max_token_len) {
+
+}
+
+infix_index_t::~infix_index_t() {
+    for(auto& kv: ngram_index) {
+        posting_t::destroy_list(kv.second);
+    }
+
+    ngram_index.clear();
+}
+
+void infix_index_t::get_ngrams(const std::string& token, std::map<std::string, std::vector<uint32_t>>& ngrams) const {
+    for(size_t i = 0; i + ngram_len <= token.size(); i++) {
+        ngrams[token.substr(i, ngram_len)].push_back(i);
+    }
+}
+
+void infix_index_t::add(const std::string& token) {
+    if(token.size() < ngram_len || token.size() > max_token_len || token_ids.count(token) != 0) {
+        return ;
+    }
+
+    uint32_t token_id;
+
+    if(free_token_ids.empty()) {
+        token_id = tokens.size();
+        tokens.push_back(token);
+    } else {
+        token_id = free_token_ids.back();
+        free_token_ids.pop_back();
+        tokens[token_id] = token;
+    }
+
+    token_ids.emplace(token, token_id);
+
+    std::map<std::string, std::vector<uint32_t>> ngrams;
+    get_ngrams(token, ngrams);
+
+    for(const auto& ngram_positions: ngrams) {
+        const std::vector<uint32_t>& positions = ngram_positions.second;
+        auto ngram_it = ngram_index.find(ngram_positions.first);
+
+        if(ngram_it != ngram_index.end()) {
+            posting_t::upsert(ngram_it->second, token_id, positions);
+            continue;
+        }
+
+        uint32_t ids[1] = {token_id};
+        uint32_t offset_index[1] = {0};
+        compact_posting_list_t* list = compact_posting_list_t::create(1, ids, offset_index, positions.size(),
+                                                                      &positions[0]);
+        ngram_index.emplace(ngram_positions.first, SET_COMPACT_POSTING(list));
+    }
+}
+
+void infix_index_t::remove(const std::string& token) {
+    auto token_it = token_ids.find(token);
+    if(token_it == token_ids.end()) {
+        return ;
+    }
+
+    const uint32_t token_id = token_it->second;
+
+    std::map<std::string, std::vector<uint32_t>> ngrams;
+    get_ngrams(token, ngrams);
+
+    for(const auto& ngram_positions: ngrams) {
+        auto ngram_it = ngram_index.find(ngram_positions.first);
+        if(ngram_it == ngram_index.end()) {
+            continue;
+        }
+
+        posting_t::erase(ngram_it->second, token_id);
+
+        if(posting_t::num_ids(ngram_it->second) == 0) {
+            posting_t::destroy_list(ngram_it->second);
+            ngram_index.erase(ngram_it);
+        }
+    }
+
+    token_ids.erase(token_it);
+    tokens[token_id].clear();
+    free_token_ids.push_back(token_id);
+}
+
+void infix_index_t::search(const std::string& infix, std::vector<std::string>& matched_tokens) const {
+    if(infix.size() < ngram_len || infix.size() > max_token_len) {
+        return ;
+    }
+
+    std::map<std::string, std::vector<uint32_t>> ngrams;
+    get_ngrams(infix, ngrams);
+
+    std::vector<void*> posting_lists;
+
+    for(const auto& ngram_positions: ngrams) {
+        auto ngram_it = ngram_index.find(ngram_positions.first);
+        if(ngram_it == ngram_index.end()) {
+            return ;
+        }
+
+        posting_lists.push_back(ngram_it->second);
+    }
+
+    // shortest lists first
+    std::sort(posting_lists.begin(), posting_lists.end(), [](const void* a, const void* b) {
+        return posting_t::num_ids(a) < posting_t::num_ids(b);
+    });
+
+    std::vector<uint32_t> candidate_ids;
+    posting_t::intersect(posting_lists, candidate_ids);
+
+    // tokens that have all the n-grams need not have them in the same order
+    for(uint32_t token_id: candidate_ids) {
+        const std::string& token = tokens[token_id];
+        if(token.find(infix) != std::string::npos) {
+            matched_tokens.push_back(token);
+        }
+    }
+}
+
+size_t infix_index_t::num_tokens() const {
+    return token_ids.size();
+}
+
+size_t infix_index_t::num_ngrams() const {
+    return ngram_index.size();
+}
@@ -1,175 +1,422 @@
 #include "num_tree.h"
 #include "parasort.h"
 
-void num_tree_t::insert(int64_t value, uint32_t id) {
-    if (int64map.count(value) == 0) {
-        int64map.emplace(value, new sorted_array);
+num_tree_t::~num_tree_t() {
+    for(auto leaf: leaves) {
+        for(auto ids: leaf->ids) {
+            destroy_ids(ids);
+        }
+
+        delete leaf;
     }
 
-    if (!int64map[value]->contains(id)) {
-        int64map[value]->append(id);
+    for(auto zone: zones) {
+        delete zone;
     }
 }
 
-void num_tree_t::range_inclusive_search(int64_t start, int64_t end, uint32_t** ids, size_t& ids_len) {
-    if(int64map.empty()) {
+uint32_t num_tree_t::num_ids(const void* ids) {
+    if(is_single_id(ids)) {
+        return 1;
+    }
+
+    return ((const sorted_array*) ids)->getLength();
+}
+
+void num_tree_t::copy_ids(const void* ids, uint32_t* out) {
+    if(is_single_id(ids)) {
+        out[0] = get_single_id(ids);
         return ;
     }
 
-    auto it_start = int64map.lower_bound(start);  // iter values will be >= start
+    const sorted_array* arr = (const sorted_array*) ids;
+    uint32_t* values = arr->uncompress();
+    memcpy(out, values, arr->getLength() * sizeof(uint32_t));
+    delete [] values;
+}
+
+void num_tree_t::destroy_ids(void* ids) {
+    if(!is_single_id(ids)) {
+        delete (sorted_array*) ids;
+    }
+}
+
+std::pair<size_t, size_t> num_tree_t::lower_bound(int64_t value) const {
+    auto leaf_it = std::lower_bound(leaf_last_values.begin(), leaf_last_values.end(), value);
+    size_t leaf_index = leaf_it - leaf_last_values.begin();
+
+    if(leaf_index == leaves.size()) {
+        return {leaf_index, 0};
+    }
+
+    const auto& values = leaves[leaf_index]->values;
+    size_t value_index = std::lower_bound(values.begin(), values.end(), value) - values.begin();
+    return {leaf_index, value_index};
+}
+
+void num_tree_t::collect(std::pair<size_t, size_t> pos, int64_t end, std::vector<const void*>& id_lists) const {
+    size_t leaf_index = pos.first;
+    size_t value_index = pos.second;
 
-    std::vector<uint32_t> consolidated_ids;
-    while(it_start != int64map.end() && it_start->first <= end) {
-        uint32_t* values = it_start->second->uncompress();
+    while(leaf_index < leaves.size()) {
+        const leaf_t* leaf = leaves[leaf_index];
 
-        for(size_t i = 0; i < it_start->second->getLength(); i++) {
-            consolidated_ids.push_back(values[i]);
+        if(leaf_last_values[leaf_index] <= end) {
+            // whole (remaining) leaf is in range: no need to compare values
+            id_lists.insert(id_lists.end(), leaf->ids.begin() + value_index, leaf->ids.end());
+        } else {
+            while(value_index < leaf->values.size() && leaf->values[value_index] <= end) {
+                id_lists.push_back(leaf->ids[value_index]);
+                value_index++;
+            }
+
+            return ;
         }
 
-        delete [] values;
-        it_start++;
+        leaf_index++;
+        value_index = 0;
+    }
+}
+
+void num_tree_t::merge_ids(const std::vector<const void*>& id_lists, uint32_t** ids, size_t& ids_len) {
+    if(id_lists.empty()) {
+        if(*ids == nullptr) {
+            ids_len = 0;
+        }
+        return ;
     }
 
-    if(consolidated_ids.size() > 50000) {
-        parasort(consolidated_ids.size(), &consolidated_ids[0], 4);
+    size_t total_ids = 0;
+    size_t max_list_ids = 0;
+    uint32_t min_id = std::numeric_limits<uint32_t>::max();
+    uint32_t max_id = 0;
+
+    for(const void* id_list: id_lists) {
+        if(is_single_id(id_list)) {
+            uint32_t id = get_single_id(id_list);
+            min_id = std::min(min_id, id);
+            max_id = std::max(max_id, id);
+            total_ids++;
+            max_list_ids = std::max<size_t>(max_list_ids, 1);
+        } else {
+            const sorted_array* arr = (const sorted_array*) id_list;
+            min_id = std::min(min_id, arr->getMin());
+            max_id = std::max(max_id, arr->getMax());
+            total_ids += arr->getLength();
+            max_list_ids = std::max<size_t>(max_list_ids, arr->getLength());
+        }
+    }
+
+    uint32_t* merged_ids = nullptr;
+    size_t merged_ids_len = 0;
+
+    if(id_lists.size() == 1) {
+        // IDs of a single value are already sorted and unique
+        merged_ids = new uint32_t[total_ids];
+        copy_ids(id_lists[0], merged_ids);
+        merged_ids_len = total_ids;
+    } else if((size_t(max_id - min_id) >> 5) <= total_ids) {
+        // IDs are dense enough that a bitmap over [min_id, max_id] is smaller than the IDs themselves:
+        // setting bits and scanning them produces sorted and unique output without sorting
+        std::vector<uint64_t> bitmap((size_t(max_id - min_id) >> 6) + 1, 0);
+        std::vector<uint32_t> list_ids(max_list_ids);
+
+        for(const void* id_list: id_lists) {
+            size_t list_len = num_ids(id_list);
+            copy_ids(id_list, &list_ids[0]);
+            for(size_t i = 0; i < list_len; i++) {
+                uint32_t bit = list_ids[i] - min_id;
+                bitmap[bit >> 6] |= (uint64_t(1) << (bit & 63));
+            }
+        }
+
+        merged_ids = new uint32_t[total_ids];
+        for(size_t word_index = 0; word_index < bitmap.size(); word_index++) {
+            uint64_t word = bitmap[word_index];
+            while(word != 0) {
+                uint32_t bit = __builtin_ctzll(word);
+                merged_ids[merged_ids_len++] = min_id + (word_index << 6) + bit;
+                word &= (word - 1);
+            }
+        }
     } else {
-        std::sort(consolidated_ids.begin(), consolidated_ids.end());
+        // sparse IDs: sorting the concatenated lists is cheaper than a wide bitmap
+        std::vector<uint32_t> consolidated_ids(total_ids);
+        size_t consolidated_index = 0;
+        for(const void* id_list: id_lists) {
+            copy_ids(id_list, &consolidated_ids[consolidated_index]);
+            consolidated_index += num_ids(id_list);
+        }
+
+        if(consolidated_ids.size() > 50000) {
+            parasort(consolidated_ids.size(), &consolidated_ids[0], 4);
+        } else {
+            std::sort(consolidated_ids.begin(), consolidated_ids.end());
+        }
+
+        merged_ids = new uint32_t[total_ids];
+        merged_ids_len = std::unique(consolidated_ids.begin(), consolidated_ids.end()) - consolidated_ids.begin();
+        memcpy(merged_ids, &consolidated_ids[0], merged_ids_len * sizeof(uint32_t));
+    }
+
+    if(*ids == nullptr) {
+        *ids = merged_ids;
+        ids_len = merged_ids_len;
+        return ;
     }
 
     uint32_t *out = nullptr;
-    ids_len = ArrayUtils::or_scalar(&consolidated_ids[0], consolidated_ids.size(),
-                                    *ids, ids_len, &out);
+    ids_len = ArrayUtils::or_scalar(merged_ids, merged_ids_len, *ids, ids_len, &out);
 
+    delete [] merged_ids;
     delete [] *ids;
     *ids = out;
 }
 
-size_t num_tree_t::get(int64_t value, std::vector<uint32_t>& geo_result_ids) {
-    const auto& it = int64map.find(value);
-    if(it == int64map.end()) {
-        return 0;
+void num_tree_t::update_zone(int64_t value, uint32_t id) {
+    size_t zone_index = (id >> ZONE_BLOCK_BITS);
+    if(zone_index >= zones.size()) {
+        zones.resize(zone_index + 1, nullptr);
     }
 
-    uint32_t* ids = it->second->uncompress();
-    for(size_t i = 0; i < it->second->getLength(); i++) {
-        geo_result_ids.push_back(ids[i]);
+    if(zones[zone_index] == nullptr) {
+        zones[zone_index] = new zone_t;
     }
 
-    delete [] ids;
+    zone_t* zone = zones[zone_index];
+    zone->min = std::min(zone->min, value);
+    zone->max = std::max(zone->max, value);
 
-    return it->second->getLength();
+    uint32_t bit = (id & (ZONE_BLOCK_SIZE - 1));
+    zone->id_bits[bit >> 6] |= (uint64_t(1) << (bit & 63));
 }
 
-void num_tree_t::search(NUM_COMPARATOR comparator, int64_t value, uint32_t** ids, size_t& ids_len) {
-    if(int64map.empty()) {
-        return ;
-    }
+void num_tree_t::zone_range_search(int64_t start, int64_t end, uint32_t** ids, size_t& ids_len) const {
+    std::vector<uint32_t> zone_ids;
+    std::vector<std::pair<int64_t, int64_t>> windows;
 
-    if(comparator == EQUALS) {
-        const auto& it = int64map.find(value);
-        if(it != int64map.end()) {
-            uint32_t *out = nullptr;
-            uint32_t* val_ids = it->second->uncompress();
-            ids_len = ArrayUtils::or_scalar(val_ids, it->second->getLength(),
-                                            *ids, ids_len, &out);
-            delete[] *ids;
-            *ids = out;
-            delete[] val_ids;
+    for(size_t zone_index = 0; zone_index < zones.size(); zone_index++) {
+        const zone_t* zone = zones[zone_index];
+        if(zone == nullptr || zone->max < start || zone->min > end) {
+            continue;
         }
-    } else if(comparator == GREATER_THAN || comparator == GREATER_THAN_EQUALS) {
-        // iter entries will be >= value, or end() if all entries are before value
-        auto iter_ge_value = int64map.lower_bound(value);
 
-        if(iter_ge_value == int64map.end()) {
-            return ;
-        }
+        if(!zone->has_removals && zone->min >= start && zone->max <= end) {
+            // every ID in the block matches
+            uint32_t base_id = zone_index << ZONE_BLOCK_BITS;
+            for(size_t word_index = 0; word_index < ZONE_BLOCK_SIZE / 64; word_index++) {
+                uint64_t word = zone->id_bits[word_index];
+                while(word != 0) {
+                    zone_ids.push_back(base_id + (word_index << 6) + __builtin_ctzll(word));
+                    word &= (word - 1);
+                }
+            }
 
-        if(comparator == GREATER_THAN && iter_ge_value->first == value) {
-            iter_ge_value++;
+            continue;
         }
 
-        std::vector<uint32_t> consolidated_ids;
-        while(iter_ge_value != int64map.end()) {
-            uint32_t* values = iter_ge_value->second->uncompress();
+        // boundary block: only values within its min/max window have to be examined
+        windows.emplace_back(std::max(start, zone->min), std::min(end, zone->max));
+    }
 
-            for(size_t i = 0; i < iter_ge_value->second->getLength(); i++) {
-                consolidated_ids.push_back(values[i]);
+    std::vector<const void*> id_lists;
+
+    if(!windows.empty()) {
+        std::sort(windows.begin(), windows.end());
+
+        std::pair<int64_t, int64_t> window = windows[0];
+        for(size_t i = 1; i <= windows.size(); i++) {
+            if(i < windows.size() && windows[i].first <= window.second) {
+                window.second = std::max(window.second, windows[i].second);
+                continue;
             }
 
-            delete [] values;
-            iter_ge_value++;
-        }
+            collect(lower_bound(window.first), window.second, id_lists);
 
-        if(consolidated_ids.size() > 50000) {
-            parasort(consolidated_ids.size(), &consolidated_ids[0], 4);
-        } else {
-            std::sort(consolidated_ids.begin(), consolidated_ids.end());
+            if(i < windows.size()) {
+                window = windows[i];
+            }
         }
+    }
 
-        consolidated_ids.erase(unique(consolidated_ids.begin(), consolidated_ids.end()), consolidated_ids.end());
+    merge_ids(id_lists, ids, ids_len);
 
+    if(!zone_ids.empty()) {
         uint32_t *out = nullptr;
-        ids_len = ArrayUtils::or_scalar(&consolidated_ids[0], consolidated_ids.size(),
-                                        *ids, ids_len, &out);
-
+        ids_len = ArrayUtils::or_scalar(&zone_ids[0], zone_ids.size(), *ids, ids_len, &out);
         delete [] *ids;
         *ids = out;
+    }
+}
 
-    } else if(comparator == LESS_THAN || comparator == LESS_THAN_EQUALS) {
-        // iter entries will be >= value, or end() if all entries are before value
-        auto iter_ge_value = int64map.lower_bound(value);
+void num_tree_t::split_leaf(size_t leaf_index) {
+    leaf_t* leaf = leaves[leaf_index];
+    leaf_t* new_leaf = new leaf_t;
 
-        std::vector<uint32_t> consolidated_ids;
-        auto it = int64map.begin();
+    size_t split_index = leaf->values.size() / 2;
 
-        while(it != iter_ge_value) {
-            uint32_t* values = it->second->uncompress();
+    new_leaf->values.assign(leaf->values.begin() + split_index, leaf->values.end());
+    new_leaf->ids.assign(leaf->ids.begin() + split_index, leaf->ids.end());
+    leaf->values.resize(split_index);
+    leaf->ids.resize(split_index);
 
-            for(size_t i = 0; i < it->second->getLength(); i++) {
-                consolidated_ids.push_back(values[i]);
-            }
+    leaf_last_values[leaf_index] = leaf->values.back();
+    leaves.insert(leaves.begin() + leaf_index + 1, new_leaf);
+    leaf_last_values.insert(leaf_last_values.begin() + leaf_index + 1, new_leaf->values.back());
+}
 
-            delete [] values;
-            it++;
-        }
+void num_tree_t::erase_value(size_t leaf_index, size_t value_index) {
+    leaf_t* leaf = leaves[leaf_index];
+
+    destroy_ids(leaf->ids[value_index]);
+    leaf->values.erase(leaf->values.begin() + value_index);
+    leaf->ids.erase(leaf->ids.begin() + value_index);
+    num_values--;
+
+    if(leaf->values.empty()) {
+        delete leaf;
+        leaves.erase(leaves.begin() + leaf_index);
+        leaf_last_values.erase(leaf_last_values.begin() + leaf_index);
+    } else {
+        leaf_last_values[leaf_index] = leaf->values.back();
+    }
+}
+
+void num_tree_t::insert(int64_t value, uint32_t id) {
+    update_zone(value, id);
+
+    if(leaves.empty()) {
+        leaves.push_back(new leaf_t);
+        leaf_last_values.push_back(value);
+    }
+
+    auto pos = lower_bound(value);
+    size_t leaf_index = pos.first;
+    size_t value_index = pos.second;
+
+    if(leaf_index == leaves.size()) {
+        // value is larger than all existing values: append to the last leaf
+        leaf_index = leaves.size() - 1;
+        value_index = leaves[leaf_index]->values.size();
+    }
+
+    leaf_t* leaf = leaves[leaf_index];
+
+    if(value_index < leaf->values.size() && leaf->values[value_index] == value) {
+        void*& ids = leaf->ids[value_index];
 
-        // for LESS_THAN_EQUALS, check if last iter entry is equal to value
-        if(it != int64map.end() && comparator == LESS_THAN_EQUALS && it->first == value) {
-            uint32_t* values = it->second->uncompress();
-            for(size_t i = 0; i < it->second->getLength(); i++) {
-                consolidated_ids.push_back(values[i]);
+        if(is_single_id(ids)) {
+            uint32_t existing_id = get_single_id(ids);
+            if(existing_id == id) {
+                return ;
             }
-            delete [] values;
-        }
 
-        if(consolidated_ids.size() > 50000) {
-            parasort(consolidated_ids.size(), &consolidated_ids[0], 4);
+            sorted_array* arr = new sorted_array;
+            arr->append(existing_id);
+            arr->append(id);
+            ids = arr;
         } else {
-            std::sort(consolidated_ids.begin(), consolidated_ids.end());
+            sorted_array* arr = (sorted_array*) ids;
+            if(!arr->contains(id)) {
+                arr->append(id);
+            }
         }
 
-        consolidated_ids.erase(unique(consolidated_ids.begin(), consolidated_ids.end()), consolidated_ids.end());
+        return ;
+    }
 
-        uint32_t *out = nullptr;
-        ids_len = ArrayUtils::or_scalar(&consolidated_ids[0], consolidated_ids.size(),
-                                        *ids, ids_len, &out);
+    leaf->values.insert(leaf->values.begin() + value_index, value);
+    leaf->ids.insert(leaf->ids.begin() + value_index, to_single_id(id));
+    leaf_last_values[leaf_index] = leaf->values.back();
+    num_values++;
 
-        delete [] *ids;
-        *ids = out;
+    if(leaf->values.size() > LEAF_MAX_VALUES) {
+        split_leaf(leaf_index);
+    }
+}
+
+void num_tree_t::range_inclusive_search(int64_t start, int64_t end, uint32_t** ids, size_t& ids_len) {
+    if(leaves.empty()) {
+        return ;
+    }
+
+    zone_range_search(start, end, ids, ids_len);
+}
+
+size_t num_tree_t::get(int64_t value, std::vector<uint32_t>& geo_result_ids) {
+    auto pos = lower_bound(value);
+    if(pos.first == leaves.size() || leaves[pos.first]->values[pos.second] != value) {
+        return 0;
+    }
+
+    const void* ids = leaves[pos.first]->ids[pos.second];
+    size_t ids_len = num_ids(ids);
+
+    size_t existing_len = geo_result_ids.size();
+    geo_result_ids.resize(existing_len + ids_len);
+    copy_ids(ids, &geo_result_ids[existing_len]);
+
+    return ids_len;
+}
+
+void num_tree_t::search(NUM_COMPARATOR comparator, int64_t value, uint32_t** ids, size_t& ids_len) {
+    if(leaves.empty()) {
+        return ;
+    }
+
+    if(comparator == EQUALS) {
+        std::vector<const void*> id_lists;
+        collect(lower_bound(value), value, id_lists);
+        merge_ids(id_lists, ids, ids_len);
+    } else if(comparator == GREATER_THAN || comparator == GREATER_THAN_EQUALS) {
+        if(comparator == GREATER_THAN && value == std::numeric_limits<int64_t>::max()) {
+            return ;
+        }
+
+        int64_t start = (comparator == GREATER_THAN) ? value + 1 : value;
+        zone_range_search(start, std::numeric_limits<int64_t>::max(), ids, ids_len);
+    } else if(comparator == LESS_THAN || comparator == LESS_THAN_EQUALS) {
+        if(comparator == LESS_THAN && value == std::numeric_limits<int64_t>::min()) {
+            return ;
+        }
+
+        int64_t end = (comparator == LESS_THAN) ? value - 1 : value;
+        zone_range_search(std::numeric_limits<int64_t>::min(), end, ids, ids_len);
     }
 }
 
 void num_tree_t::remove(uint64_t value, uint32_t id) {
-    if(int64map.count(value) != 0) {
-        sorted_array* arr = int64map[value];
-        arr->remove_value(id);
-        if(arr->getLength() == 0) {
-            delete arr;
-            int64map.erase(value);
+    auto pos = lower_bound(int64_t(value));
+    if(pos.first == leaves.size() || leaves[pos.first]->values[pos.second] != int64_t(value)) {
+        return ;
+    }
+
+    size_t zone_index = (id >> ZONE_BLOCK_BITS);
+    if(zone_index < zones.size() && zones[zone_index] != nullptr) {
+        zones[zone_index]->has_removals = true;
+    }
+
+    void*& ids = leaves[pos.first]->ids[pos.second];
+
+    if(is_single_id(ids)) {
+        if(get_single_id(ids) == id) {
+            erase_value(pos.first, pos.second);
         }
+
+        return ;
+    }
+
+    sorted_array* arr = (sorted_array*) ids;
+    arr->remove_value(id);
+
+    if(arr->getLength() == 0) {
+        erase_value(pos.first, pos.second);
+    } else if(arr->getLength() == 1) {
+        ids = to_single_id(arr->at(0));
+        delete arr;
     }
 }
 
 size_t num_tree_t::size() {
-    return int64map.size();
-}
\ No newline at end of file
+    return num_values;
+}
@@ -286,6 +286,52 @@ void posting_t::upsert(void*& obj, uint32_t id, const std::vector<uint32_t>& off
     // either `obj` is already a full list or was converted to a full list above
     posting_list_t* list = (posting_list_t*)(obj);
     list->upsert(id, offsets);
+
+    if(!list->is_dense() && list->num_ids() >= DENSE_LIST_THRESHOLD_LENGTH &&
+       list->last_id() / list->num_ids() < DENSE_LIST_MAX_SPREAD) {
+        list->build_ids_bitmap();
+    }
+}
+
+void posting_t::append_sorted(void*& obj, const uint32_t* ids, const uint32_t* offset_index, size_t num_ids,
+                              const uint32_t* offsets, size_t num_offsets) {
+    if(IS_COMPACT_POSTING(obj)) {
+        compact_posting_list_t* list = COMPACT_POSTING_PTR(obj);
+        const size_t new_length = list->length + num_offsets + (2 * num_ids);
+
+        if(new_length <= COMPACT_LIST_THRESHOLD_LENGTH) {
+            if(new_length > list->capacity) {
+                size_t new_capacity_bytes = sizeof(compact_posting_list_t) + (new_length * sizeof(uint32_t));
+                auto new_list = (compact_posting_list_t *) realloc(list, new_capacity_bytes);
+                if(new_list == nullptr) {
+                    abort();
+                }
+
+                list = new_list;
+                list->capacity = new_length;
+                obj = SET_COMPACT_POSTING(list);
+            }
+
+            for(size_t i = 0; i < num_ids; i++) {
+                const uint32_t next_offset_index = (i == num_ids - 1) ? num_offsets : offset_index[i + 1];
+                list->upsert(ids[i], offsets + offset_index[i], next_offset_index - offset_index[i]);
+            }
+
+            return ;
+        }
+
+        posting_list_t* full_list = list->to_full_posting_list();
+        free(list);
+        obj = full_list;
+    }
+
+    posting_list_t* list = (posting_list_t*)(obj);
+    list->append_sorted(ids, offset_index, num_ids, offsets, num_offsets);
+
+    if(!list->is_dense() && list->num_ids() >= DENSE_LIST_THRESHOLD_LENGTH &&
+       list->last_id() / list->num_ids() < DENSE_LIST_MAX_SPREAD) {
+        list->build_ids_bitmap();
+    }
 }
 
 void posting_t::erase(void*& obj, uint32_t id) {
@@ -312,6 +358,10 @@ void posting_t::erase(void*& obj, uint32_t id) {
         posting_list_t* list = (posting_list_t*)(obj);
         list->erase(id);
 
+        if(list->is_dense() && list->num_ids() < DENSE_LIST_THRESHOLD_LENGTH/2) {
+            list->clear_ids_bitmap();
+        }
+
         if(list->num_blocks() == 1 && ((2 * list->get_root()->size()) + list->get_root()->offsets.getLength()) <= COMPACT_LIST_THRESHOLD_LENGTH) {
             // convert to compact posting format
             auto root_block = list->get_root();
@@ -353,6 +403,16 @@ uint32_t posting_t::first_id(const void* obj) {
     }
 }
 
+uint32_t posting_t::last_id(const void* obj) {
+    if(IS_COMPACT_POSTING(obj)) {
+        compact_posting_list_t* list = COMPACT_POSTING_PTR(obj);
+        return list->last_id();
+    } else {
+        posting_list_t* list = (posting_list_t*)(obj);
+        return list->last_id();
+    }
+}
+
 bool posting_t::contains(const void* obj, uint32_t id) {
     if(IS_COMPACT_POSTING(obj)) {
         compact_posting_list_t* list = COMPACT_POSTING_PTR(obj);
@@ -499,6 +559,7 @@ void posting_t::block_intersector_t::split_lists(size_t concurrency,
     const size_t window_size = (num_blocks + concurrency - 1) / concurrency;  // rounds up
 
     size_t blocks_traversed = 0;
+    size_t start_block_index = 0;
     posting_list_t::block_t* start_block = this->plists[0]->get_root();
     posting_list_t::block_t* curr_block = start_block;
 
@@ -512,33 +573,30 @@ void posting_t::block_intersector_t::split_lists(size_t concurrency,
             std::vector<posting_list_t::iterator_t>& partial_its = partial_its_vec[window_index];
 
             for(size_t i = 0; i < this->plists.size(); i++) {
-                posting_list_t::block_t* p_start_block = nullptr;
-                posting_list_t::block_t* p_end_block = nullptr;
+                size_t p_start_block_index, p_end_block_index;
 
                 // [1, 2] [3, 4] [5, 6]
                 // [3, 5] [6]
 
                 if(i == 0) {
-                    p_start_block = start_block;
-                    p_end_block = curr_block->next;
+                    p_start_block_index = start_block_index;
+                    p_end_block_index = blocks_traversed;
                 } else {
                     auto start_block_first_id = start_block->ids.at(0);
                     auto end_block_last_id = curr_block->ids.last();
 
-                    p_start_block = this->plists[i]->block_of(start_block_first_id);
-                    posting_list_t::block_t* last_block = this->plists[i]->block_of(end_block_last_id);
-
-                    if(p_start_block == last_block && p_start_block != nullptr) {
-                        p_end_block = p_start_block->next;
-                    } else {
-                        p_end_block = last_block == nullptr ? nullptr : last_block->next;
-                    }
+                    // an index of `num_blocks()` means that there is no such block
+                    const size_t p_num_blocks = this->plists[i]->num_blocks();
+                    p_start_block_index = this->plists[i]->block_index_of(start_block_first_id);
+                    p_end_block_index = std::min(this->plists[i]->block_index_of(end_block_last_id) + 1,
+                                                 p_num_blocks);
                 }
 
-                partial_its.emplace_back(p_start_block, p_end_block);
+                partial_its.push_back(this->plists[i]->new_iterator(p_start_block_index, p_end_block_index));
             }
 
             start_block = curr_block->next;
+            start_block_index = blocks_traversed;
             window_index++;
         }
 
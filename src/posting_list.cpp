@@ -415,30 +415,53 @@ void posting_list_t::split_block(posting_list_t::block_t* src_block, posting_lis
     delete [] raw_offsets;
 }
 
+size_t posting_list_t::lower_bound_block(const uint32_t id, const size_t begin, const size_t end) const {
+    if(begin >= end) {
+        return end;
+    }
+
+    // branch-free binary search: the comparison only decides how far `base` moves
+    const last_id_t* base = block_last_ids.data() + begin;
+    size_t len = end - begin;
+
+    while(len > 1) {
+        const size_t half = len / 2;
+        base += (base[half - 1] < id) * half;
+        len -= half;
+    }
+
+    return (base - block_last_ids.data()) + (*base < id);
+}
+
 void posting_list_t::upsert(const uint32_t id, const std::vector<uint32_t>& offsets) {
+    if(is_dense()) {
+        const size_t word = (id >> 6);
+        if(word >= ids_bitmap.size()) {
+            ids_bitmap.resize(word + 1, 0);
+        }
+
+        ids_bitmap[word] |= (uint64_t(1) << (id & 63));
+    }
+
     // first we will locate the block where `id` should reside
     block_t* upsert_block;
-    last_id_t before_upsert_last_id;
+    size_t upsert_block_index;
 
-    if(id_block_map.empty()) {
+    if(blocks.empty()) {
         upsert_block = &root_block;
-        before_upsert_last_id = UINT32_MAX;
+        upsert_block_index = 0;
+        blocks.push_back(&root_block);
+        block_last_ids.push_back(0);
     } else {
-        const auto it = id_block_map.lower_bound(id);
-        upsert_block = (it == id_block_map.end()) ? id_block_map.rbegin()->second : it->second;
-        before_upsert_last_id = upsert_block->ids.last();
+        upsert_block_index = std::min(lower_bound_block(id), blocks.size() - 1);
+        upsert_block = blocks[upsert_block_index];
     }
 
     // happy path: upsert_block is not full
     if(upsert_block->size() < BLOCK_MAX_ELEMENTS) {
         uint32_t num_inserted = upsert_block->upsert(id, offsets);
         ids_length += num_inserted;
-
-        last_id_t after_upsert_last_id = upsert_block->ids.last();
-        if(before_upsert_last_id != after_upsert_last_id) {
-            id_block_map.erase(before_upsert_last_id);
-            id_block_map.emplace(after_upsert_last_id, upsert_block);
-        }
+        block_last_ids[upsert_block_index] = upsert_block->ids.last();
     } else {
         block_t* new_block = new block_t;
 
@@ -453,29 +476,86 @@ void posting_list_t::upsert(const uint32_t id, const std::vector<uint32_t>& offs
 
             // evenly divide elements between both blocks
             split_block(upsert_block, new_block);
-
-            last_id_t after_upsert_last_id = upsert_block->ids.last();
-            id_block_map.erase(before_upsert_last_id);
-            id_block_map.emplace(after_upsert_last_id, upsert_block);
+            block_last_ids[upsert_block_index] = upsert_block->ids.last();
         }
 
-        last_id_t after_new_block_id = new_block->ids.last();
-        id_block_map.emplace(after_new_block_id, new_block);
+        block_last_ids.insert(block_last_ids.begin() + upsert_block_index + 1, new_block->ids.last());
+        blocks.insert(blocks.begin() + upsert_block_index + 1, new_block);
 
         new_block->next = upsert_block->next;
         upsert_block->next = new_block;
     }
 }
 
+void posting_list_t::append_sorted(const uint32_t* ids, const uint32_t* offset_index, size_t num_ids,
+                                   const uint32_t* offsets, size_t num_offsets) {
+    size_t i = 0;
+
+    // a partially filled last block is topped up one ID at a time
+    while(i < num_ids && !blocks.empty() && blocks.back()->size() < BLOCK_MAX_ELEMENTS) {
+        const uint32_t next_offset_index = (i == num_ids - 1) ? num_offsets : offset_index[i + 1];
+        upsert(ids[i], std::vector<uint32_t>(offsets + offset_index[i], offsets + next_offset_index));
+        i++;
+    }
+
+    std::vector<uint32_t> block_offset_index;
+
+    while(i < num_ids) {
+        const size_t block_num_ids = std::min<size_t>(BLOCK_MAX_ELEMENTS, num_ids - i);
+        const uint32_t offsets_begin = offset_index[i];
+        const uint32_t offsets_end = (i + block_num_ids == num_ids) ? num_offsets : offset_index[i + block_num_ids];
+
+        block_offset_index.resize(block_num_ids);
+        for(size_t j = 0; j < block_num_ids; j++) {
+            block_offset_index[j] = offset_index[i + j] - offsets_begin;
+        }
+
+        uint32_t m = UINT32_MAX, M = 0;
+        for(size_t j = offsets_begin; j < offsets_end; j++) {
+            m = std::min(m, offsets[j]);
+            M = std::max(M, offsets[j]);
+        }
+
+        block_t* block = blocks.empty() ? &root_block : new block_t;
+        block->ids.load(ids + i, block_num_ids);
+        block->offset_index.load(&block_offset_index[0], block_num_ids);
+        block->offsets.load(offsets + offsets_begin, offsets_end - offsets_begin, m, M);
+
+        if(!blocks.empty()) {
+            blocks.back()->next = block;
+        }
+
+        blocks.push_back(block);
+        block_last_ids.push_back(ids[i + block_num_ids - 1]);
+
+        if(is_dense()) {
+            for(size_t j = i; j < i + block_num_ids; j++) {
+                const size_t word = (ids[j] >> 6);
+                if(word >= ids_bitmap.size()) {
+                    ids_bitmap.resize(word + 1, 0);
+                }
+
+                ids_bitmap[word] |= (uint64_t(1) << (ids[j] & 63));
+            }
+        }
+
+        ids_length += block_num_ids;
+        i += block_num_ids;
+    }
+}
+
 void posting_list_t::erase(const uint32_t id) {
-    const auto it = id_block_map.lower_bound(id);
+    if(is_dense() && (id >> 6) < ids_bitmap.size()) {
+        ids_bitmap[id >> 6] &= ~(uint64_t(1) << (id & 63));
+    }
+
+    const size_t erase_block_index = lower_bound_block(id);
 
-    if(it == id_block_map.end()) {
+    if(erase_block_index == blocks.size()) {
         return ;
     }
 
-    block_t* erase_block = it->second;
-    last_id_t before_last_id = it->first;
+    block_t* erase_block = blocks[erase_block_index];
     uint32_t num_erased = erase_block->erase(id);
     ids_length -= num_erased;
 
@@ -485,41 +565,43 @@ void posting_list_t::erase(const uint32_t id) {
         // happens when the last element of last block is deleted
 
         if(erase_block != &root_block) {
-            // since we will be deleting the empty node, set the previous node's next pointer to null
-            std::prev(it)->second->next = nullptr;
+            // since we will be deleting the empty node, unlink it from the previous node
+            blocks[erase_block_index - 1]->next = erase_block->next;
             delete erase_block;
         } else {
             // The root block cannot be empty if there are other blocks so we will pull some contents from next block
             // This is only an issue for blocks with max size of 2
             if(root_block.next != nullptr) {
-                auto next_block_last_id = erase_block->next->ids.last();
-                merge_adjacent_blocks(erase_block, erase_block->next, erase_block->next->size()/2);
-                id_block_map.erase(next_block_last_id);
+                block_t* next_block = root_block.next;
+                size_t num_block2_ids = std::max<size_t>(1, next_block->size()/2);
+                merge_adjacent_blocks(erase_block, next_block, num_block2_ids);
+                block_last_ids[erase_block_index] = erase_block->ids.last();
+
+                if(next_block->size() == 0) {
+                    erase_block->next = next_block->next;
+                    delete next_block;
+                    block_last_ids.erase(block_last_ids.begin() + erase_block_index + 1);
+                    blocks.erase(blocks.begin() + erase_block_index + 1);
+                }
 
-                id_block_map.emplace(erase_block->next->ids.last(), erase_block->next);
-                id_block_map.emplace(erase_block->ids.last(), erase_block);
+                return ;
             }
         }
 
-        id_block_map.erase(before_last_id);
+        block_last_ids.erase(block_last_ids.begin() + erase_block_index);
+        blocks.erase(blocks.begin() + erase_block_index);
 
         return;
     }
 
     if(new_ids_length >= BLOCK_MAX_ELEMENTS/2 || erase_block->next == nullptr) {
-        last_id_t after_last_id = erase_block->ids.last();
-        if(before_last_id != after_last_id) {
-            id_block_map.erase(before_last_id);
-            id_block_map.emplace(after_last_id, erase_block);
-        }
-
+        block_last_ids[erase_block_index] = erase_block->ids.last();
         return ;
     }
 
     // block is less than 50% of max capacity and contains a next node which we can refill from
 
     auto next_block = erase_block->next;
-    last_id_t next_block_last_id = next_block->ids.last();
 
     if(erase_block->size() + next_block->size() <= BLOCK_MAX_ELEMENTS) {
         // we can merge the contents of next block with `erase_block` and delete the next block
@@ -527,21 +609,18 @@ void posting_list_t::erase(const uint32_t id) {
         erase_block->next = next_block->next;
         delete next_block;
 
-        id_block_map.erase(next_block_last_id);
+        block_last_ids.erase(block_last_ids.begin() + erase_block_index + 1);
+        blocks.erase(blocks.begin() + erase_block_index + 1);
     } else {
         // Only part of the next block can be moved over.
         // We will move only 50% of max elements to ensure that we don't end up "flipping" adjacent blocks:
         // 1, 5 -> 5, 1
         size_t num_block2_ids = BLOCK_MAX_ELEMENTS/2;
         merge_adjacent_blocks(erase_block, next_block, num_block2_ids);
-        // NOTE: we don't have to update `id_block_map` for `next_block` as last element doesn't change
+        // NOTE: we don't have to update the skip index for `next_block` as last element doesn't change
     }
 
-    last_id_t after_last_id = erase_block->ids.last();
-    if(before_last_id != after_last_id) {
-        id_block_map.erase(before_last_id);
-        id_block_map.emplace(after_last_id, erase_block);
-    }
+    block_last_ids[erase_block_index] = erase_block->ids.last();
 }
 
 posting_list_t::block_t* posting_list_t::get_root() {
@@ -549,7 +628,7 @@ posting_list_t::block_t* posting_list_t::get_root() {
 }
 
 size_t posting_list_t::num_blocks() const {
-    return id_block_map.size();
+    return blocks.size();
 }
 
 uint32_t posting_list_t::first_id() {
@@ -560,13 +639,34 @@ uint32_t posting_list_t::first_id() {
     return root_block.ids.at(0);
 }
 
+uint32_t posting_list_t::last_id() const {
+    if(block_last_ids.empty()) {
+        return 0;
+    }
+
+    return block_last_ids.back();
+}
+
+void posting_list_t::build_ids_bitmap() {
+    ids_bitmap.assign((last_id() >> 6) + 1, 0);
+
+    for(auto it = new_iterator(); it.valid(); it.next()) {
+        const uint32_t id = it.id();
+        ids_bitmap[id >> 6] |= (uint64_t(1) << (id & 63));
+    }
+}
+
+void posting_list_t::clear_ids_bitmap() {
+    std::vector<uint64_t>().swap(ids_bitmap);
+}
+
 posting_list_t::block_t* posting_list_t::block_of(uint32_t id) {
-    const auto it = id_block_map.lower_bound(id);
-    if(it == id_block_map.end()) {
+    const size_t block_index = lower_bound_block(id);
+    if(block_index == blocks.size()) {
         return nullptr;
     }
 
-    return it->second;
+    return blocks[block_index];
 }
 
 
@@ -652,6 +752,15 @@ void posting_list_t::intersect(const std::vector<posting_list_t*>& posting_lists
         its.push_back(posting_list->new_iterator());
     }
 
+    if(has_dense_and_sparse(its)) {
+        // only IDs are needed, so dense lists are never iterated
+        result_iter_state_t istate;
+        dense_block_intersect(its, istate, false, [&result_ids](uint32_t id, auto&, size_t) {
+            result_ids.push_back(id);
+        });
+        return ;
+    }
+
     size_t num_lists = its.size();
 
     switch (num_lists) {
@@ -679,6 +788,20 @@ void posting_list_t::intersect(const std::vector<posting_list_t*>& posting_lists
     }
 }
 
+bool posting_list_t::has_dense_and_sparse(const std::vector<posting_list_t::iterator_t>& its) {
+    bool has_dense = false, has_sparse = false;
+
+    for(const auto& it: its) {
+        if(it.posting_list()->is_dense()) {
+            has_dense = true;
+        } else {
+            has_sparse = true;
+        }
+    }
+
+    return has_dense && has_sparse;
+}
+
 bool posting_list_t::take_id(result_iter_state_t& istate, uint32_t id) {
     // decide if this result id should be excluded
     if(istate.excluded_result_ids_size != 0) {
@@ -725,12 +848,12 @@ bool posting_list_t::get_offsets(const std::vector<iterator_t>& its,
                               curr_block->offsets.getLength() :
                               curr_block->offset_index.at(curr_index + 1);*/
 
-        uint32_t* offsets = its[j].offsets;
+        const uint32_t* offsets = its[j].get_offsets();
 
-        uint32_t start_offset = its[j].offset_index[curr_index];
+        uint32_t start_offset = its[j].get_offset_index()[curr_index];
         uint32_t end_offset = (curr_index == curr_block->size() - 1) ?
                               curr_block->offsets.getLength() :
-                              its[j].offset_index[curr_index + 1];
+                              its[j].get_offset_index()[curr_index + 1];
 
         std::vector<uint16_t> positions;
         int prev_pos = -1;
@@ -790,6 +913,49 @@ bool posting_list_t::get_offsets(const std::vector<iterator_t>& its,
     return true;
 }
 
+void posting_list_t::get_offsets(const std::vector<iterator_t>& its, doc_token_positions_t& doc_token_positions) {
+    // Plain string format:
+    // offset1, offset2, ... , 0 (if token is the last offset for the document)
+
+    doc_token_positions.clear();
+
+    for(size_t j = 0; j < its.size(); j++) {
+        block_t* curr_block = its[j].block();
+        uint32_t curr_index = its[j].index();
+
+        if(curr_block == nullptr || curr_index == UINT32_MAX) {
+            continue;
+        }
+
+        const uint32_t* offsets = its[j].get_offsets();
+
+        uint32_t start_offset = its[j].get_offset_index()[curr_index];
+        uint32_t end_offset = (curr_index == curr_block->size() - 1) ?
+                              curr_block->offsets.getLength() :
+                              its[j].get_offset_index()[curr_index + 1];
+
+        bool is_last_token = false;
+
+        while(start_offset < end_offset) {
+            uint32_t pos = offsets[start_offset];
+            start_offset++;
+
+            if(pos == 0) {
+                // indicates that token is the last token on the doc
+                is_last_token = true;
+                start_offset++;
+                continue;
+            }
+
+            doc_token_positions.add_position((uint16_t)pos - 1);
+        }
+
+        doc_token_positions.end_token(is_last_token);
+    }
+
+    doc_token_positions.finalize();
+}
+
 bool posting_list_t::is_single_token_verbatim_match(const posting_list_t::iterator_t& it, bool field_is_array) {
     block_t* curr_block = it.block();
     uint32_t curr_index = it.index();
@@ -798,8 +964,8 @@ bool posting_list_t::is_single_token_verbatim_match(const posting_list_t::iterat
         return false;
     }
 
-    uint32_t* offsets = it.offsets;
-    uint32_t start_offset = it.offset_index[curr_index];
+    const uint32_t* offsets = it.get_offsets();
+    uint32_t start_offset = it.get_offset_index()[curr_index];
 
     if(!field_is_array && offsets[start_offset] != 1) {
         // allows us to skip other computes fast
@@ -808,7 +974,7 @@ bool posting_list_t::is_single_token_verbatim_match(const posting_list_t::iterat
 
     uint32_t end_offset = (curr_index == curr_block->size() - 1) ?
                           curr_block->offsets.getLength() :
-                          it.offset_index[curr_index + 1];
+                          it.get_offset_index()[curr_index + 1];
 
     if(field_is_array) {
        int prev_pos = -1;
@@ -864,8 +1030,18 @@ bool posting_list_t::equals2(std::vector<posting_list_t::iterator_t>& its) {
 }
 
 posting_list_t::iterator_t posting_list_t::new_iterator(block_t* start_block, block_t* end_block) {
-    start_block = (start_block == nullptr) ? &root_block : start_block;
-    return posting_list_t::iterator_t(start_block, end_block);
+    // last IDs are unique, so a block's own last ID locates it in the skip index
+    size_t start_block_index = (start_block == nullptr) ? 0 : lower_bound_block(start_block->ids.last());
+    size_t end_block_index = (end_block == nullptr) ? blocks.size() : lower_bound_block(end_block->ids.last());
+    return posting_list_t::iterator_t(this, start_block_index, end_block_index);
+}
+
+posting_list_t::iterator_t posting_list_t::new_iterator(size_t start_block_index, size_t end_block_index) {
+    return posting_list_t::iterator_t(this, start_block_index, end_block_index);
+}
+
+size_t posting_list_t::block_index_of(uint32_t id) const {
+    return lower_bound_block(id);
 }
 
 void posting_list_t::advance_all(std::vector<posting_list_t::iterator_t>& its) {
@@ -942,17 +1118,31 @@ size_t posting_list_t::num_ids() const {
 }
 
 bool posting_list_t::contains(uint32_t id) {
-    const auto it = id_block_map.lower_bound(id);
+    if(is_dense()) {
+        return bitmap_contains(id);
+    }
 
-    if(it == id_block_map.end()) {
+    const size_t block_index = lower_bound_block(id);
+
+    if(block_index == blocks.size()) {
         return false;
     }
 
-    block_t* potential_block = it->second;
+    block_t* potential_block = blocks[block_index];
     return potential_block->contains(id);
 }
 
 bool posting_list_t::contains_atleast_one(const uint32_t* target_ids, size_t target_ids_size) {
+    if(is_dense()) {
+        for(size_t i = 0; i < target_ids_size; i++) {
+            if(bitmap_contains(target_ids[i])) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     posting_list_t::iterator_t it = new_iterator();
     size_t target_ids_index = 0;
 
@@ -1009,12 +1199,12 @@ void posting_list_t::get_exact_matches(std::vector<iterator_t>& its, const bool
                         break;
                     }
 
-                    uint32_t* offsets = it.offsets;
+                    const uint32_t* offsets = it.get_offsets();
 
-                    uint32_t start_offset_index = it.offset_index[curr_index];
+                    uint32_t start_offset_index = it.get_offset_index()[curr_index];
                     uint32_t end_offset_index = (curr_index == curr_block->size() - 1) ?
                                                 curr_block->offsets.getLength() :
-                                                it.offset_index[curr_index + 1];
+                                                it.get_offset_index()[curr_index + 1];
 
                     if(j == its.size()-1) {
                         // check if the last query token is the last offset
@@ -1076,11 +1266,11 @@ void posting_list_t::get_exact_matches(std::vector<iterator_t>& its, const bool
                         break;
                     }
 
-                    uint32_t* offsets = it.offsets;
-                    uint32_t start_offset_index = it.offset_index[curr_index];
+                    const uint32_t* offsets = it.get_offsets();
+                    uint32_t start_offset_index = it.get_offset_index()[curr_index];
                     uint32_t end_offset_index = (curr_index == curr_block->size() - 1) ?
                                                 curr_block->offsets.getLength() :
-                                                it.offset_index[curr_index + 1];
+                                                it.get_offset_index()[curr_index + 1];
 
                     int prev_pos = -1;
                     bool has_atleast_one_last_token = false;
@@ -1164,11 +1354,11 @@ void posting_list_t::get_matching_array_indices(uint32_t id, std::vector<iterato
             return;
         }
 
-        uint32_t* offsets = it.offsets;
-        uint32_t start_offset_index = it.offset_index[curr_index];
+        const uint32_t* offsets = it.get_offsets();
+        uint32_t start_offset_index = it.get_offset_index()[curr_index];
         uint32_t end_offset_index = (curr_index == curr_block->size() - 1) ?
                                     curr_block->offsets.getLength() :
-                                    it.offset_index[curr_index + 1];
+                                    it.get_offset_index()[curr_index + 1];
 
         int prev_pos = -1;
         while(start_offset_index < end_offset_index) {
@@ -1206,16 +1396,49 @@ void posting_list_t::get_matching_array_indices(uint32_t id, std::vector<iterato
 
 /* iterator_t operations */
 
-posting_list_t::iterator_t::iterator_t(posting_list_t::block_t* start, posting_list_t::block_t* end):
-        curr_block(start), curr_index(0), end_block(end) {
+posting_list_t::iterator_t::iterator_t(const posting_list_t* list, const size_t start_block_index,
+                                       const size_t end_block_index):
+        curr_index(0), list(list), curr_block_index(start_block_index), end_block_index(end_block_index) {
+
+    curr_block = (start_block_index < list->blocks.size()) ? list->blocks[start_block_index] : nullptr;
+    end_block = (end_block_index < list->blocks.size()) ? list->blocks[end_block_index] : nullptr;
+    decode_block();
+}
+
+void posting_list_t::iterator_t::decode_block() {
+    offsets_decoded = false;
 
     if(curr_block != end_block) {
-        ids = curr_block->ids.uncompress();
-        offset_index = curr_block->offset_index.uncompress();
-        offsets = curr_block->offsets.uncompress();
+        // resize() retains capacity, so buffers stop growing once they fit the largest block
+        ids.resize(curr_block->ids.getLength());
+        curr_block->ids.uncompress_into(ids.data());
     }
 }
 
+void posting_list_t::iterator_t::decode_offsets() const {
+    if(offsets_decoded || curr_block == end_block) {
+        return ;
+    }
+
+    offset_index.resize(curr_block->offset_index.getLength());
+    curr_block->offset_index.uncompress_into(offset_index.data());
+
+    offsets.resize(curr_block->offsets.getLength());
+    curr_block->offsets.uncompress_into(offsets.data());
+
+    offsets_decoded = true;
+}
+
+const uint32_t* posting_list_t::iterator_t::get_offset_index() const {
+    decode_offsets();
+    return offset_index.data();
+}
+
+const uint32_t* posting_list_t::iterator_t::get_offsets() const {
+    decode_offsets();
+    return offsets.data();
+}
+
 bool posting_list_t::iterator_t::valid() const {
     return (curr_block != end_block) && (curr_index < curr_block->size());
 }
@@ -1225,18 +1448,8 @@ void posting_list_t::iterator_t::next() {
     if(curr_index == curr_block->size()) {
         curr_index = 0;
         curr_block = curr_block->next;
-
-        delete [] ids;
-        delete [] offset_index;
-        delete [] offsets;
-
-        ids = offset_index = offsets = nullptr;
-
-        if(curr_block != end_block) {
-            ids = curr_block->ids.uncompress();
-            offset_index = curr_block->offset_index.uncompress();
-            offsets = curr_block->offsets.uncompress();
-        }
+        curr_block_index++;
+        decode_block();
     }
 }
 
@@ -1253,28 +1466,12 @@ posting_list_t::block_t* posting_list_t::iterator_t::block() const {
 }
 
 void posting_list_t::iterator_t::skip_to(uint32_t id) {
-    bool skipped_block = false;
-    while(curr_block != end_block && curr_block->ids.last() < id) {
-        curr_block = curr_block->next;
-
-        // FIXME: remove duplication
-        delete [] ids;
-        delete [] offset_index;
-        delete [] offsets;
-
-        ids = offset_index = offsets = nullptr;
-
-        if(curr_block != end_block) {
-            ids = curr_block->ids.uncompress();
-            offset_index = curr_block->offset_index.uncompress();
-            offsets = curr_block->offsets.uncompress();
-        }
-
-        skipped_block = true;
-    }
-
-    if(skipped_block) {
+    if(curr_block != end_block && curr_block->ids.last() < id) {
+        // jump directly to the target block: blocks in between are neither visited nor decoded
+        curr_block_index = list->lower_bound_block(id, curr_block_index + 1, end_block_index);
+        curr_block = (curr_block_index == end_block_index) ? end_block : list->blocks[curr_block_index];
         curr_index = 0;
+        decode_block();
     }
 
     while(curr_block != end_block && curr_index < curr_block->size() && this->id() < id) {
@@ -1282,28 +1479,13 @@ void posting_list_t::iterator_t::skip_to(uint32_t id) {
     }
 }
 
-posting_list_t::iterator_t::~iterator_t() {
-    delete [] ids;
-    ids = nullptr;
-
-    delete [] offsets;
-    offsets = nullptr;
-
-    delete [] offset_index;
-    offset_index = nullptr;
-}
-
-posting_list_t::iterator_t::iterator_t(iterator_t&& rhs) noexcept {
-    curr_block = rhs.curr_block;
-    curr_index = rhs.curr_index;
-    end_block = rhs.end_block;
-    ids = rhs.ids;
-    offset_index = rhs.offset_index;
-    offsets = rhs.offsets;
+posting_list_t::iterator_t::iterator_t(iterator_t&& rhs) noexcept:
+        curr_block(rhs.curr_block), curr_index(rhs.curr_index), end_block(rhs.end_block),
+        list(rhs.list), curr_block_index(rhs.curr_block_index), end_block_index(rhs.end_block_index),
+        ids(std::move(rhs.ids)), offset_index(std::move(rhs.offset_index)), offsets(std::move(rhs.offsets)),
+        offsets_decoded(rhs.offsets_decoded) {
 
     rhs.curr_block = nullptr;
     rhs.end_block = nullptr;
-    rhs.ids = nullptr;
-    rhs.offset_index = nullptr;
-    rhs.offsets = nullptr;
+    rhs.offsets_decoded = false;
 }
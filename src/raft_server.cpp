@@ -754,6 +754,14 @@ int64_t ReplicationState::get_num_queued_writes() {
     return batched_indexer->get_queued_writes();
 }
 
+bool ReplicationState::is_write_admitted(const std::string& coll_name, uint32_t& retry_after_seconds) {
+    return batched_indexer->is_write_admitted(coll_name, retry_after_seconds);
+}
+
+void ReplicationState::get_write_stats(nlohmann::json& stats) {
+    batched_indexer->get_write_stats(stats);
+}
+
 bool ReplicationState::is_leader() {
     std::shared_lock lock(node_mutex);
 
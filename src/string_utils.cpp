@@ -291,6 +291,59 @@ bool StringUtils::ends_with(const std::string& str, const std::string& ending) {
     }
 }
 
+bool StringUtils::is_complete_json_object(const std::string& str) {
+    size_t begin = 0;
+    size_t end = str.size();
+
+    while(begin < end && isspace(str[begin])) {
+        begin++;
+    }
+
+    while(end > begin && isspace(str[end - 1])) {
+        end--;
+    }
+
+    if(begin == end || str[begin] != '{' || str[end - 1] != '}') {
+        return false;
+    }
+
+    size_t depth = 0;
+    bool inside_string = false;
+
+    for(size_t i = begin; i < end; i++) {
+        const char c = str[i];
+
+        if(inside_string) {
+            if(c == '\\') {
+                i++;
+            } else if(c == '"') {
+                inside_string = false;
+            }
+
+            continue;
+        }
+
+        if(c == '"') {
+            inside_string = true;
+        } else if(c == '{' || c == '[') {
+            depth++;
+        } else if(c == '}' || c == ']') {
+            if(depth == 0) {
+                return false;
+            }
+
+            depth--;
+
+            // the object closed before the end: whatever follows is not part of it
+            if(depth == 0 && i != end - 1) {
+                return false;
+            }
+        }
+    }
+
+    return depth == 0 && !inside_string;
+}
+
 /*size_t StringUtils::unicode_length(const std::string& bytes) {
     std::wstring_convert<std::codecvt_utf8<char32_t>, char32_t> utf8conv;
     return utf8conv.from_bytes(bytes).size();
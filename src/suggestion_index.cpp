@@ -0,0 +1,365 @@
+#include "suggestion_index.h"
+#include <algorithm>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+suggestion_index_t::suggestion_index_t() {
+    nodes.emplace_back();
+}
+
+void suggestion_index_t::add(const std::string& phrase, int64_t weight) {
+    if(phrase.empty() || weight == 0) {
+        return ;
+    }
+
+    std::unique_lock lock(mutex);
+
+    int64_t& change = delta[phrase];
+    change += weight;
+
+    if(change == 0) {
+        delta.erase(phrase);
+    }
+
+    if(delta.size() > std::max(MIN_REBUILD_DELTA_SIZE, entries.size() / 8)) {
+        build();
+    }
+}
+
+void suggestion_index_t::build() {
+    // merge pending changes into the sorted phrases
+    std::vector<entry_t> merged;
+    merged.reserve(entries.size() + delta.size());
+
+    auto entry_it = entries.begin();
+    auto delta_it = delta.begin();
+
+    while(entry_it != entries.end() || delta_it != delta.end()) {
+        entry_t entry;
+
+        if(delta_it == delta.end() || (entry_it != entries.end() && entry_it->phrase < delta_it->first)) {
+            entry = std::move(*entry_it++);
+        } else if(entry_it == entries.end() || delta_it->first < entry_it->phrase) {
+            entry = {delta_it->first, delta_it->second};
+            delta_it++;
+        } else {
+            entry = {std::move(entry_it->phrase), entry_it->weight + delta_it->second};
+            entry_it++;
+            delta_it++;
+        }
+
+        if(entry.weight > 0) {
+            merged.push_back(std::move(entry));
+        }
+    }
+
+    entries = std::move(merged);
+    delta.clear();
+
+    // lay out the trie breadth first: every node covers the range of phrases that share its path
+    struct range_t {
+        uint32_t node_id;
+        uint32_t begin;
+        uint32_t end;
+        uint32_t depth;
+    };
+
+    nodes.clear();
+    nodes.emplace_back();
+
+    std::queue<range_t> ranges;
+    ranges.push({0, 0, uint32_t(entries.size()), 0});
+
+    while(!ranges.empty()) {
+        range_t range = ranges.front();
+        ranges.pop();
+
+        if(range.begin < range.end && entries[range.begin].phrase.size() == range.depth) {
+            nodes[range.node_id].entry = range.begin;
+            range.begin++;
+        }
+
+        nodes[range.node_id].first_child = nodes.size();
+
+        uint32_t child_begin = range.begin;
+
+        while(child_begin < range.end) {
+            const unsigned char c = entries[child_begin].phrase[range.depth];
+            uint32_t child_end = child_begin + 1;
+
+            while(child_end < range.end && (unsigned char) entries[child_end].phrase[range.depth] == c) {
+                child_end++;
+            }
+
+            node_t child;
+            child.c = c;
+            ranges.push({uint32_t(nodes.size()), child_begin, child_end, range.depth + 1});
+            nodes.push_back(child);
+            nodes[range.node_id].num_children++;
+
+            child_begin = child_end;
+        }
+    }
+
+    // children always come after their parent
+    for(size_t i = nodes.size(); i-- > 0;) {
+        node_t& node = nodes[i];
+        node.max_weight = (node.entry == -1) ? 0 : entries[node.entry].weight;
+
+        for(size_t j = 0; j < node.num_children; j++) {
+            node.max_weight = std::max(node.max_weight, nodes[node.first_child + j].max_weight);
+        }
+    }
+}
+
+int64_t suggestion_index_t::trie_weight(const std::string& phrase) const {
+    uint32_t node_id = 0;
+
+    for(const char c: phrase) {
+        const node_t& node = nodes[node_id];
+        auto children_begin = nodes.begin() + node.first_child;
+        auto children_end = children_begin + node.num_children;
+
+        auto child = std::lower_bound(children_begin, children_end, (unsigned char) c,
+                                      [](const node_t& n, unsigned char key) { return n.c < key; });
+
+        if(child == children_end || child->c != (unsigned char) c) {
+            return 0;
+        }
+
+        node_id = child - nodes.begin();
+    }
+
+    const int32_t entry = nodes[node_id].entry;
+    return (entry == -1) ? 0 : entries[entry].weight;
+}
+
+void suggestion_index_t::trie_matches(const std::string& prefix, size_t max_typos,
+                                      std::vector<std::pair<uint32_t, uint32_t>>& roots) const {
+    // Levenshtein rows of the prefix against the path of every visited node: a node whose row ends within
+    // `max_typos` edits is a root of completions, and is recorded only when it improves on its nearest root above
+    const size_t num_cols = prefix.size() + 1;
+
+    struct frame_t {
+        uint32_t node_id;
+        uint32_t best_cost;
+        std::vector<uint32_t> row;
+    };
+
+    std::vector<uint32_t> root_row(num_cols);
+    for(size_t i = 0; i < num_cols; i++) {
+        root_row[i] = i;
+    }
+
+    std::vector<frame_t> stack;
+    stack.push_back({0, UINT32_MAX, std::move(root_row)});
+
+    while(!stack.empty()) {
+        frame_t frame = std::move(stack.back());
+        stack.pop_back();
+
+        uint32_t best_cost = frame.best_cost;
+        const uint32_t cost = frame.row[prefix.size()];
+
+        if(cost <= max_typos && cost < best_cost) {
+            roots.emplace_back(frame.node_id, cost);
+            best_cost = cost;
+        }
+
+        // rows never decrease below their minimum, so a subtree can only improve when its minimum does
+        const uint32_t row_min = *std::min_element(frame.row.begin(), frame.row.end());
+
+        if(row_min > max_typos || row_min >= best_cost) {
+            continue;
+        }
+
+        const node_t& node = nodes[frame.node_id];
+
+        for(size_t j = 0; j < node.num_children; j++) {
+            const uint32_t child_id = node.first_child + j;
+            const unsigned char c = nodes[child_id].c;
+
+            std::vector<uint32_t> row(num_cols);
+            row[0] = frame.row[0] + 1;
+
+            for(size_t i = 1; i < num_cols; i++) {
+                const uint32_t substitution = frame.row[i - 1] + ((unsigned char) prefix[i - 1] != c);
+                row[i] = std::min({frame.row[i] + 1, row[i - 1] + 1, substitution});
+            }
+
+            stack.push_back({child_id, best_cost, std::move(row)});
+        }
+    }
+}
+
+void suggestion_index_t::trie_top(const std::vector<uint32_t>& roots, size_t num_results,
+                                  std::vector<uint32_t>& entry_ids) const {
+    // best-first walk: nodes are expanded in order of the heaviest phrase below them
+    struct item_t {
+        int64_t weight;
+        uint32_t id;
+        bool is_entry;
+
+        bool operator<(const item_t& other) const {
+            return weight < other.weight;
+        }
+    };
+
+    std::priority_queue<item_t> queue;
+
+    for(uint32_t root: roots) {
+        queue.push({nodes[root].max_weight, root, false});
+    }
+
+    while(!queue.empty() && entry_ids.size() < num_results) {
+        const item_t item = queue.top();
+        queue.pop();
+
+        if(item.is_entry) {
+            entry_ids.push_back(item.id);
+            continue;
+        }
+
+        const node_t& node = nodes[item.id];
+
+        if(node.entry != -1) {
+            queue.push({entries[node.entry].weight, uint32_t(node.entry), true});
+        }
+
+        for(size_t j = 0; j < node.num_children; j++) {
+            const uint32_t child_id = node.first_child + j;
+            queue.push({nodes[child_id].max_weight, child_id, false});
+        }
+    }
+}
+
+void suggestion_index_t::suggest(const std::string& prefix, size_t num_typos, size_t limit,
+                                 std::vector<suggestion_t>& suggestions) const {
+    num_typos = std::min(num_typos, MAX_TYPOS);
+
+    std::shared_lock lock(mutex);
+
+    // phrase => {weight, typos}
+    std::unordered_map<std::string, std::pair<int64_t, uint32_t>> candidates;
+
+    // pending changes are checked directly; a phrase whose weight went down can push at most one phrase
+    // of the trie out of the top results
+    size_t num_decreased = 0;
+
+    auto add_delta_candidate = [&](const std::string& phrase, int64_t change) {
+        const size_t typos = prefix_edit_distance(prefix, phrase, num_typos);
+        if(typos > num_typos) {
+            return ;
+        }
+
+        if(change < 0) {
+            num_decreased++;
+        }
+
+        candidates[phrase] = {trie_weight(phrase) + change, typos};
+    };
+
+    if(num_typos == 0) {
+        for(auto it = delta.lower_bound(prefix); it != delta.end() &&
+                                                 it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            add_delta_candidate(it->first, it->second);
+        }
+    } else {
+        for(const auto& kv: delta) {
+            add_delta_candidate(kv.first, kv.second);
+        }
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> roots;
+    trie_matches(prefix, num_typos, roots);
+
+    std::unordered_set<uint32_t> seen_entries;
+
+    for(uint32_t typos = 0; typos <= num_typos; typos++) {
+        std::vector<uint32_t> typo_roots;
+        for(const auto& root: roots) {
+            if(root.second == typos) {
+                typo_roots.push_back(root.first);
+            }
+        }
+
+        if(typo_roots.empty()) {
+            continue;
+        }
+
+        // phrases already found with fewer typos may be found again through a nested root
+        std::vector<uint32_t> entry_ids;
+        trie_top(typo_roots, limit + num_decreased + seen_entries.size(), entry_ids);
+
+        for(uint32_t entry_id: entry_ids) {
+            if(!seen_entries.insert(entry_id).second) {
+                continue;
+            }
+
+            const entry_t& entry = entries[entry_id];
+            if(candidates.count(entry.phrase) == 0) {
+                candidates[entry.phrase] = {entry.weight, typos};
+            }
+        }
+    }
+
+    for(const auto& kv: candidates) {
+        if(kv.second.first > 0) {
+            suggestions.push_back({kv.first, kv.second.first, kv.second.second});
+        }
+    }
+
+    std::sort(suggestions.begin(), suggestions.end(), [](const suggestion_t& a, const suggestion_t& b) {
+        if(a.num_typos != b.num_typos) {
+            return a.num_typos < b.num_typos;
+        }
+
+        if(a.weight != b.weight) {
+            return a.weight > b.weight;
+        }
+
+        return a.text < b.text;
+    });
+
+    if(suggestions.size() > limit) {
+        suggestions.resize(limit);
+    }
+}
+
+size_t suggestion_index_t::size() const {
+    std::shared_lock lock(mutex);
+    return entries.size();
+}
+
+size_t suggestion_index_t::prefix_edit_distance(const std::string& prefix, const std::string& phrase,
+                                                size_t max_distance) {
+    // smallest edit distance between `prefix` and any prefix of `phrase`
+    const size_t num_cols = prefix.size() + 1;
+    std::vector<size_t> row(num_cols), next_row(num_cols);
+
+    for(size_t i = 0; i < num_cols; i++) {
+        row[i] = i;
+    }
+
+    size_t distance = row[prefix.size()];
+
+    for(const char c: phrase) {
+        next_row[0] = row[0] + 1;
+
+        for(size_t i = 1; i < num_cols; i++) {
+            const size_t substitution = row[i - 1] + (prefix[i - 1] != c);
+            next_row[i] = std::min({row[i] + 1, next_row[i - 1] + 1, substitution});
+        }
+
+        row.swap(next_row);
+        distance = std::min(distance, row[prefix.size()]);
+
+        if(*std::min_element(row.begin(), row.end()) > std::min(distance, max_distance)) {
+            break;
+        }
+    }
+
+    return distance;
+}
@@ -1,5 +1,6 @@
 #include <sstream>
 #include <algorithm>
+#include <emmintrin.h>
 #include "tokenizer.h"
 
 Tokenizer::Tokenizer(const std::string& input, bool normalize, bool no_op, const std::string& locale,
@@ -14,49 +15,98 @@ Tokenizer::Tokenizer(const std::string& input, bool normalize, bool no_op, const
         if(U_FAILURE(translit_status)) {
             //LOG(ERROR) << "Unable to create transliteration instance for `zh` locale.";
             transliterator = nullptr;
-            text = input;
-        } else {
-            icu::UnicodeString unicode_input = icu::UnicodeString::fromUTF8(input);
-            transliterator->transliterate(unicode_input);
-            std::string output;
-            unicode_input.toUTF8String(output);
-            normalized_text = (char *)malloc(output.size()+1);
-            strcpy(normalized_text, output.c_str());
-            text = normalized_text;
         }
     }
 
-    else if(locale == "ja") {
+    if(!locale.empty() && locale != "en") {
+        UErrorCode status = U_ZERO_ERROR;
+        const icu::Locale& icu_locale = icu::Locale(locale.c_str());
+        bi = icu::BreakIterator::createWordInstance(icu_locale, status);
+    }
+
+    // only ascii bytes are classified: multi-byte characters are always indexed
+    for(size_t c = 0; c < 128; c++) {
+        stream_modes[c] = std::isalnum(c) ? INDEX : SKIP;
+    }
+
+    stream_modes[uint8_t(' ')] = SEPARATE;
+    stream_modes[uint8_t('\n')] = SEPARATE;
+
+    for(char c: separators) {
+        if(is_ascii_char(c) && stream_modes[uint8_t(c)] != INDEX) {
+            stream_modes[uint8_t(c)] = SEPARATE;
+        }
+    }
+
+    for(char c: symbols_to_index) {
+        if(is_ascii_char(c)) {
+            stream_modes[uint8_t(c)] = INDEX;
+        }
+    }
+
+    UErrorCode errcode = U_ZERO_ERROR;
+    nfkd = icu::Normalizer2::getNFKDInstance(errcode);
+
+    init(input);
+}
+
+void Tokenizer::init(const std::string& input) {
+    i = 0;
+    token_counter = 0;
+    out.clear();
+
+    free(normalized_text);
+    normalized_text = nullptr;
+
+    if(transliterator != nullptr) {
+        icu::UnicodeString unicode_input = icu::UnicodeString::fromUTF8(input);
+        transliterator->transliterate(unicode_input);
+        std::string output;
+        unicode_input.toUTF8String(output);
+        normalized_text = (char *)malloc(output.size()+1);
+        strcpy(normalized_text, output.c_str());
+        text = normalized_text;
+    } else if(locale == "ja") {
         normalized_text = JapaneseLocalizer::get_instance().normalize(input);
         text = normalized_text;
     } else {
         text = input;
     }
 
-    cd = iconv_open("ASCII//TRANSLIT", "UTF-8");
-
-    if(!locale.empty() && locale != "en") {
-        UErrorCode status = U_ZERO_ERROR;
-        const icu::Locale& icu_locale = icu::Locale(locale.c_str());
-        bi = icu::BreakIterator::createWordInstance(icu_locale, status);
-
+    if(bi != nullptr) {
         unicode_text = icu::UnicodeString::fromUTF8(text);
         bi->setText(unicode_text);
 
         position = bi->first();
         prev_position = -1;
+        utf8_start_index = 0;
     }
 
-    for(char c: symbols_to_index) {
-        index_symbols[uint8_t(c)] = 1;
+    ascii_text = !no_op && bi == nullptr && is_ascii_text(text.data(), text.size());
+}
+
+void Tokenizer::reset(const std::string& input) {
+    init(input);
+}
+
+bool Tokenizer::is_ascii_text(const char* data, size_t size) {
+    size_t index = 0;
+
+    // the high bit of every byte of a multi-byte character is set
+    for(; index + 16 <= size; index += 16) {
+        const __m128i chunk = _mm_loadu_si128((const __m128i*)(data + index));
+        if(_mm_movemask_epi8(chunk) != 0) {
+            return false;
+        }
     }
 
-    for(char c: separators) {
-        separator_symbols[uint8_t(c)] = 1;
+    for(; index < size; index++) {
+        if(!is_ascii_char(data[index])) {
+            return false;
+        }
     }
 
-    UErrorCode errcode = U_ZERO_ERROR;
-    nfkd = icu::Normalizer2::getNFKDInstance(errcode);
+    return true;
 }
 
 bool Tokenizer::next(std::string &token, size_t& token_index, size_t& start_index, size_t& end_index) {
@@ -136,9 +186,38 @@ bool Tokenizer::next(std::string &token, size_t& token_index, size_t& start_inde
         return false;
     }
 
+    if(ascii_text) {
+        while(i < text.size()) {
+            const char c = text[i];
+            const uint8_t this_stream_mode = get_stream_mode(c);
+
+            if(this_stream_mode == INDEX) {
+                if(out.empty()) {
+                    start_index = i;
+                }
+
+                out += (normalize && c >= 'A' && c <= 'Z') ? char(c + ('a' - 'A')) : c;
+                i++;
+                continue;
+            }
+
+            if(this_stream_mode == SEPARATE && !out.empty()) {
+                token = out;
+                out.clear();
+
+                token_index = token_counter++;
+                end_index = i - 1;
+                i++;
+                return true;
+            }
+
+            i++;
+        }
+    }
+
     while(i < text.size()) {
         if(is_ascii_char(text[i])) {
-            size_t this_stream_mode = get_stream_mode(text[i]);
+            const uint8_t this_stream_mode = get_stream_mode(text[i]);
 
             if(this_stream_mode == SKIP) {
                 i++;
@@ -189,6 +268,10 @@ bool Tokenizer::next(std::string &token, size_t& token_index, size_t& start_inde
             continue;
         }
 
+        if(cd == (iconv_t) -1) {
+            cd = iconv_open("ASCII//TRANSLIT", "UTF-8");
+        }
+
         char outbuf[5] = {};
         size_t outsize = sizeof(outbuf);
         char *outptr = outbuf;
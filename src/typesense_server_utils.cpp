@@ -76,11 +76,15 @@ void init_cmdline_options(cmdline::parser & options, int argc, char **argv) {
     options.add<uint32_t>("ssl-refresh-interval-seconds", '\0', "Frequency of automatic reloading of SSL certs from disk.", false, 8 * 60 * 60);
 
     options.add("enable-cors", '\0', "Enable CORS requests.");
+    options.add("enable-forward-index", '\0', "Keep the tokens of every document in memory for faster deletes and updates.");
+    options.add<uint32_t>("topk-cache-prefix-len", '\0', "Top completions of prefixes up to this length are cached in memory (0 disables the cache).", false, 2);
 
     options.add<float>("max-memory-ratio", '\0', "Maximum fraction of system memory to be used.", false, 1.0f);
     options.add<int>("snapshot-interval-seconds", '\0', "Frequency of replication log snapshots.", false, 3600);
     options.add<size_t>("healthy-read-lag", '\0', "Reads are rejected if the updates lag behind this threshold.", false, 1000);
     options.add<size_t>("healthy-write-lag", '\0', "Writes are rejected if the updates lag behind this threshold.", false, 500);
+    options.add<size_t>("collection-write-lag", '\0', "Writes to a collection are throttled if its queued write requests exceed this threshold.", false, 250);
+    options.add<size_t>("collection-pending-write-bytes", '\0', "Writes to a collection are throttled if its pending writes exceed this size.", false, 512 * 1024 * 1024);
     options.add<int>("log-slow-requests-time-ms", '\0', "When > 0, requests that take longer than this duration are logged.", false, -1);
 
     options.add<uint32_t>("num-collections-parallel-load", '\0', "Number of collections that are loaded in parallel during start up.", false, 4);
@@ -7,6 +7,7 @@
 #include <art.h>
 #include <chrono>
 #include <posting.h>
+#include "threadpool.h"
 
 #define words_file_path std::string(std::string(ROOT_DIR)+"/build/test_resources/words.txt").c_str()
 #define uuid_file_path std::string(std::string(ROOT_DIR)+"/build/test_resources/uuid.txt").c_str()
@@ -1625,4 +1626,457 @@ TEST(ArtTest, test_encode_float_positive_negative) {
     ASSERT_TRUE(res == 0);
     ASSERT_EQ(5, results.size());
     results.clear();
-}
\ No newline at end of file
+}
+
+TEST(ArtTest, test_art_memory_accounting_and_compaction) {
+    art_tree t;
+    art_tree_init(&t);
+
+    ASSERT_EQ(0, art_bytes_in_use(&t));
+
+    const size_t num_keys = 20000;
+    std::vector<std::string> keys;
+
+    for(size_t i = 0; i < num_keys; i++) {
+        // every 100th key is long enough to be allocated outside the slabs
+        std::string key = "key" + std::to_string(i) + ((i % 100 == 0) ? std::string(300, 'x') : "");
+        keys.push_back(key);
+        art_document document = get_document(i);
+        ASSERT_TRUE(NULL == art_insert(&t, (const unsigned char*)key.c_str(), key.size()+1, &document));
+    }
+
+    size_t full_bytes_in_use = art_bytes_in_use(&t);
+    ASSERT_LT(0, full_bytes_in_use);
+    ASSERT_LE(full_bytes_in_use, art_bytes_reserved(&t));
+    ASSERT_FALSE(art_is_fragmented(&t));
+
+    // delete all but every 10th key
+    for(size_t i = 0; i < num_keys; i++) {
+        if(i % 10 == 0) {
+            continue;
+        }
+
+        const std::string& key = keys[i];
+        void* values = art_delete(&t, (const unsigned char*)key.c_str(), key.size()+1);
+        ASSERT_TRUE(values != NULL);
+        posting_t::destroy_list(values);
+    }
+
+    size_t bytes_in_use = art_bytes_in_use(&t);
+    ASSERT_GT(full_bytes_in_use / 5, bytes_in_use);
+    ASSERT_TRUE(art_is_fragmented(&t));
+
+    size_t bytes_reserved = art_bytes_reserved(&t);
+    art_compact(&t);
+
+    ASSERT_EQ(bytes_in_use, art_bytes_in_use(&t));
+    ASSERT_GT(bytes_reserved / 2, art_bytes_reserved(&t));
+    ASSERT_EQ(num_keys / 10, art_size(&t));
+    ASSERT_FALSE(art_is_fragmented(&t));
+
+    for(size_t i = 0; i < num_keys; i += 10) {
+        const std::string& key = keys[i];
+        art_leaf* l = (art_leaf *) art_search(&t, (const unsigned char*)key.c_str(), key.size()+1);
+        ASSERT_TRUE(l != NULL);
+        ASSERT_EQ(key.size()+1, l->key_len);
+        ASSERT_TRUE(posting_t::contains(l->values, i));
+    }
+
+    // further mutations work on the compacted tree
+    for(size_t i = 0; i < num_keys; i += 10) {
+        const std::string& key = keys[i];
+        void* values = art_delete(&t, (const unsigned char*)key.c_str(), key.size()+1);
+        ASSERT_TRUE(values != NULL);
+        posting_t::destroy_list(values);
+    }
+
+    ASSERT_EQ(0, art_size(&t));
+    ASSERT_EQ(0, art_bytes_in_use(&t));
+
+    // the compacted tree has not grown since, so it is not compacted again
+    ASSERT_FALSE(art_is_fragmented(&t));
+
+    art_tree_destroy(&t);
+
+    // a small tree only reserves small slabs
+    art_tree small_t;
+    art_tree_init(&small_t);
+
+    for(size_t i = 0; i < 3; i++) {
+        const std::string& key = keys[i + 1];
+        art_document document = get_document(i);
+        ASSERT_TRUE(NULL == art_insert(&small_t, (const unsigned char*)key.c_str(), key.size()+1, &document));
+    }
+
+    ASSERT_GT(4 * 1024, art_bytes_reserved(&small_t));
+    art_tree_destroy(&small_t);
+}
+
+TEST(ArtTest, test_art_search_batch) {
+    art_tree t;
+    art_tree_init(&t);
+
+    // keys fan out into node4, node16, node48 and node256 children
+    std::vector<std::string> keys;
+    for(size_t i = 0; i < 5000; i++) {
+        std::string key = "k" + std::to_string(i * 7);
+        if(i % 3 == 0) {
+            key += char('a' + (i % 26));
+        }
+        keys.push_back(key);
+    }
+
+    for(size_t i = 0; i < keys.size(); i++) {
+        art_document document = get_document(i);
+        art_insert(&t, (const unsigned char*)keys[i].c_str(), keys[i].size()+1, &document);
+    }
+
+    std::vector<std::string> lookups = keys;
+    lookups.push_back("k");
+    lookups.push_back("missing");
+    lookups.push_back("k7000000");
+    lookups.push_back("");
+
+    std::vector<const unsigned char*> lookup_keys;
+    std::vector<int> lookup_key_lens;
+    for(const auto& lookup: lookups) {
+        lookup_keys.push_back((const unsigned char*)lookup.c_str());
+        lookup_key_lens.push_back(lookup.size()+1);
+    }
+
+    std::vector<art_leaf*> leaves(lookups.size());
+    art_search_batch(&t, lookup_keys.data(), lookup_key_lens.data(), lookups.size(), leaves.data());
+
+    for(size_t i = 0; i < lookups.size(); i++) {
+        art_leaf* expected = (art_leaf*) art_search(&t, lookup_keys[i], lookup_key_lens[i]);
+        ASSERT_EQ(expected, leaves[i]);
+        ASSERT_EQ(i < keys.size(), leaves[i] != NULL);
+    }
+
+    // a prefix iteration visits the keys in lexicographic order
+    std::vector<std::string> iterated;
+    art_iter_prefix(&t, (const unsigned char*)"k", 1, [](void *data, const unsigned char *key, uint32_t key_len,
+                                                          void *value) {
+        ((std::vector<std::string>*) data)->emplace_back((const char*)key, key_len - 1);
+        return 0;
+    }, &iterated);
+
+    std::vector<std::string> sorted_keys = keys;
+    std::sort(sorted_keys.begin(), sorted_keys.end());
+    ASSERT_EQ(sorted_keys, iterated);
+
+    art_leaf* min_leaf = art_minimum(&t);
+    art_leaf* max_leaf = art_maximum(&t);
+    ASSERT_EQ(sorted_keys.front(), std::string((const char*)min_leaf->key, min_leaf->key_len - 1));
+    ASSERT_EQ(sorted_keys.back(), std::string((const char*)max_leaf->key, max_leaf->key_len - 1));
+
+    art_tree_destroy(&t);
+}
+
+TEST(ArtTest, test_art_topk_cache_for_short_prefixes) {
+    art_tree t;
+    art_tree_init(&t);
+
+    art_tree uncached;
+    art_tree_init(&uncached);
+    art_set_topk_cache_prefix_len(&uncached, 0);
+
+    // word `i` is scored `i` and occurs in `i % 7 + 1` documents
+    std::vector<std::string> words;
+    for(size_t i = 0; i < 2000; i++) {
+        words.push_back(std::string(1, char('a' + (i % 3))) + std::string(1, char('a' + (i % 5))) +
+                        std::to_string(i));
+    }
+
+    auto insert = [&](art_tree* tree, size_t i, int64_t score) {
+        std::vector<art_document> documents;
+        for(size_t j = 0; j <= i % 7; j++) {
+            documents.emplace_back(i * 10 + j, score, std::vector<uint32_t>{0});
+        }
+        art_inserts(tree, (const unsigned char*)words[i].c_str(), words[i].size()+1, score, documents);
+    };
+
+    for(size_t i = 0; i < words.size(); i++) {
+        insert(&t, i, i);
+        insert(&uncached, i, i);
+    }
+
+    auto search = [&](art_tree* tree, const std::string& prefix, token_ordering order) {
+        std::vector<art_leaf*> leaves;
+        art_fuzzy_search(tree, (const unsigned char*)prefix.c_str(), prefix.size(), 0, 0, 10, order, true,
+                         nullptr, 0, leaves);
+        std::vector<std::string> keys;
+        for(auto leaf: leaves) {
+            keys.emplace_back((const char*)leaf->key);
+        }
+        return keys;
+    };
+
+    auto cached_results = search(&t, "a", MAX_SCORE);
+    ASSERT_EQ(10, cached_results.size());
+    ASSERT_EQ(search(&uncached, "a", MAX_SCORE), cached_results);
+    ASSERT_EQ("ad1998", cached_results[0]);
+
+    // served from the cache entry
+    ASSERT_EQ(cached_results, search(&t, "a", MAX_SCORE));
+    ASSERT_EQ(search(&uncached, "ab", MAX_SCORE), search(&t, "ab", MAX_SCORE));
+
+    // the most frequent words come first
+    auto frequent_results = search(&t, "b", FREQUENCY);
+    ASSERT_EQ(10, frequent_results.size());
+    for(const auto& key: frequent_results) {
+        art_leaf* l = (art_leaf*) art_search(&t, (const unsigned char*)key.c_str(), key.size()+1);
+        ASSERT_EQ(7, posting_t::num_ids(l->values));
+    }
+
+    // new and deleted words are reflected in cached entries
+
+    words.push_back("aa_new");
+    insert(&t, words.size()-1, 10000);
+    ASSERT_EQ("aa_new", search(&t, "a", MAX_SCORE)[0]);
+    ASSERT_EQ("aa_new", search(&t, "aa", MAX_SCORE)[0]);
+
+    void* values = art_delete(&t, (const unsigned char*)"aa_new", strlen("aa_new")+1);
+    posting_t::destroy_list(values);
+    ASSERT_EQ(cached_results, search(&t, "a", MAX_SCORE));
+
+    // a word whose document count drops is re-ranked
+    const std::string& top_frequent = frequent_results[0];
+    art_leaf* l = (art_leaf*) art_search(&t, (const unsigned char*)top_frequent.c_str(), top_frequent.size()+1);
+    uint32_t first_id = posting_t::first_id(l->values);
+    posting_t::erase(l->values, first_id);
+    art_topk_update(&t, l);
+
+    auto updated_results = search(&t, "b", FREQUENCY);
+    ASSERT_EQ(10, updated_results.size());
+    ASSERT_EQ(updated_results.end(), std::find(updated_results.begin(), updated_results.end(), top_frequent));
+
+    // prefixes without keys
+    ASSERT_TRUE(search(&t, "z", MAX_SCORE).empty());
+
+    art_tree_destroy(&t);
+    art_tree_destroy(&uncached);
+}
+
+TEST(ArtTest, test_art_fuzzy_search_prunes_subtrees_by_filter_ids) {
+    art_tree t;
+    art_tree_init(&t);
+    art_set_topk_cache_prefix_len(&t, 0);
+
+    // word `i` occurs in documents `i` and `i + 3000`
+    std::vector<std::string> words;
+    for(size_t i = 0; i < 3000; i++) {
+        words.push_back("w" + std::to_string(i * 13));
+        std::vector<art_document> documents = {art_document(i, i, {0}), art_document(i + 3000, i, {0})};
+        art_inserts(&t, (const unsigned char*)words[i].c_str(), words[i].size()+1, i, documents);
+    }
+
+    auto search = [&](const std::string& term, int max_cost, bool prefix, const std::vector<uint32_t>& filter_ids) {
+        std::vector<art_leaf*> leaves;
+        art_fuzzy_search(&t, (const unsigned char*)term.c_str(), prefix ? term.size() : term.size() + 1,
+                         0, max_cost, 10000, MAX_SCORE, prefix, filter_ids.data(), filter_ids.size(), leaves);
+        std::vector<std::string> keys;
+        for(auto leaf: leaves) {
+            keys.emplace_back((const char*)leaf->key);
+        }
+        std::sort(keys.begin(), keys.end());
+        return keys;
+    };
+
+    // filtered results are the unfiltered results that contain a filtered document
+    auto filtered_search = [&](const std::string& term, int max_cost, bool prefix,
+                               const std::vector<uint32_t>& filter_ids) {
+        std::vector<std::string> keys;
+        for(const auto& key: search(term, max_cost, prefix, {})) {
+            art_leaf* l = (art_leaf*) art_search(&t, (const unsigned char*)key.c_str(), key.size()+1);
+            if(posting_t::contains_atleast_one(l->values, filter_ids.data(), filter_ids.size())) {
+                keys.push_back(key);
+            }
+        }
+        return keys;
+    };
+
+    std::vector<std::vector<uint32_t>> filters = {{1}, {77, 4500}, {3, 5, 8, 13, 21, 34, 55, 89}};
+
+    for(const auto& filter_ids: filters) {
+        ASSERT_EQ(filtered_search("w1", 0, true, filter_ids), search("w1", 0, true, filter_ids));
+        ASSERT_EQ(filtered_search("w", 0, true, filter_ids), search("w", 0, true, filter_ids));
+        ASSERT_EQ(filtered_search("w1001", 1, false, filter_ids), search("w1001", 1, false, filter_ids));
+    }
+
+    ASSERT_EQ(std::vector<std::string>{"w13"}, search("w", 0, true, {1}));
+
+    // a filter that spans most blocks of IDs disables pruning without changing the results
+    std::vector<uint32_t> broad_filter_ids;
+    for(uint32_t i = 0; i < 64 * 1024; i += 512) {
+        broad_filter_ids.push_back(i);
+    }
+
+    ASSERT_EQ(filtered_search("w2", 0, true, broad_filter_ids), search("w2", 0, true, broad_filter_ids));
+
+    // removed documents are dropped from the summaries on compaction
+    art_leaf* l = (art_leaf*) art_search(&t, (const unsigned char*)"w13", 4);
+    posting_t::erase(l->values, 1);
+    art_compact(&t);
+
+    ASSERT_TRUE(search("w", 0, true, {1}).empty());
+    ASSERT_EQ(std::vector<std::string>{"w13"}, search("w", 0, true, {3001}));
+
+    art_tree_destroy(&t);
+}
+
+TEST(ArtTest, test_art_fuzzy_search_prunes_subtrees_by_large_clustered_filters) {
+    art_tree t;
+    art_tree_init(&t);
+    art_set_topk_cache_prefix_len(&t, 0);
+
+    // word `i` occurs in documents `i` and `i + 3000`
+    std::vector<std::string> words;
+    for(size_t i = 0; i < 3000; i++) {
+        words.push_back("w" + std::to_string(i * 13));
+        std::vector<art_document> documents = {art_document(i, i, {0}), art_document(i + 3000, i, {0})};
+        art_inserts(&t, (const unsigned char*)words[i].c_str(), words[i].size()+1, i, documents);
+    }
+
+    auto search = [&](const std::string& term, int max_cost, bool prefix, const std::vector<uint32_t>& filter_ids) {
+        std::vector<art_leaf*> leaves;
+        art_fuzzy_search(&t, (const unsigned char*)term.c_str(), prefix ? term.size() : term.size() + 1,
+                         0, max_cost, 10000, MAX_SCORE, prefix, filter_ids.data(), filter_ids.size(), leaves);
+        std::set<std::string> keys;
+        for(auto leaf: leaves) {
+            keys.emplace((const char*)leaf->key);
+        }
+        return keys;
+    };
+
+    // a thousand documents of the same block of IDs, like those of a large brand
+    std::vector<uint32_t> filter_ids;
+    for(uint32_t i = 0; i < 1000; i++) {
+        filter_ids.push_back(i);
+    }
+
+    ASSERT_EQ(1000, search("w", 0, true, filter_ids).size());
+
+    // a leaf whose summary misses the filter is only left out when it is pruned
+    art_leaf* l = (art_leaf*) art_search(&t, (const unsigned char*)"w13", 4);
+    const uint64_t id_summary = l->id_summary;
+    l->id_summary = uint64_t(1) << 63;
+
+    // pruned while iterating the completions of a prefix
+    auto prefix_results = search("w", 0, true, filter_ids);
+    ASSERT_EQ(999, prefix_results.size());
+    ASSERT_EQ(0, prefix_results.count("w13"));
+
+    // pruned while walking the tree for typos
+    auto typo_results = search("w13", 1, false, filter_ids);
+    ASSERT_EQ(0, typo_results.count("w13"));
+    ASSERT_EQ(1, typo_results.count("w130"));
+
+    // not pruned when the filter spans most blocks of IDs
+    std::vector<uint32_t> broad_filter_ids = {1};
+    for(uint32_t i = 1024; i < 64 * 1024; i += 1024) {
+        broad_filter_ids.push_back(i);
+    }
+
+    ASSERT_EQ(1, search("w", 0, true, broad_filter_ids).count("w13"));
+    ASSERT_EQ(1, search("w13", 1, false, broad_filter_ids).count("w13"));
+
+    l->id_summary = id_summary;
+    ASSERT_EQ(1, search("w13", 1, false, filter_ids).count("w13"));
+
+    art_tree_destroy(&t);
+}
+
+TEST(ArtTest, test_art_inserts_batch_matches_serial_inserts) {
+    ThreadPool pool(4);
+
+    // keys spread over many first bytes, some of which already exist in the trees
+    std::vector<std::string> keys;
+    for(size_t i = 0; i < 5000; i++) {
+        keys.push_back(std::string(1, 'a' + (i % 26)) + std::to_string(i * 7919 % 10007));
+    }
+
+    for(size_t i = 0; i < 300; i++) {
+        keys.push_back("zz" + std::to_string(i));
+    }
+
+    for(const int64_t max_score: {int64_t(100), int64_t(INT64_MIN)}) {
+        art_tree serial_tree, batch_tree;
+        art_tree_init(&serial_tree);
+        art_tree_init(&batch_tree);
+
+        for(auto tree: {&serial_tree, &batch_tree}) {
+            art_document document(99999, 1, {0});
+            art_insert(tree, (const unsigned char*)"m1", 3, &document);
+        }
+
+        std::vector<std::vector<art_document>> serial_documents, batch_documents;
+        for(size_t i = 0; i < keys.size(); i++) {
+            serial_documents.push_back({art_document(i, i, {0, 1}), art_document(i + 10000, i, {2})});
+            batch_documents.push_back(serial_documents.back());
+        }
+
+        std::vector<art_key_documents> batch_keys;
+        for(size_t i = 0; i < keys.size(); i++) {
+            const auto *key = (const unsigned char*) keys[i].c_str();
+            art_inserts(&serial_tree, key, keys[i].size()+1, max_score, serial_documents[i]);
+            batch_keys.push_back({key, int(keys[i].size()+1), &batch_documents[i]});
+        }
+
+        art_inserts_batch(&batch_tree, batch_keys, max_score, &pool);
+
+        ASSERT_EQ(art_size(&serial_tree), art_size(&batch_tree));
+        ASSERT_EQ(serial_tree.root->id_summary, batch_tree.root->id_summary);
+        ASSERT_EQ(serial_tree.root->max_score, batch_tree.root->max_score);
+
+        for(const auto& key: keys) {
+            art_leaf* serial_leaf = (art_leaf*) art_search(&serial_tree, (const unsigned char*)key.c_str(), key.size()+1);
+            art_leaf* batch_leaf = (art_leaf*) art_search(&batch_tree, (const unsigned char*)key.c_str(), key.size()+1);
+            ASSERT_NE(nullptr, batch_leaf);
+
+            std::vector<uint32_t> serial_ids, batch_ids;
+            posting_t::merge({serial_leaf->values}, serial_ids);
+            posting_t::merge({batch_leaf->values}, batch_ids);
+            ASSERT_EQ(serial_ids, batch_ids);
+            ASSERT_EQ(serial_leaf->max_score, batch_leaf->max_score);
+        }
+
+        std::vector<art_leaf*> serial_leaves, batch_leaves;
+        art_fuzzy_search(&serial_tree, (const unsigned char*)"b1", 2, 0, 1, 10, FREQUENCY, true, nullptr, 0,
+                         serial_leaves);
+        art_fuzzy_search(&batch_tree, (const unsigned char*)"b1", 2, 0, 1, 10, FREQUENCY, true, nullptr, 0,
+                         batch_leaves);
+
+        ASSERT_EQ(serial_leaves.size(), batch_leaves.size());
+        for(size_t i = 0; i < serial_leaves.size(); i++) {
+            ASSERT_STREQ((const char*)serial_leaves[i]->key, (const char*)batch_leaves[i]->key);
+        }
+
+        art_tree_destroy(&serial_tree);
+        art_tree_destroy(&batch_tree);
+    }
+
+    // keys that all share a first byte are inserted serially
+    art_tree t;
+    art_tree_init(&t);
+
+    std::vector<std::string> a_keys;
+    std::vector<std::vector<art_document>> documents;
+
+    for(size_t i = 0; i < 2000; i++) {
+        a_keys.push_back("a" + std::to_string(i));
+        documents.push_back({art_document(i, i, {0})});
+    }
+
+    std::vector<art_key_documents> batch_keys;
+    for(size_t i = 0; i < a_keys.size(); i++) {
+        batch_keys.push_back({(const unsigned char*)a_keys[i].c_str(), int(a_keys[i].size()+1), &documents[i]});
+    }
+
+    art_inserts_batch(&t, batch_keys, 10, &pool);
+    ASSERT_EQ(2000, art_size(&t));
+    ASSERT_NE(nullptr, art_search(&t, (const unsigned char*)"a1999", 6));
+
+    art_tree_destroy(&t);
+    pool.shutdown();
+}
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include "batched_indexer.h"
+#include "config.h"
+
+static std::atomic<size_t> num_indexed_writes = 0;
+
+static bool index_write(const std::shared_ptr<http_req>& req, const std::shared_ptr<http_res>& res) {
+    num_indexed_writes++;
+    res->set_200("{}");
+    return true;
+}
+
+class BatchedIndexerTest : public ::testing::Test {
+protected:
+    Store* store;
+    Store* meta_store;
+    HttpServer* server;
+    BatchedIndexer* batched_indexer;
+    uint64_t route_hash;
+    uint64_t next_req_id = 1;
+
+    virtual void SetUp() {
+        std::string state_dir_path = "/tmp/typesense_test/batched_indexer_test";
+        LOG(INFO) << "Truncating and creating: " << state_dir_path;
+        system(("rm -rf "+state_dir_path+" && mkdir -p "+state_dir_path+"/db "+state_dir_path+"/meta").c_str());
+
+        store = new Store(state_dir_path + "/db");
+        meta_store = new Store(state_dir_path + "/meta");
+
+        server = new HttpServer("test", "127.0.0.1", 8108, "", "", 0, false, nullptr);
+        server->post("/collections/:collection/documents", index_write);
+
+        route_path* rpath = nullptr;
+        route_hash = server->find_route({"collections", "coll1", "documents"}, "POST", &rpath);
+
+        batched_indexer = new BatchedIndexer(server, store, meta_store, 1);
+        num_indexed_writes = 0;
+    }
+
+    virtual void TearDown() {
+        Config::get_instance().set_collection_write_lag(250);
+        Config::get_instance().set_collection_pending_write_bytes(512 * 1024 * 1024);
+
+        delete batched_indexer;
+        delete server;
+        delete meta_store;
+        delete store;
+    }
+
+    // enqueues a write of the given chunks, returning the number of bytes held for it
+    size_t enqueue_write(const std::string& coll_name, const std::vector<std::string>& chunks,
+                         bool complete = true) {
+        const uint64_t req_id = next_req_id++;
+        size_t num_bytes = 0;
+
+        for(size_t i = 0; i < chunks.size(); i++) {
+            std::shared_ptr<http_req> req = std::make_shared<http_req>();
+            req->route_hash = route_hash;
+            req->params["collection"] = coll_name;
+            req->body = chunks[i];
+            req->start_ts = req_id;
+            req->log_index = req_id;
+            req->last_chunk_aggregate = complete && (i == chunks.size() - 1);
+
+            num_bytes += req->to_json().size();
+            batched_indexer->enqueue(req, std::make_shared<http_res>(nullptr));
+        }
+
+        return num_bytes;
+    }
+};
+
+TEST_F(BatchedIndexerTest, ThrottlesWritesToCollectionsWithABacklog) {
+    Config::get_instance().set_collection_write_lag(2);
+    Config::get_instance().set_collection_pending_write_bytes(0);
+
+    size_t pending_bytes = 0;
+    pending_bytes += enqueue_write("coll1", {"{\"id\": \"0\"}"});
+    pending_bytes += enqueue_write("coll1", {"{\"id\": \"1\"}"});
+
+    uint32_t retry_after_seconds = 0;
+    ASSERT_TRUE(batched_indexer->is_write_admitted("coll1", retry_after_seconds));
+
+    // requests are counted, however many chunks they span
+    pending_bytes += enqueue_write("coll1", {"{\"id\": \"2\"}\n", "{\"id\": \"3\"}"});
+
+    ASSERT_FALSE(batched_indexer->is_write_admitted("coll1", retry_after_seconds));
+    ASSERT_EQ(60, retry_after_seconds);
+
+    // other collections are not held back
+    retry_after_seconds = 0;
+    ASSERT_TRUE(batched_indexer->is_write_admitted("coll2", retry_after_seconds));
+    ASSERT_EQ(0, retry_after_seconds);
+
+    nlohmann::json stats;
+    batched_indexer->get_write_stats(stats);
+    ASSERT_EQ(3, stats["coll1"]["queued_writes"].get<int64_t>());
+    ASSERT_EQ(pending_bytes, stats["coll1"]["pending_bytes"].get<int64_t>());
+    ASSERT_TRUE(stats["coll1"]["throttled"].get<bool>());
+    ASSERT_EQ(60, stats["coll1"]["retry_after_seconds"].get<uint32_t>());
+
+    // the size of the backlog is checked on its own
+    Config::get_instance().set_collection_write_lag(0);
+    Config::get_instance().set_collection_pending_write_bytes(pending_bytes);
+    ASSERT_TRUE(batched_indexer->is_write_admitted("coll1", retry_after_seconds));
+
+    Config::get_instance().set_collection_pending_write_bytes(pending_bytes - 1);
+    ASSERT_FALSE(batched_indexer->is_write_admitted("coll1", retry_after_seconds));
+
+    // chunks of a request that is still being received add to the size of the backlog, but not to the queue
+    const size_t partial_bytes = enqueue_write("coll2", {"{\"id\": \"4\"}"}, false);
+    batched_indexer->get_write_stats(stats);
+    ASSERT_EQ(0, stats["coll2"]["queued_writes"].get<int64_t>());
+    ASSERT_EQ(partial_bytes, stats["coll2"]["pending_bytes"].get<int64_t>());
+}
+
+TEST_F(BatchedIndexerTest, IndexingWritesReleasesTheThrottle) {
+    Config::get_instance().set_collection_write_lag(2);
+
+    const size_t num_writes = 10;
+    for(size_t i = 0; i < num_writes; i++) {
+        enqueue_write("coll1", {"{\"id\": \"" + std::to_string(i) + "\"}"});
+    }
+
+    uint32_t retry_after_seconds = 0;
+    ASSERT_FALSE(batched_indexer->is_write_admitted("coll1", retry_after_seconds));
+
+    std::thread indexer_thread([this]() {
+        batched_indexer->run();
+    });
+
+    nlohmann::json stats;
+
+    for(size_t i = 0; i < 100; i++) {
+        batched_indexer->get_write_stats(stats);
+        if(num_indexed_writes == num_writes && (stats.count("coll1") == 0 ||
+                                                stats["coll1"]["pending_bytes"].get<int64_t>() == 0)) {
+            break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    batched_indexer->stop();
+    indexer_thread.join();
+
+    ASSERT_EQ(num_writes, num_indexed_writes);
+    ASSERT_EQ(0, batched_indexer->get_queued_writes());
+
+    if(stats.count("coll1") != 0) {
+        ASSERT_EQ(0, stats["coll1"]["queued_writes"].get<int64_t>());
+        ASSERT_EQ(0, stats["coll1"]["pending_bytes"].get<int64_t>());
+    }
+
+    ASSERT_TRUE(batched_indexer->is_write_admitted("coll1", retry_after_seconds));
+}
+
+TEST(BatchedIndexerRetryTest, RetryAfterFollowsTheExceededBacklog) {
+    BatchedIndexer::write_stats_t stats;
+    stats.queued_writes = 300;
+    stats.writes_per_second = 10;
+    stats.pending_bytes = 50 * 1024 * 1024;
+    stats.bytes_per_second = 1024 * 1024;
+
+    // time to work the backlog down to half of its threshold
+    ASSERT_EQ(18, BatchedIndexer::get_retry_after_seconds(stats, 250, 0));
+    ASSERT_EQ(25, BatchedIndexer::get_retry_after_seconds(stats, 0, 50 * 1024 * 1024));
+
+    // the longer wait wins when both backlogs are exceeded
+    ASSERT_EQ(25, BatchedIndexer::get_retry_after_seconds(stats, 250, 50 * 1024 * 1024));
+
+    // a backlog that is not being worked on takes the longest wait
+    stats.bytes_per_second = 0;
+    ASSERT_EQ(60, BatchedIndexer::get_retry_after_seconds(stats, 0, 50 * 1024 * 1024));
+    ASSERT_EQ(18, BatchedIndexer::get_retry_after_seconds(stats, 250, 0));
+
+    // and the wait is at least a second
+    stats.writes_per_second = 1000;
+    ASSERT_EQ(1, BatchedIndexer::get_retry_after_seconds(stats, 250, 0));
+}
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <collection_manager.h>
 #include "collection.h"
+#include "config.h"
 
 class CollectionSpecificTest : public ::testing::Test {
 protected:
@@ -1984,3 +1985,453 @@ TEST_F(CollectionSpecificTest, SingleHyphenInQueryNotToBeTreatedAsExclusion) {
     ASSERT_EQ(1, results["hits"].size());
     collectionManager.drop_collection("coll1");
 }
+
+TEST_F(CollectionSpecificTest, FieldWithoutPositions) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("description", field_types::STRING, false, false, true, "", false),
+                                 field("tags", field_types::STRING_ARRAY, false, false, true, "", false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    nlohmann::json doc1;
+    doc1["id"] = "0";
+    doc1["title"] = "First";
+    doc1["description"] = "The quick brown fox was too fast.";
+    doc1["tags"] = {"alpha beta", "gamma"};
+    doc1["points"] = 100;
+
+    nlohmann::json doc2;
+    doc2["id"] = "1";
+    doc2["title"] = "Second";
+    doc2["description"] = "The fox ate a brown bird.";
+    doc2["tags"] = {"beta", "alpha"};
+    doc2["points"] = 200;
+
+    ASSERT_TRUE(coll1->add(doc1.dump()).ok());
+    ASSERT_TRUE(coll1->add(doc2.dump()).ok());
+
+    // without proximity, both documents match equally well and are ordered by points
+
+    auto results = coll1->search("brown fox", {"description"}, "", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+
+    ASSERT_EQ(2, results["found"].get<size_t>());
+    ASSERT_EQ("1", results["hits"][0]["document"]["id"].get<std::string>());
+    ASSERT_EQ("0", results["hits"][1]["document"]["id"].get<std::string>());
+    ASSERT_EQ(results["hits"][0]["text_match"].get<size_t>(), results["hits"][1]["text_match"].get<size_t>());
+
+    ASSERT_EQ(1, results["hits"][0]["highlights"].size());
+    ASSERT_EQ(2, results["hits"][0]["highlights"][0]["matched_tokens"].size());
+
+    // exact filters cannot be verified without positions, while contains filters still work
+
+    auto search_op = coll1->search("*", {}, "description:= fox brown", {}, {}, {0}, 10, 1, FREQUENCY, {false});
+    ASSERT_FALSE(search_op.ok());
+    ASSERT_EQ(400, search_op.code());
+    ASSERT_EQ("Error with filter field `description`: Exact filtering is not supported on a field indexed "
+              "without positions.", search_op.error());
+
+    results = coll1->search("*", {}, "description: fox brown", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(2, results["found"].get<size_t>());
+
+    // array elements are still identified for highlighting
+
+    results = coll1->search("gamma", {"tags"}, "", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(1, results["found"].get<size_t>());
+    ASSERT_EQ("0", results["hits"][0]["document"]["id"].get<std::string>());
+    ASSERT_EQ(1, results["hits"][0]["highlights"][0]["indices"].size());
+    ASSERT_EQ(1, results["hits"][0]["highlights"][0]["indices"][0].get<size_t>());
+
+    nlohmann::json summary = coll1->get_summary_json();
+    ASSERT_FALSE(summary["fields"][1][fields::positions].get<bool>());
+    ASSERT_LT(0, summary["fields"][1]["skipped_position_bytes"].get<size_t>());
+    ASSERT_TRUE(summary["fields"][0][fields::positions].get<bool>());
+    ASSERT_EQ(0, summary["fields"][0].count("skipped_position_bytes"));
+
+    // skipped bytes of a document are taken out again when it is updated or removed
+    const size_t skipped_bytes = summary["fields"][1]["skipped_position_bytes"].get<size_t>();
+
+    nlohmann::json update_doc;
+    update_doc["id"] = "0";
+    update_doc["description"] = "Fox fox fox fox";
+    ASSERT_TRUE(coll1->add(update_doc.dump(), UPDATE).ok());
+
+    // 4 bytes of the old value are replaced by 16 bytes of the new value: [1, 2, 3, 4, 0] is stored as [0]
+    summary = coll1->get_summary_json();
+    ASSERT_EQ(skipped_bytes + 12, summary["fields"][1]["skipped_position_bytes"].get<size_t>());
+
+    ASSERT_TRUE(coll1->remove("0").ok());
+    ASSERT_TRUE(coll1->remove("1").ok());
+
+    summary = coll1->get_summary_json();
+    ASSERT_EQ(0, summary["fields"][1]["skipped_position_bytes"].get<size_t>());
+    ASSERT_EQ(0, summary["fields"][2]["skipped_position_bytes"].get<size_t>());
+
+    collectionManager.drop_collection("coll1");
+
+    // positions can only be dropped from string fields
+
+    nlohmann::json fields_json = nlohmann::json::array();
+    fields_json.push_back({{fields::name, "points"}, {fields::type, field_types::INT32}, {fields::positions, false}});
+
+    std::string fallback_field_type;
+    std::vector<field> parsed_fields;
+    auto parse_op = field::json_fields_to_fields(fields_json, fallback_field_type, parsed_fields);
+
+    ASSERT_FALSE(parse_op.ok());
+    ASSERT_EQ(400, parse_op.code());
+    ASSERT_EQ("The `positions` property of the field `points` can only be disabled on a string field.",
+              parse_op.error());
+
+    fields_json[0][fields::type] = field_types::STRING_ARRAY;
+    parse_op = field::json_fields_to_fields(fields_json, fallback_field_type, parsed_fields);
+    ASSERT_TRUE(parse_op.ok());
+    ASSERT_FALSE(parsed_fields[0].positions);
+}
+
+TEST_F(CollectionSpecificTest, HighlightDeepMatchOnFieldWithoutPositions) {
+    std::vector<field> fields = {field("description", field_types::STRING, false, false, true, "", false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    // the only matching token lies well past the snippet threshold
+    std::vector<std::string> words;
+    for(size_t i = 0; i < 40; i++) {
+        words.push_back("w" + std::to_string(i));
+    }
+
+    words.push_back("zebra");
+
+    for(size_t i = 40; i < 50; i++) {
+        words.push_back("w" + std::to_string(i));
+    }
+
+    nlohmann::json doc;
+    doc["id"] = "0";
+    doc["description"] = StringUtils::join(words, " ");
+    doc["points"] = 100;
+    ASSERT_TRUE(coll1->add(doc.dump()).ok());
+
+    auto results = coll1->search("zebra", {"description"}, "", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+
+    ASSERT_EQ(1, results["found"].get<size_t>());
+    ASSERT_EQ(1, results["hits"][0]["highlights"].size());
+    ASSERT_EQ("w36 w37 w38 w39 <mark>zebra</mark> w40 w41 w42 w43",
+              results["hits"][0]["highlights"][0]["snippet"].get<std::string>());
+    ASSERT_EQ(1, results["hits"][0]["highlights"][0]["matched_tokens"].size());
+    ASSERT_EQ("zebra", results["hits"][0]["highlights"][0]["matched_tokens"][0].get<std::string>());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionSpecificTest, SuggestFromFieldValues) {
+    std::vector<field> fields = {field("title", field_types::STRING, false, false, true, "", true, true),
+                                 field("tags", field_types::STRING_ARRAY, false, false, true, "", true, true),
+                                 field("description", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    std::vector<std::pair<std::string, std::vector<std::string>>> records = {
+        {"The Lion King", {"Animation", "Musical"}},
+        {"The Lion King", {"Musical"}},
+        {"The Last Samurai", {"Action"}},
+        {"Toy Story", {"Animation"}},
+    };
+
+    for(size_t i = 0; i < records.size(); i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["title"] = records[i].first;
+        doc["tags"] = records[i].second;
+        doc["description"] = "";
+        doc["points"] = 100;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    auto results = coll1->suggest("title", "the L").get();
+    ASSERT_EQ(2, results["suggestions"].size());
+    ASSERT_EQ("the lion king", results["suggestions"][0]["text"].get<std::string>());
+    ASSERT_EQ(2, results["suggestions"][0]["weight"].get<size_t>());
+    ASSERT_EQ("the last samurai", results["suggestions"][1]["text"].get<std::string>());
+
+    results = coll1->suggest("tags", "anim").get();
+    ASSERT_EQ(1, results["suggestions"].size());
+    ASSERT_EQ("animation", results["suggestions"][0]["text"].get<std::string>());
+    ASSERT_EQ(2, results["suggestions"][0]["weight"].get<size_t>());
+
+    results = coll1->suggest("title", "tpy", 1).get();
+    ASSERT_EQ(1, results["suggestions"].size());
+    ASSERT_EQ("toy story", results["suggestions"][0]["text"].get<std::string>());
+    ASSERT_EQ(1, results["suggestions"][0]["typos"].get<size_t>());
+
+    // removed documents no longer contribute
+    ASSERT_TRUE(coll1->remove("0").ok());
+    ASSERT_TRUE(coll1->remove("1").ok());
+
+    results = coll1->suggest("title", "the l").get();
+    ASSERT_EQ(1, results["suggestions"].size());
+    ASSERT_EQ("the last samurai", results["suggestions"][0]["text"].get<std::string>());
+
+    auto res_op = coll1->suggest("description", "a");
+    ASSERT_FALSE(res_op.ok());
+    ASSERT_EQ("Field `description` is not enabled for suggestions.", res_op.error());
+
+    res_op = coll1->suggest("unknown", "a");
+    ASSERT_FALSE(res_op.ok());
+    ASSERT_EQ(404, res_op.code());
+
+    nlohmann::json summary = coll1->get_summary_json();
+    ASSERT_TRUE(summary["fields"][0][fields::suggest].get<bool>());
+    ASSERT_FALSE(summary["fields"][2][fields::suggest].get<bool>());
+
+    collectionManager.drop_collection("coll1");
+
+    // only string fields can be suggested from
+
+    nlohmann::json fields_json = nlohmann::json::array();
+    fields_json.push_back({{fields::name, "points"}, {fields::type, field_types::INT32}, {fields::suggest, true}});
+
+    std::string fallback_field_type;
+    std::vector<field> parsed_fields;
+    auto parse_op = field::json_fields_to_fields(fields_json, fallback_field_type, parsed_fields);
+
+    ASSERT_FALSE(parse_op.ok());
+    ASSERT_EQ(400, parse_op.code());
+    ASSERT_EQ("The `suggest` property of the field `points` can only be enabled on a string field.",
+              parse_op.error());
+}
+
+TEST_F(CollectionSpecificTest, InfixSearchOnField) {
+    std::vector<field> fields = {field("sku", field_types::STRING, false, false, true, "", true, false, true),
+                                 field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    std::vector<std::pair<std::string, std::string>> records = {
+        {"AB-4500X-R", "Power drill"},
+        {"CD-4500X", "Hammer drill"},
+        {"AB-4501X-R", "Impact driver"},
+    };
+
+    for(size_t i = 0; i < records.size(); i++) {
+        nlohmann::json doc;
+        doc["id"] = std::to_string(i);
+        doc["sku"] = records[i].first;
+        doc["title"] = records[i].second;
+        doc["points"] = i;
+        ASSERT_TRUE(coll1->add(doc.dump()).ok());
+    }
+
+    auto results = coll1->search("4500x", {"sku"}, "", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(2, results["found"].get<size_t>());
+    ASSERT_EQ("1", results["hits"][0]["document"]["id"].get<std::string>());
+    ASSERT_EQ("0", results["hits"][1]["document"]["id"].get<std::string>());
+
+    // fields without the option only match on whole tokens and prefixes
+    results = coll1->search("rill", {"title"}, "", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(0, results["found"].get<size_t>());
+
+    results = coll1->search("4500x", {"sku"}, "points: >0", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(1, results["found"].get<size_t>());
+    ASSERT_EQ("1", results["hits"][0]["document"]["id"].get<std::string>());
+
+    ASSERT_TRUE(coll1->remove("1").ok());
+
+    results = coll1->search("4500x", {"sku"}, "", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(1, results["found"].get<size_t>());
+    ASSERT_EQ("0", results["hits"][0]["document"]["id"].get<std::string>());
+
+    nlohmann::json summary = coll1->get_summary_json();
+    ASSERT_TRUE(summary["fields"][0][fields::infix].get<bool>());
+    ASSERT_FALSE(summary["fields"][1][fields::infix].get<bool>());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionSpecificTest, InfixOnlyOnStringFields) {
+    nlohmann::json schema;
+    schema["name"] = "coll1";
+    schema["fields"] = nlohmann::json::array();
+    schema["fields"][0]["name"] = "sku";
+    schema["fields"][0]["type"] = "string";
+    schema["fields"][0]["infix"] = true;
+    schema["fields"][1]["name"] = "points";
+    schema["fields"][1]["type"] = "int32";
+    schema["fields"][1]["infix"] = true;
+
+    auto coll_op = collectionManager.create_collection(schema);
+    ASSERT_FALSE(coll_op.ok());
+    ASSERT_EQ(400, coll_op.code());
+    ASSERT_EQ("The `infix` property of the field `points` can only be enabled on a string field.", coll_op.error());
+    ASSERT_EQ(nullptr, collectionManager.get_collection("coll1").get());
+
+    schema["fields"][1]["infix"] = false;
+    coll_op = collectionManager.create_collection(schema);
+    ASSERT_TRUE(coll_op.ok());
+    ASSERT_TRUE(coll_op.get()->get_schema().at("sku").infix);
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionSpecificTest, ParseStoredDocumentKeepsOnlyIndexedFields) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    const std::string json_str = R"({"id": "0", "title": "Power drill", "points": 10,
+                                    "notes": {"tags": ["a", "b"]}, "extra": "value"})";
+
+    nlohmann::json document;
+    ASSERT_TRUE(coll1->parse_doc_for_indexing(json_str.data(), json_str.size(), document).ok());
+
+    ASSERT_EQ(3, document.size());
+    ASSERT_EQ("0", document["id"].get<std::string>());
+    ASSERT_EQ("Power drill", document["title"].get<std::string>());
+    ASSERT_EQ(10, document["points"].get<int32_t>());
+
+    const std::string bad_json_str = R"({"title": "Power drill", )";
+    ASSERT_FALSE(coll1->parse_doc_for_indexing(bad_json_str.data(), bad_json_str.size(), document).ok());
+
+    collectionManager.drop_collection("coll1");
+
+    // with dynamic fields, any field of the document can be indexed
+    fields = {field("title", field_types::STRING, false),
+              field(".*_notes", field_types::STRING, false, true),
+              field("points", field_types::INT32, false),};
+
+    coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    ASSERT_TRUE(coll1->parse_doc_for_indexing(json_str.data(), json_str.size(), document).ok());
+    ASSERT_EQ(5, document.size());
+
+    collectionManager.drop_collection("coll1");
+}
+
+TEST_F(CollectionSpecificTest, RemoveAndUpdateWithForwardIndex) {
+    Config::get_instance().set_enable_forward_index(true);
+
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("tags", field_types::STRING_ARRAY, true),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    nlohmann::json doc;
+    doc["id"] = "0";
+    doc["title"] = "The quick brown fox";
+    doc["tags"] = {"animal", "forest"};
+    doc["points"] = 10;
+    ASSERT_TRUE(coll1->add(doc.dump()).ok());
+
+    doc["id"] = "1";
+    doc["title"] = "The lazy dog";
+    doc["tags"] = {"animal"};
+    doc["points"] = 20;
+    ASSERT_TRUE(coll1->add(doc.dump()).ok());
+
+    // update replaces the tokens of the changed field only
+    nlohmann::json update_doc;
+    update_doc["id"] = "0";
+    update_doc["title"] = "The quick red fox";
+    ASSERT_TRUE(coll1->add(update_doc.dump(), UPDATE).ok());
+
+    auto results = coll1->search("brown", {"title"}, "", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(0, results["found"].get<size_t>());
+
+    results = coll1->search("red", {"title"}, "", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(1, results["found"].get<size_t>());
+
+    results = coll1->search("forest", {"tags"}, "", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(1, results["found"].get<size_t>());
+
+    ASSERT_TRUE(coll1->remove("0").ok());
+
+    results = coll1->search("fox", {"title"}, "", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(0, results["found"].get<size_t>());
+
+    results = coll1->search("forest", {"tags"}, "", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(0, results["found"].get<size_t>());
+
+    results = coll1->search("the", {"title"}, "", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(1, results["found"].get<size_t>());
+    ASSERT_EQ("1", results["hits"][0]["document"]["id"].get<std::string>());
+
+    collectionManager.drop_collection("coll1");
+
+    // fields that are added to the schema on the fly are tracked as well
+    fields = {field(".*", field_types::AUTO, false, true)};
+    coll1 = collectionManager.create_collection("coll1", 1, fields, "", 0, field_types::AUTO).get();
+
+    doc = nlohmann::json::object();
+    doc["id"] = "0";
+    doc["title"] = "The quick brown fox";
+    ASSERT_TRUE(coll1->add(doc.dump()).ok());
+
+    update_doc["title"] = "The quick red fox";
+    ASSERT_TRUE(coll1->add(update_doc.dump(), UPDATE).ok());
+
+    results = coll1->search("brown", {"title"}, "", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(0, results["found"].get<size_t>());
+
+    ASSERT_TRUE(coll1->remove("0").ok());
+
+    results = coll1->search("red", {"title"}, "", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(0, results["found"].get<size_t>());
+
+    collectionManager.drop_collection("coll1");
+    Config::get_instance().set_enable_forward_index(false);
+}
+
+TEST_F(CollectionSpecificTest, AddBatchReturnsOutcomePerDocument) {
+    std::vector<field> fields = {field("title", field_types::STRING, false),
+                                 field("points", field_types::INT32, false),};
+
+    Collection* coll1 = collectionManager.create_collection("coll1", 1, fields, "points").get();
+
+    nlohmann::json doc;
+    doc["id"] = "0";
+    doc["title"] = "The quick brown fox";
+    doc["points"] = 10;
+
+    nlohmann::json bad_doc;
+    bad_doc["id"] = "1";
+    bad_doc["title"] = "The lazy dog";
+    bad_doc["points"] = "twenty";
+
+    nlohmann::json repeated_doc;
+    repeated_doc["id"] = "0";
+    repeated_doc["title"] = "The quick red fox";
+    repeated_doc["points"] = 30;
+
+    std::vector<std::string> json_strs = {doc.dump(), bad_doc.dump(), "{\"title\": ", repeated_doc.dump()};
+    std::vector<Option<nlohmann::json>> results;
+    coll1->add_batch(json_strs, results, UPSERT);
+
+    ASSERT_EQ(4, results.size());
+
+    ASSERT_TRUE(results[0].ok());
+    ASSERT_EQ("The quick brown fox", results[0].get()["title"].get<std::string>());
+
+    ASSERT_FALSE(results[1].ok());
+    ASSERT_EQ(400, results[1].code());
+    ASSERT_EQ("Field `points` must be an int32.", results[1].error());
+
+    ASSERT_FALSE(results[2].ok());
+    ASSERT_EQ(400, results[2].code());
+
+    // a repeated document is written after the ones before it, as with separate writes
+    ASSERT_TRUE(results[3].ok());
+    ASSERT_EQ("The quick red fox", results[3].get()["title"].get<std::string>());
+
+    ASSERT_EQ(1, coll1->get_num_documents());
+
+    auto res = coll1->search("red", {"title"}, "", {}, {}, {0}, 10, 1, FREQUENCY, {false}).get();
+    ASSERT_EQ(1, res["found"].get<size_t>());
+    ASSERT_EQ(30, res["hits"][0]["document"]["points"].get<int32_t>());
+
+    collectionManager.drop_collection("coll1");
+}
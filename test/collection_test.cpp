@@ -1535,6 +1535,60 @@ TEST_F(CollectionTest, ImportDocuments) {
     collectionManager.drop_collection("coll_mul_fields");
 }
 
+TEST_F(CollectionTest, ImportManyDocumentsAcrossParseBatches) {
+    std::vector<field> fields = {
+        field("title", field_types::STRING, false),
+        field("points", field_types::INT32, false)
+    };
+
+    Collection* coll1 = collectionManager.create_collection("coll_many", 4, fields, "points").get();
+
+    // spans several index batches: every 7th record is malformed and every 11th repeats the previous ID
+    std::vector<std::string> records;
+    size_t num_expected = 0;
+
+    for(size_t i = 0; i < 2500; i++) {
+        if(i % 7 == 0) {
+            records.push_back("{\"title\": \"Malformed " + std::to_string(i) + "\"");
+            continue;
+        }
+
+        const size_t doc_id = (i % 11 == 0) ? i - 1 : i;
+        if(i % 11 != 0 || (i - 1) % 7 == 0) {
+            num_expected++;
+        }
+
+        records.push_back("{\"id\": \"" + std::to_string(doc_id) + "\", \"title\": \"Title " + std::to_string(i) +
+                          "\", \"points\": " + std::to_string(i) + "}");
+    }
+
+    nlohmann::json document;
+    nlohmann::json import_response = coll1->add_many(records, document);
+    ASSERT_FALSE(import_response["success"].get<bool>());
+    ASSERT_EQ(num_expected, import_response["num_imported"].get<size_t>());
+
+    std::vector<nlohmann::json> import_results = import_res_to_json(records);
+    ASSERT_EQ(2500, import_results.size());
+
+    for(size_t i = 0; i < import_results.size(); i++) {
+        if(i % 7 == 0) {
+            ASSERT_FALSE(import_results[i]["success"].get<bool>());
+            ASSERT_EQ(400, import_results[i]["code"].get<size_t>());
+            ASSERT_EQ("{\"title\": \"Malformed " + std::to_string(i) + "\"",
+                      import_results[i]["document"].get<std::string>());
+        } else if(i % 11 == 0 && (i - 1) % 7 != 0) {
+            ASSERT_FALSE(import_results[i]["success"].get<bool>());
+            ASSERT_EQ(409, import_results[i]["code"].get<size_t>());
+        } else {
+            ASSERT_TRUE(import_results[i]["success"].get<bool>());
+        }
+    }
+
+    ASSERT_EQ(num_expected, coll1->get_num_documents());
+
+    collectionManager.drop_collection("coll_many");
+}
+
 TEST_F(CollectionTest, SearchingWithMissingFields) {
     // return error without crashing when searching for fields that do not conform to the schema
     Collection *coll_array_fields;
@@ -30,6 +30,8 @@ TEST(ConfigTest, LoadCmdLineArguments) {
         "--data-dir=/tmp/data",
         "--api-key=abcd",
         "--listen-port=8080",
+        "--collection-write-lag=100",
+        "--topk-cache-prefix-len=3",
     };
 
     std::vector<char*> argv = get_argv(args);
@@ -43,6 +45,9 @@ TEST(ConfigTest, LoadCmdLineArguments) {
     ASSERT_EQ("abcd", config.get_api_key());
     ASSERT_EQ(8080, config.get_api_port());
     ASSERT_EQ("/tmp/data", config.get_data_dir());
+    ASSERT_EQ(100, config.get_collection_write_lag());
+    ASSERT_EQ(512 * 1024 * 1024, config.get_collection_pending_write_bytes());
+    ASSERT_EQ(3, config.get_topk_cache_prefix_len());
 }
 
 TEST(ConfigTest, LoadEnvVars) {
@@ -63,6 +63,103 @@ TEST(IndexTest, ScrubReindexDoc) {
     pool.shutdown();
 }
 
+TEST(IndexTest, ValidateDocumentWithCompiledPlan) {
+    std::unordered_map<std::string, field> search_schema;
+    search_schema.emplace("id", field("id", field_types::STRING, false));
+    search_schema.emplace("title", field("title", field_types::STRING, false));
+    search_schema.emplace("points", field("points", field_types::INT32, false));
+    search_schema.emplace("tags", field("tags", field_types::STRING_ARRAY, false, true));
+    search_schema.emplace("location", field("location", field_types::GEOPOINT, false));
+
+    validation_plan_t validation_plan;
+    Index::compile_validation_plan(search_schema, validation_plan);
+    ASSERT_EQ(4, validation_plan.field_checks.size());
+
+    nlohmann::json doc;
+    doc["id"] = "0";
+    doc["title"] = "Tom Sawyer";
+    doc["points"] = "100";
+    doc["tags"] = {1, "adventure"};
+    doc["location"] = {48.85, 2.35};
+
+    auto validate_op = Index::validate_index_in_memory(doc, 0, "", validation_plan, {}, CREATE, "",
+                                                       DIRTY_VALUES::COERCE_OR_REJECT);
+    ASSERT_TRUE(validate_op.ok());
+    ASSERT_EQ(100, doc["points"].get<int32_t>());
+    ASSERT_EQ("1", doc["tags"][0].get<std::string>());
+
+    // errors are those of the type of the field
+    nlohmann::json bad_doc = doc;
+    bad_doc["location"] = nlohmann::json::array({48.85});
+    validate_op = Index::validate_index_in_memory(bad_doc, 0, "", validation_plan, {}, CREATE, "",
+                                                  DIRTY_VALUES::COERCE_OR_REJECT);
+    ASSERT_FALSE(validate_op.ok());
+    ASSERT_EQ("Field `location` must be a 2 element array: [lat, lng].", validate_op.error());
+
+    bad_doc = doc;
+    bad_doc.erase("points");
+    validate_op = Index::validate_index_in_memory(bad_doc, 0, "", validation_plan, {}, CREATE, "",
+                                                  DIRTY_VALUES::COERCE_OR_REJECT);
+    ASSERT_FALSE(validate_op.ok());
+    ASSERT_EQ("Field `points` has been declared in the schema, but is not found in the document.", validate_op.error());
+
+    validate_op = Index::validate_index_in_memory(bad_doc, 0, "", validation_plan, {}, UPDATE, "",
+                                                  DIRTY_VALUES::COERCE_OR_REJECT);
+    ASSERT_TRUE(validate_op.ok());
+
+    // values of an optional field are dropped when asked to
+    bad_doc = doc;
+    bad_doc["tags"] = "adventure";
+    validate_op = Index::validate_index_in_memory(bad_doc, 0, "", validation_plan, {}, CREATE, "",
+                                                  DIRTY_VALUES::COERCE_OR_REJECT);
+    ASSERT_FALSE(validate_op.ok());
+    ASSERT_EQ("Field `tags` must be an array.", validate_op.error());
+
+    validate_op = Index::validate_index_in_memory(bad_doc, 0, "", validation_plan, {}, CREATE, "",
+                                                  DIRTY_VALUES::COERCE_OR_DROP);
+    ASSERT_TRUE(validate_op.ok());
+    ASSERT_EQ(0, bad_doc.count("tags"));
+
+    bad_doc = doc;
+    bad_doc["tags"] = nlohmann::json::array({"adventure", nlohmann::json::object()});
+    validate_op = Index::validate_index_in_memory(bad_doc, 0, "", validation_plan, {}, CREATE, "",
+                                                  DIRTY_VALUES::DROP);
+    ASSERT_TRUE(validate_op.ok());
+    ASSERT_EQ(1, bad_doc["tags"].size());
+}
+
+TEST(IndexTest, CachedTokenizationMatchesUncached) {
+    std::unordered_map<std::string, field> search_schema;
+    search_schema.emplace("brand", field("brand", field_types::STRING, true));
+    search_schema.emplace("colors", field("colors", field_types::STRING_ARRAY, true));
+
+    std::map<std::string, field> facet_schema;
+    facet_schema.emplace("brand", field("brand", field_types::STRING, true));
+    facet_schema.emplace("colors", field("colors", field_types::STRING_ARRAY, true));
+
+    nlohmann::json doc;
+    doc["brand"] = "Acme Corp";
+    doc["colors"] = nlohmann::json::array({"dark red", "blue", "dark red"});
+
+    tokenization_cache_t tokenization_cache;
+
+    for(size_t i = 0; i < 2; i++) {
+        index_record cached_rec(0, i, doc, CREATE, DIRTY_VALUES::COERCE_OR_REJECT);
+        Index::compute_token_offsets_facets(cached_rec, search_schema, facet_schema, {}, {}, &tokenization_cache);
+
+        index_record rec(0, i, doc, CREATE, DIRTY_VALUES::COERCE_OR_REJECT);
+        Index::compute_token_offsets_facets(rec, search_schema, facet_schema, {}, {});
+
+        for(const auto& field_name: {"brand", "colors"}) {
+            ASSERT_EQ(rec.field_index[field_name].offsets, cached_rec.field_index[field_name].offsets);
+            ASSERT_EQ(rec.field_index[field_name].facet_hashes, cached_rec.field_index[field_name].facet_hashes);
+        }
+    }
+
+    ASSERT_EQ(1, tokenization_cache["brand"].size());
+    ASSERT_EQ(2, tokenization_cache["colors"].size());
+}
+
 /*TEST(IndexTest, PointInPolygon180thMeridian) {
     // somewhere in far eastern russia
     GeoCoord verts[3] = {
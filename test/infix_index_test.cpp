@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include "infix_index.h"
+
+TEST(InfixIndexTest, FindsTokensContainingInfix) {
+    infix_index_t index;
+    index.add("ab4500xr");
+    index.add("ab4501xr");
+    index.add("x4500");
+    index.add("cd4500xz");
+    index.add("ab");        // shorter than an n-gram
+
+    ASSERT_EQ(4, index.num_tokens());
+
+    std::vector<std::string> matched_tokens;
+    index.search("4500x", matched_tokens);
+    std::sort(matched_tokens.begin(), matched_tokens.end());
+
+    ASSERT_EQ(2, matched_tokens.size());
+    ASSERT_EQ("ab4500xr", matched_tokens[0]);
+    ASSERT_EQ("cd4500xz", matched_tokens[1]);
+
+    // all n-grams of the infix occur in the token, but not contiguously
+    matched_tokens.clear();
+    index.search("450x", matched_tokens);
+    ASSERT_EQ(0, matched_tokens.size());
+
+    matched_tokens.clear();
+    index.search("45", matched_tokens);
+    ASSERT_EQ(0, matched_tokens.size());
+
+    // adding a token twice is a no-op
+    index.add("x4500");
+    ASSERT_EQ(4, index.num_tokens());
+
+    index.remove("ab4500xr");
+    matched_tokens.clear();
+    index.search("4500x", matched_tokens);
+    ASSERT_EQ(1, matched_tokens.size());
+    ASSERT_EQ("cd4500xz", matched_tokens[0]);
+
+    // the freed token ID is reused
+    index.add("zz4500xx");
+    matched_tokens.clear();
+    index.search("4500x", matched_tokens);
+    std::sort(matched_tokens.begin(), matched_tokens.end());
+    ASSERT_EQ(2, matched_tokens.size());
+    ASSERT_EQ("zz4500xx", matched_tokens[1]);
+
+    index.remove("ab4501xr");
+    index.remove("x4500");
+    index.remove("cd4500xz");
+    index.remove("zz4500xx");
+    ASSERT_EQ(0, index.num_tokens());
+    ASSERT_EQ(0, index.num_ngrams());
+}
+
+TEST(InfixIndexTest, LongTokensAreNotIndexed) {
+    infix_index_t index(3, 8);
+    index.add("abcdefgh");
+    index.add("abcdefghi");
+
+    ASSERT_EQ(1, index.num_tokens());
+
+    std::vector<std::string> matched_tokens;
+    index.search("cde", matched_tokens);
+    ASSERT_EQ(1, matched_tokens.size());
+    ASSERT_EQ("abcdefgh", matched_tokens[0]);
+}
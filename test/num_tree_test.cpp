@@ -42,3 +42,154 @@ TEST(NumTreeTest, Searches) {
     delete [] ids;
     ids = nullptr;
 }
+
+TEST(NumTreeTest, SearchesAcrossLeaves) {
+    num_tree_t tree;
+
+    // values spanning multiple leaves, with every 3rd document sharing its value with the previous one
+    for(uint32_t id = 0; id < 2000; id++) {
+        int64_t value = (id % 3 == 2) ? int64_t(id - 1) * 10 : int64_t(id) * 10;
+        tree.insert(value, id);
+    }
+
+    ASSERT_EQ(1334, tree.size());
+
+    uint32_t* ids = nullptr;
+    size_t ids_len = 0;
+
+    tree.range_inclusive_search(100, 5000, &ids, ids_len);
+    ASSERT_EQ(491, ids_len);
+    ASSERT_EQ(10, ids[0]);
+    ASSERT_EQ(500, ids[ids_len-1]);
+    for(size_t i = 1; i < ids_len; i++) {
+        ASSERT_LT(ids[i-1], ids[i]);
+    }
+    delete [] ids;
+    ids = nullptr;
+
+    tree.search(NUM_COMPARATOR::GREATER_THAN, 19980, &ids, ids_len);
+    ASSERT_EQ(1, ids_len);
+    ASSERT_EQ(1999, ids[0]);
+    delete [] ids;
+    ids = nullptr;
+
+    tree.search(NUM_COMPARATOR::GREATER_THAN_EQUALS, 19980, &ids, ids_len);
+    ASSERT_EQ(2, ids_len);
+    ASSERT_EQ(1998, ids[0]);
+    ASSERT_EQ(1999, ids[1]);
+    delete [] ids;
+    ids = nullptr;
+
+    tree.search(NUM_COMPARATOR::LESS_THAN, 30, &ids, ids_len);
+    ASSERT_EQ(3, ids_len);
+    delete [] ids;
+    ids = nullptr;
+
+    tree.search(NUM_COMPARATOR::EQUALS, 40, &ids, ids_len);
+    ASSERT_EQ(2, ids_len);
+    ASSERT_EQ(4, ids[0]);
+    ASSERT_EQ(5, ids[1]);
+    delete [] ids;
+    ids = nullptr;
+
+    // results must be OR-ed with existing IDs
+    ids = new uint32_t[2]{3, 2500};
+    ids_len = 2;
+    tree.search(NUM_COMPARATOR::EQUALS, 40, &ids, ids_len);
+    ASSERT_EQ(4, ids_len);
+    ASSERT_EQ(3, ids[0]);
+    ASSERT_EQ(4, ids[1]);
+    ASSERT_EQ(5, ids[2]);
+    ASSERT_EQ(2500, ids[3]);
+    delete [] ids;
+    ids = nullptr;
+
+    for(uint32_t id = 0; id < 2000; id += 2) {
+        int64_t value = (id % 3 == 2) ? int64_t(id - 1) * 10 : int64_t(id) * 10;
+        tree.remove(value, id);
+    }
+
+    tree.search(NUM_COMPARATOR::LESS_THAN_EQUALS, 19990, &ids, ids_len);
+    ASSERT_EQ(1000, ids_len);
+    for(size_t i = 0; i < ids_len; i++) {
+        ASSERT_EQ(i*2 + 1, ids[i]);
+    }
+    delete [] ids;
+    ids = nullptr;
+
+    std::vector<uint32_t> geo_result_ids;
+    ASSERT_EQ(1, tree.get(40, geo_result_ids));
+    ASSERT_EQ(5, geo_result_ids[0]);
+}
+
+TEST(NumTreeTest, SparseRangeSearch) {
+    num_tree_t tree;
+
+    for(uint32_t id = 0; id < 500; id++) {
+        tree.insert(-int64_t(id), id * 100000);
+    }
+
+    uint32_t* ids = nullptr;
+    size_t ids_len = 0;
+
+    tree.range_inclusive_search(-499, -400, &ids, ids_len);
+    ASSERT_EQ(100, ids_len);
+    ASSERT_EQ(400 * 100000, ids[0]);
+    ASSERT_EQ(499 * 100000, ids[99]);
+    for(size_t i = 1; i < ids_len; i++) {
+        ASSERT_LT(ids[i-1], ids[i]);
+    }
+
+    delete [] ids;
+}
+
+TEST(NumTreeTest, RangeSearchWithZoneBlocks) {
+    num_tree_t tree;
+
+    // value order tracks ID order, like a `created_at` field
+    for(uint32_t id = 0; id < 20000; id++) {
+        tree.insert(1000000 + id * 2, id);
+    }
+
+    uint32_t* ids = nullptr;
+    size_t ids_len = 0;
+
+    tree.range_inclusive_search(1000000 + 5000 * 2, 1000000 + 15000 * 2 - 1, &ids, ids_len);
+    ASSERT_EQ(10000, ids_len);
+    for(size_t i = 0; i < ids_len; i++) {
+        ASSERT_EQ(5000 + i, ids[i]);
+    }
+    delete [] ids;
+    ids = nullptr;
+
+    tree.search(NUM_COMPARATOR::GREATER_THAN, 1000000 + 19990 * 2, &ids, ids_len);
+    ASSERT_EQ(9, ids_len);
+    ASSERT_EQ(19991, ids[0]);
+    delete [] ids;
+    ids = nullptr;
+
+    // removals within a block must not be returned even though the block is fully within range
+    tree.remove(1000000 + 100 * 2, 100);
+    tree.remove(1000000 + 4200 * 2, 4200);
+
+    tree.search(NUM_COMPARATOR::LESS_THAN, 1000000 + 8192 * 2, &ids, ids_len);
+    ASSERT_EQ(8190, ids_len);
+    ASSERT_EQ(99, ids[99]);
+    ASSERT_EQ(101, ids[100]);
+    ASSERT_EQ(8191, ids[ids_len-1]);
+    delete [] ids;
+    ids = nullptr;
+
+    // block with an out-of-order value becomes a boundary block
+    tree.insert(10, 12000);
+    tree.range_inclusive_search(0, 1000000 + 12288 * 2 - 1, &ids, ids_len);
+    ASSERT_EQ(12286, ids_len);
+    ASSERT_EQ(12287, ids[ids_len-1]);
+    delete [] ids;
+    ids = nullptr;
+
+    tree.range_inclusive_search(0, 100, &ids, ids_len);
+    ASSERT_EQ(1, ids_len);
+    ASSERT_EQ(12000, ids[0]);
+    delete [] ids;
+}
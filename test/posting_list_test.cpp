@@ -814,6 +814,92 @@ TEST_F(PostingListTest, ResultsAndOffsetsBasics) {
     */
 }
 
+TEST_F(PostingListTest, PlainOffsetsIntoReusableBuffer) {
+    // last offset `0` marks the token as the last token of the document
+    std::vector<uint32_t> offsets1 = {1, 2, 4};
+    std::vector<uint32_t> offsets2 = {5, 6, 0};
+
+    posting_list_t p1(2);
+    p1.upsert(0, offsets1);
+    p1.upsert(3, offsets1);
+    p1.upsert(7, offsets2);
+
+    posting_list_t p2(2);
+    p2.upsert(3, offsets2);
+    p2.upsert(7, offsets1);
+
+    std::vector<posting_list_t::iterator_t> its;
+    its.push_back(p1.new_iterator());
+    its.push_back(p2.new_iterator());
+
+    doc_token_positions_t doc_token_positions;
+
+    for(uint32_t id: {3, 7}) {
+        its[0].skip_to(id);
+        its[1].skip_to(id);
+
+        std::unordered_map<size_t, std::vector<token_positions_t>> array_token_positions;
+        posting_list_t::get_offsets(its, array_token_positions);
+        posting_list_t::get_offsets(its, doc_token_positions);
+
+        const auto& expected_positions = array_token_positions[0];
+        ASSERT_EQ(expected_positions.size(), doc_token_positions.tokens.size());
+
+        for(size_t i = 0; i < expected_positions.size(); i++) {
+            const auto& token = doc_token_positions.tokens[i];
+            ASSERT_EQ(expected_positions[i].last_token, token.last_token);
+            ASSERT_EQ(expected_positions[i].positions,
+                      std::vector<uint16_t>(token.positions.data, token.positions.data + token.positions.size()));
+        }
+
+        auto expected_match = Match(id, expected_positions, true, true);
+        auto match = Match(id, doc_token_positions, true, true);
+        ASSERT_EQ(expected_match.words_present, match.words_present);
+        ASSERT_EQ(expected_match.distance, match.distance);
+        ASSERT_EQ(expected_match.exact_match, match.exact_match);
+    }
+
+    ASSERT_EQ(2, doc_token_positions.tokens.size());
+    ASSERT_TRUE(doc_token_positions.tokens[0].last_token);
+    ASSERT_FALSE(doc_token_positions.tokens[1].last_token);
+}
+
+TEST_F(PostingListTest, IteratorOffsetsAcrossBlocks) {
+    posting_list_t list(2);
+
+    for(uint32_t id = 0; id < 10; id++) {
+        std::vector<uint32_t> offsets = {id * 3, id * 3 + 1};
+        list.upsert(id, offsets);
+    }
+
+    // every block holds two IDs, so the index of an ID within its block is `id % 2`
+    ASSERT_EQ(5, list.num_blocks());
+
+    posting_list_t::iterator_t it = list.new_iterator();
+
+    // offsets must follow the iterator through `next()` and `skip_to()`, whether or not they were read before
+    for(uint32_t expected_id: {0, 1, 2}) {
+        ASSERT_TRUE(it.valid());
+        ASSERT_EQ(expected_id, it.id());
+        ASSERT_EQ(expected_id * 3, it.get_offsets()[it.get_offset_index()[it.id() % 2]]);
+        it.next();
+    }
+
+    it.skip_to(7);
+    ASSERT_TRUE(it.valid());
+    ASSERT_EQ(7, it.id());
+    ASSERT_EQ(21, it.get_offsets()[it.get_offset_index()[it.id() % 2]]);
+    ASSERT_EQ(22, it.get_offsets()[it.get_offset_index()[it.id() % 2] + 1]);
+
+    it.next();
+    it.skip_to(9);
+    ASSERT_EQ(9, it.id());
+    ASSERT_EQ(27, it.get_offsets()[it.get_offset_index()[it.id() % 2]]);
+
+    it.next();
+    ASSERT_FALSE(it.valid());
+}
+
 TEST_F(PostingListTest, IntersectionSkipBlocks) {
     std::vector<uint32_t> offsets = {0, 1, 3};
     std::vector<posting_list_t*> lists;
@@ -865,6 +951,129 @@ TEST_F(PostingListTest, IntersectionSkipBlocks) {
     delete [] final_results;
 }
 
+TEST_F(PostingListTest, SkipIndexFollowsUpsertsAndErases) {
+    posting_list_t list(4);
+    std::vector<uint32_t> offsets = {0};
+
+    for(uint32_t id = 0; id < 200; id += 2) {
+        list.upsert(id, offsets);
+    }
+
+    // fill in some gaps to force splits of inner blocks
+    for(uint32_t id = 51; id < 80; id += 2) {
+        list.upsert(id, offsets);
+    }
+
+    auto verify = [&list]() {
+        std::vector<uint32_t> ids;
+        for(auto it = list.new_iterator(); it.valid(); it.next()) {
+            ids.push_back(it.id());
+        }
+
+        ASSERT_EQ(list.num_ids(), ids.size());
+
+        for(uint32_t id = 0; id < 205; id++) {
+            bool exists = std::binary_search(ids.begin(), ids.end(), id);
+            ASSERT_EQ(exists, list.contains(id));
+
+            if(exists) {
+                ASSERT_TRUE(list.block_of(id)->contains(id));
+            }
+
+            // `skip_to` jumps straight to the block of the target ID
+            auto it = list.new_iterator();
+            it.skip_to(id);
+            auto expected_it = std::lower_bound(ids.begin(), ids.end(), id);
+
+            if(expected_it == ids.end()) {
+                ASSERT_FALSE(it.valid());
+            } else {
+                ASSERT_TRUE(it.valid());
+                ASSERT_EQ(*expected_it, it.id());
+            }
+        }
+    };
+
+    verify();
+
+    for(uint32_t id = 40; id < 120; id++) {
+        list.erase(id);
+    }
+
+    verify();
+
+    for(uint32_t id = 0; id < 200; id++) {
+        list.erase(id);
+    }
+
+    ASSERT_EQ(0, list.num_blocks());
+    ASSERT_FALSE(list.new_iterator().valid());
+}
+
+TEST_F(PostingListTest, IntersectionWithDenseLists) {
+    posting_list_t sparse(4);
+    posting_list_t dense1(4);
+    posting_list_t dense2(4);
+
+    for(uint32_t id = 0; id < 300; id++) {
+        if(id % 7 == 0) {
+            sparse.upsert(id, {id});
+        }
+
+        if(id % 3 != 0) {
+            dense1.upsert(id, {id + 1, 0});
+        }
+
+        dense2.upsert(id, {id + 2});
+    }
+
+    std::vector<uint32_t> expected_ids;
+    posting_list_t::intersect({&sparse, &dense1, &dense2}, expected_ids);
+
+    dense1.build_ids_bitmap();
+    dense2.build_ids_bitmap();
+    ASSERT_TRUE(dense1.is_dense());
+    ASSERT_FALSE(dense1.contains(3));
+    ASSERT_TRUE(dense1.contains(4));
+
+    std::vector<uint32_t> result_ids;
+    posting_list_t::intersect({&sparse, &dense1, &dense2}, result_ids);
+    ASSERT_EQ(expected_ids, result_ids);
+
+    // bitmap is maintained by upserts and erases
+    dense1.upsert(21, {1});
+    dense1.erase(7);
+    ASSERT_TRUE(dense1.contains(21));
+    ASSERT_FALSE(dense1.contains(7));
+
+    std::vector<posting_list_t::iterator_t> its;
+    its.push_back(sparse.new_iterator());
+    its.push_back(dense1.new_iterator());
+
+    posting_list_t::result_iter_state_t iter_state;
+    result_ids.clear();
+
+    posting_list_t::block_intersect(its, iter_state, [&](uint32_t id, auto& its, size_t index) {
+        // dense iterators are positioned on the ID, so that offsets can be read
+        ASSERT_TRUE(its[1].valid());
+        ASSERT_EQ(id, its[1].id());
+        result_ids.push_back(id);
+    });
+
+    expected_ids.clear();
+    for(uint32_t id = 0; id < 300; id += 7) {
+        if((id % 3 != 0 && id != 7) || id == 21) {
+            expected_ids.push_back(id);
+        }
+    }
+
+    ASSERT_EQ(expected_ids, result_ids);
+
+    dense1.clear_ids_bitmap();
+    ASSERT_FALSE(dense1.is_dense());
+    ASSERT_TRUE(dense1.contains(21));
+}
+
 TEST_F(PostingListTest, PostingListContainsAtleastOne) {
     // when posting list is larger than target IDs
     posting_list_t p1(100);
@@ -1431,6 +1640,121 @@ TEST_F(PostingListTest, PostingListMustHaveAtleast1Element) {
     }
 }
 
+TEST_F(PostingListTest, AppendSortedMatchesUpserts) {
+    // ID `i` has `i % 3 + 1` offsets
+    auto get_offsets = [](uint32_t id) {
+        std::vector<uint32_t> offsets;
+        for(size_t j = 0; j <= id % 3; j++) {
+            offsets.push_back(id * 10 + j);
+        }
+        return offsets;
+    };
+
+    posting_list_t upserted(5), appended(5);
+
+    // a partially filled last block is topped up before new blocks are added
+    for(uint32_t id = 0; id < 3; id++) {
+        upserted.upsert(id * 2, get_offsets(id * 2));
+        appended.upsert(id * 2, get_offsets(id * 2));
+    }
+
+    std::vector<uint32_t> ids, offset_index, offsets;
+    for(uint32_t id = 10; id < 33; id++) {
+        upserted.upsert(id, get_offsets(id));
+
+        ids.push_back(id);
+        offset_index.push_back(offsets.size());
+        for(uint32_t offset: get_offsets(id)) {
+            offsets.push_back(offset);
+        }
+    }
+
+    appended.append_sorted(&ids[0], &offset_index[0], ids.size(), &offsets[0], offsets.size());
+
+    ASSERT_EQ(upserted.num_ids(), appended.num_ids());
+    ASSERT_EQ(upserted.num_blocks(), appended.num_blocks());
+    ASSERT_EQ(upserted.last_id(), appended.last_id());
+
+    posting_list_t::block_t* upserted_block = upserted.get_root();
+    posting_list_t::block_t* appended_block = appended.get_root();
+
+    while(upserted_block != nullptr) {
+        ASSERT_NE(nullptr, appended_block);
+        ASSERT_EQ(upserted_block->size(), appended_block->size());
+        ASSERT_EQ(upserted_block->offsets.getLength(), appended_block->offsets.getLength());
+
+        for(size_t i = 0; i < upserted_block->size(); i++) {
+            ASSERT_EQ(upserted_block->ids.at(i), appended_block->ids.at(i));
+            ASSERT_EQ(upserted_block->offset_index.at(i), appended_block->offset_index.at(i));
+        }
+
+        for(size_t i = 0; i < upserted_block->offsets.getLength(); i++) {
+            ASSERT_EQ(upserted_block->offsets.at(i), appended_block->offsets.at(i));
+        }
+
+        upserted_block = upserted_block->next;
+        appended_block = appended_block->next;
+    }
+
+    ASSERT_EQ(nullptr, appended_block);
+
+    // appended blocks take further upserts and erases like any other block
+    appended.upsert(11, {1, 2, 3, 4});
+    appended.erase(20);
+    appended.upsert(40, {1});
+
+    ASSERT_TRUE(appended.contains(11));
+    ASSERT_FALSE(appended.contains(20));
+    ASSERT_TRUE(appended.contains(40));
+    ASSERT_EQ(upserted.num_ids(), appended.num_ids());
+}
+
+TEST_F(PostingListTest, CompactPostingListAppendSorted) {
+    uint32_t ids[] = {0, 1};
+    uint32_t offset_index[] = {0, 1};
+    uint32_t offsets[] = {7, 8, 9};
+
+    compact_posting_list_t* list = compact_posting_list_t::create(2, ids, offset_index, 3, offsets);
+    void* obj = SET_COMPACT_POSTING(list);
+
+    // stays compact while the appended IDs fit
+    uint32_t more_ids[] = {4, 6};
+    uint32_t more_offset_index[] = {0, 2};
+    uint32_t more_offsets[] = {1, 2, 3};
+    posting_t::append_sorted(obj, more_ids, more_offset_index, 2, more_offsets, 3);
+
+    ASSERT_TRUE(IS_COMPACT_POSTING(obj));
+    ASSERT_EQ(4, posting_t::num_ids(obj));
+    ASSERT_EQ(6, posting_t::last_id(obj));
+    ASSERT_TRUE(posting_t::contains(obj, 4));
+
+    // and is expanded into a full list otherwise
+    std::vector<uint32_t> bulk_ids, bulk_offset_index, bulk_offsets;
+    for(uint32_t id = 10; id < 1010; id++) {
+        bulk_ids.push_back(id);
+        bulk_offset_index.push_back(bulk_offsets.size());
+        bulk_offsets.push_back(id % 7);
+    }
+
+    posting_t::append_sorted(obj, &bulk_ids[0], &bulk_offset_index[0], bulk_ids.size(),
+                             &bulk_offsets[0], bulk_offsets.size());
+
+    ASSERT_FALSE(IS_COMPACT_POSTING(obj));
+    ASSERT_EQ(1004, posting_t::num_ids(obj));
+    ASSERT_EQ(1009, posting_t::last_id(obj));
+    ASSERT_TRUE(posting_t::contains(obj, 6));
+    ASSERT_TRUE(posting_t::contains(obj, 500));
+    ASSERT_FALSE(posting_t::contains(obj, 2));
+
+    std::vector<uint32_t> result_ids;
+    posting_t::merge({obj}, result_ids);
+    ASSERT_EQ(1004, result_ids.size());
+    ASSERT_EQ(6, result_ids[3]);
+    ASSERT_EQ(10, result_ids[4]);
+
+    posting_t::destroy_list(obj);
+}
+
 TEST_F(PostingListTest, DISABLED_RandInsertAndErase) {
     std::vector<uint32_t> offsets = {0, 1, 3};
     posting_list_t pl(5);
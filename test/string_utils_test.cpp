@@ -282,3 +282,22 @@ TEST(StringUtilsTest, ShouldTrimCurlySpaces) {
     ASSERT_EQ("{}", StringUtils::trim_curly_spaces("{ }"));
     ASSERT_EQ("foo {bar} {baz}", StringUtils::trim_curly_spaces("foo { bar } {  baz}"));
 }
+
+TEST(StringUtilsTest, ShouldDetectCompleteJSONObject) {
+    ASSERT_TRUE(StringUtils::is_complete_json_object(R"({"id": "1", "title": "foo"})"));
+    ASSERT_TRUE(StringUtils::is_complete_json_object(R"(  {"tags": ["a", "b"], "meta": {"x": [1, {}]}}  )"));
+    ASSERT_TRUE(StringUtils::is_complete_json_object(R"({"title": "braces } and ] in \"strings\" {"})"));
+    ASSERT_TRUE(StringUtils::is_complete_json_object("{}"));
+
+    // truncated records
+    ASSERT_FALSE(StringUtils::is_complete_json_object(R"({"id": "1", "title": "fo)"));
+    ASSERT_FALSE(StringUtils::is_complete_json_object(R"({"title": "ends with brace }")"));
+    ASSERT_FALSE(StringUtils::is_complete_json_object(R"({"title": "escaped quote \"}")"));
+    ASSERT_FALSE(StringUtils::is_complete_json_object(R"({"meta": {"x": 1})"));
+    ASSERT_FALSE(StringUtils::is_complete_json_object(R"({"id": "1"}, {"id": "2"})"));
+
+    ASSERT_FALSE(StringUtils::is_complete_json_object(""));
+    ASSERT_FALSE(StringUtils::is_complete_json_object("   "));
+    ASSERT_FALSE(StringUtils::is_complete_json_object("[1, 2]"));
+    ASSERT_FALSE(StringUtils::is_complete_json_object("}{"));
+}
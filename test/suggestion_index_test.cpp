@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include "suggestion_index.h"
+
+TEST(SuggestionIndexTest, RanksCompletionsByWeight) {
+    suggestion_index_t index;
+    index.add("the lord of the rings", 10);
+    index.add("the last samurai", 4);
+    index.add("the lion king", 7);
+    index.add("toy story", 20);
+    index.add("the", 1);
+
+    std::vector<suggestion_t> suggestions;
+    index.suggest("the l", 0, 10, suggestions);
+
+    ASSERT_EQ(3, suggestions.size());
+    ASSERT_EQ("the lord of the rings", suggestions[0].text);
+    ASSERT_EQ(10, suggestions[0].weight);
+    ASSERT_EQ("the lion king", suggestions[1].text);
+    ASSERT_EQ("the last samurai", suggestions[2].text);
+
+    suggestions.clear();
+    index.suggest("t", 0, 2, suggestions);
+    ASSERT_EQ(2, suggestions.size());
+    ASSERT_EQ("toy story", suggestions[0].text);
+    ASSERT_EQ("the lord of the rings", suggestions[1].text);
+
+    suggestions.clear();
+    index.suggest("", 0, 10, suggestions);
+    ASSERT_EQ(5, suggestions.size());
+
+    suggestions.clear();
+    index.suggest("x", 0, 10, suggestions);
+    ASSERT_EQ(0, suggestions.size());
+
+    // weights drop out as phrases are removed
+    index.add("the lord of the rings", -10);
+    suggestions.clear();
+    index.suggest("the l", 0, 10, suggestions);
+    ASSERT_EQ(2, suggestions.size());
+    ASSERT_EQ("the lion king", suggestions[0].text);
+}
+
+TEST(SuggestionIndexTest, TyposAreRankedAfterExactPrefixes) {
+    suggestion_index_t index;
+    index.add("apple", 5);
+    index.add("apply", 2);
+    index.add("ample", 50);
+    index.add("maple", 3);
+
+    std::vector<suggestion_t> suggestions;
+    index.suggest("appl", 1, 10, suggestions);
+
+    ASSERT_EQ(3, suggestions.size());
+    ASSERT_EQ("apple", suggestions[0].text);
+    ASSERT_EQ(0, suggestions[0].num_typos);
+    ASSERT_EQ("apply", suggestions[1].text);
+    ASSERT_EQ(0, suggestions[1].num_typos);
+    ASSERT_EQ("ample", suggestions[2].text);
+    ASSERT_EQ(1, suggestions[2].num_typos);
+
+    ASSERT_EQ(0, suggestion_index_t::prefix_edit_distance("appl", "apple", 2));
+    ASSERT_EQ(1, suggestion_index_t::prefix_edit_distance("apl", "apple", 2));
+    ASSERT_GT(suggestion_index_t::prefix_edit_distance("xyz", "apple", 2), 2);
+}
+
+TEST(SuggestionIndexTest, PendingChangesAreMergedIntoTheTrie) {
+    suggestion_index_t index;
+
+    // enough phrases to force rebuilds of the trie along the way
+    for(size_t i = 0; i < 5000; i++) {
+        index.add("phrase " + std::to_string(i), int64_t(i % 100) + 1);
+    }
+
+    ASSERT_GT(index.size(), 0);
+
+    std::vector<suggestion_t> suggestions;
+    index.suggest("phrase 99", 0, 3, suggestions);
+
+    ASSERT_EQ(3, suggestions.size());
+    ASSERT_EQ(100, suggestions[0].weight);
+    ASSERT_EQ(100, suggestions[1].weight);
+    ASSERT_EQ(99, suggestions[2].weight);
+
+    // a heavy phrase that is still pending must outrank the phrases of the trie, and a phrase of the trie
+    // whose weight dropped must not be suggested
+    index.add("phrase 99 new", 1000);
+    index.add("phrase 99", -100);
+
+    suggestions.clear();
+    index.suggest("phrase 99", 0, 3, suggestions);
+
+    ASSERT_EQ(3, suggestions.size());
+    ASSERT_EQ("phrase 99 new", suggestions[0].text);
+    ASSERT_EQ(1000, suggestions[0].weight);
+
+    for(const auto& suggestion: suggestions) {
+        ASSERT_NE("phrase 99", suggestion.text);
+    }
+}
@@ -325,3 +325,76 @@ TEST(TokenizerTest, ShouldTokenizeLocaleTextWithEnglishText) {
     ASSERT_EQ("discrete", ttokens[7]);
     ASSERT_EQ("math", ttokens[8]);
 }
+
+TEST(TokenizerTest, ShouldTokenizeAfterReset) {
+    // long enough for the ascii check to cover whole blocks, with a multi-byte character past the first block
+    const std::vector<std::string> values = {
+        "The Quick Brown-Fox, jumped over the LAZY dog!",
+        "Mise à jour of the pretty long values",
+        "",
+        "south africa",
+        "-some and.more"
+    };
+
+    std::vector<char> symbols = {'-'};
+    std::vector<char> separators = {'.'};
+    Tokenizer tokenizer(values[0], true, false, "", symbols, separators);
+
+    for(size_t i = 0; i < values.size(); i++) {
+        if(i != 0) {
+            tokenizer.reset(values[i]);
+        }
+
+        std::vector<std::string> tokens;
+        std::vector<size_t> token_indices, start_indices, end_indices;
+        std::string token;
+        size_t token_index, start_index, end_index;
+
+        while(tokenizer.next(token, token_index, start_index, end_index)) {
+            tokens.push_back(token);
+            token_indices.push_back(token_index);
+            start_indices.push_back(start_index);
+            end_indices.push_back(end_index);
+        }
+
+        Tokenizer fresh_tokenizer(values[i], true, false, "", symbols, separators);
+        size_t num_tokens = 0;
+
+        while(fresh_tokenizer.next(token, token_index, start_index, end_index)) {
+            ASSERT_LT(num_tokens, tokens.size());
+            ASSERT_EQ(token, tokens[num_tokens]);
+            ASSERT_EQ(token_index, token_indices[num_tokens]);
+            ASSERT_EQ(start_index, start_indices[num_tokens]);
+            ASSERT_EQ(end_index, end_indices[num_tokens]);
+            num_tokens++;
+        }
+
+        ASSERT_EQ(num_tokens, tokens.size());
+    }
+
+    std::vector<std::string> tokens;
+    tokenizer.reset(values[0]);
+    tokenizer.tokenize(tokens);
+    ASSERT_EQ(8, tokens.size());
+    ASSERT_EQ("the", tokens[0]);
+    ASSERT_EQ("brown-fox", tokens[2]);
+    ASSERT_EQ("lazy", tokens[6]);
+    ASSERT_EQ("dog", tokens[7]);
+
+    tokens.clear();
+    tokenizer.reset(values[4]);
+    tokenizer.tokenize(tokens);
+    ASSERT_EQ(3, tokens.size());
+    ASSERT_EQ("-some", tokens[0]);
+    ASSERT_EQ("and", tokens[1]);
+    ASSERT_EQ("more", tokens[2]);
+
+    // locale specific tokenizers are reset too
+    tokens.clear();
+    const std::string traditional = "說";
+    Tokenizer zh_tokenizer("語", false, false, "zh");
+    zh_tokenizer.reset(traditional);
+    zh_tokenizer.tokenize(tokens);
+    ASSERT_EQ(1, tokens.size());
+    ASSERT_EQ("说", tokens[0]);
+}
@@ -162,4 +162,47 @@ TEST(TopsterTest, DistinctIntValues) {
             EXPECT_EQ(9, dist_topster.group_kv_map[dist_topster.getDistinctKeyAt(i)]->getKV(1)->scores[0]);
         }
     }
-}
\ No newline at end of file
+}
+
+TEST(TopsterTest, FilterBatchAgainstThreshold) {
+    int64_t scores0[6] = {10, 12, 12, 12, 9, 15};
+    int64_t scores1[6] = { 5,  4,  5,  5, 9,  0};
+    int64_t scores2[6] = { 1,  9,  2,  3, 9,  0};
+
+    int64_t threshold[3] = {12, 5, 3};
+    uint32_t survivors[6];
+
+    size_t num_survivors = Topster::filter_batch(scores0, scores1, scores2, 6, threshold, survivors);
+    ASSERT_EQ(2, num_survivors);
+    ASSERT_EQ(3, survivors[0]);
+    ASSERT_EQ(5, survivors[1]);
+
+    // shared threshold only ever rises
+    topster_threshold_t shared_threshold;
+    int64_t local_threshold[3] = {1, 1, 1};
+    ASSERT_TRUE(shared_threshold.merge_into(local_threshold, true));
+    ASSERT_FALSE(shared_threshold.merge_into(local_threshold, false));
+    ASSERT_EQ(1, local_threshold[0]);
+
+    int64_t min_scores_a[3] = {12, 5, 3};
+    int64_t min_scores_b[3] = {12, 4, 100};
+    shared_threshold.publish(min_scores_a);
+    shared_threshold.publish(min_scores_b);
+
+    ASSERT_TRUE(shared_threshold.merge_into(local_threshold, true));
+    ASSERT_EQ(12, local_threshold[0]);
+    ASSERT_EQ(5, local_threshold[1]);
+    ASSERT_EQ(3, local_threshold[2]);
+
+    Topster topster(2);
+    ASSERT_FALSE(topster.is_full());
+
+    for(uint64_t key = 0; key < 3; key++) {
+        int64_t scores[3] = {int64_t(key), 0, 0};
+        KV kv(0, 0, 0, key, key, 0, scores);
+        topster.add(&kv);
+    }
+
+    ASSERT_TRUE(topster.is_full());
+    ASSERT_EQ(1, topster.min_scores()[0]);
+}